@@ -7,6 +7,7 @@
  **************************/
 
 #include <SimRacingController.h>
+#include <GestureEngine.h>
 
 // Pin configurations
 #ifdef ARDUINO_ARCH_ESP32
@@ -64,6 +65,20 @@ const char* profileNames[] = {
 // Create controller instance
 SimRacingController controller;
 
+// Gestures: button combinations and encoder button long presses
+GestureEngine gestures;
+const GestureInput matrixCombo[2] = {
+    GestureInput(SOURCE_MATRIX, 0 * MATRIX_COLS + 0),   // [0][0]
+    GestureInput(SOURCE_MATRIX, 0 * MATRIX_COLS + 1)    // [0][1]
+};
+const GestureInput gpioCombo[2] = {
+    GestureInput(SOURCE_GPIO, 0),
+    GestureInput(SOURCE_GPIO, 1)
+};
+int matrixComboId;
+int gpioComboId;
+int longPressIds[NUM_ENCODERS];
+
 // Error callback
 bool onError(const ControllerError& error) {
     Serial.print("Error: ");
@@ -83,11 +98,6 @@ void onMatrixChange(int profile, int row, int col, bool state) {
     Serial.print(col);
     Serial.print("] ");
     Serial.println(state ? "PRESSED" : "RELEASED");
-
-    // Example: check for button combinations
-    if(state && controller.getMatrixState(0, 0)) {
-        Serial.println("Button combination detected!");
-    }
 }
 
 // GPIO button callback
@@ -98,11 +108,6 @@ void onGpioChange(int profile, int gpio, bool state) {
     Serial.print(gpio);
     Serial.print(" ");
     Serial.println(state ? "PRESSED" : "RELEASED");
-
-    // Example: GPIO combination detection
-    if(state && controller.getGpioState(1)) {
-        Serial.println("GPIO combination detected!");
-    }
 }
 
 // MCP23017 callback
@@ -142,22 +147,27 @@ void onEncoderChange(int profile, int encoder, int direction) {
 
 // Encoder button callback
 void onEncoderButtonChange(int profile, int encoder, bool state) {
-    static unsigned long pressTime = 0;
-    
     Serial.print("Profile: ");
     Serial.print(profileNames[profile]);
     Serial.print(" - Encoder ");
     Serial.print(encoder);
     Serial.print(" Button ");
     Serial.println(state ? "PRESSED" : "RELEASED");
+}
+
+// Gesture callback
+void onGesture(int profile, int gesture, GestureType type, uint16_t repeat) {
+    if (gesture == matrixComboId) {
+        Serial.println("Button combination detected!");
+    } else if (gesture == gpioComboId) {
+        Serial.println("GPIO combination detected!");
+    }
 
-    // Example: long press detection
-    if(state) {
-        pressTime = millis();
-    } else {
-        if(millis() - pressTime > 1000) {
+    // Example: long press resets the encoder position
+    for (int i = 0; i < NUM_ENCODERS; i++) {
+        if (gesture == longPressIds[i]) {
             Serial.println("Long press detected!");
-            controller.setEncoderPosition(encoder, 0);
+            controller.setEncoderPosition(i, 0);
         }
     }
 }
@@ -189,6 +199,15 @@ void setup() {
     controller.setMcpCallback(onMcpChange);
     controller.setEncoderCallback(onEncoderChange);
     controller.setEncoderButtonCallback(onEncoderButtonChange);
+
+    // Configure gestures
+    matrixComboId = gestures.addChord(matrixCombo, 2);
+    gpioComboId = gestures.addChord(gpioCombo, 2);
+    for (int i = 0; i < NUM_ENCODERS; i++) {
+        longPressIds[i] = gestures.addLongPress(GestureInput(SOURCE_ENCODER_BUTTON, i), 1000);
+    }
+    gestures.setCallback(onGesture);
+    controller.setGestureEngine(&gestures);
     
     // Initialize controller
     if (!controller.begin()) {
@@ -0,0 +1,376 @@
+/**************************
+ * SimRacingController
+ * Benchmark Example
+ * v 2.1.0
+ * by roncoa@gmail.com
+ * 29/01/2025
+ **************************/
+
+// Measures the scan cost for the shipped example layouts and for stress
+// layouts. Inputs are synthesized and pushed through processFrame(), so
+// nothing has to be connected. Pin and I2C traffic of tryUpdate() is
+// added from a cost model calibrated on this board at startup.
+//
+// Output: one JSON object per layout, e.g.
+// {"layout":"Basic","inputs":45,"encoders":2,"scans":2000,"idle_ns":...}
+//   idle_ns        processing per scan with no input changing
+//   active_ns      processing per scan with buttons and encoders moving
+//   max_us         longest scan
+//   io_model_ns    modelled pin/I2C time per scan (encoders: one read per
+//                  port register where the core supports port reads)
+//   callbacks_per_s callbacks at a 1 kHz scan rate in the active phase
+//   heap_delta     heap bytes lost during the scans (must be 0)
+//
+// Then one JSON object per encoder count for tryUpdate() on real pins
+// (encoders only, pins resting high with pull-ups, port grouping as set
+// up by begin()), e.g.
+// {"layout":"Update_Encoders8","encoders":8,"port_reads":2,"calls":2000,...}
+//   port_reads     input registers read per sample (0 = digitalRead())
+//   update_ns      tryUpdate() per call, encoders sampled on every call
+//                  (fastest of UPDATE_ROUNDS rounds of `calls` calls)
+//   base_ns        tryUpdate() per call, encoders sampled once a second
+//   encoder_ns     encoder phase per sample (update_ns - base_ns)
+
+#include <SimRacingController.h>
+
+#define BENCH_SCANS       2000      // Scans per phase
+#define I2C_CLOCK_HZ      400000    // Bus clock of begin()
+#define MCP_READ_BYTES    5         // Address + register, address + 2 data bytes
+#define MATRIX_SETTLE_US  10        // Row settle delay in tryUpdate()
+#define CALIBRATION_PIN   2         // Any digital pin
+#define SKIP_ENCODER_HZ   1         // Encoder rate of the base_ns run
+#define UPDATE_ROUNDS     3         // tryUpdate() rounds, the fastest counts
+
+struct Layout {
+    const char* name;
+    uint8_t rows;
+    uint8_t cols;
+    uint8_t gpio;
+    uint8_t mcp;
+    uint8_t encoders;
+    bool encoderButtons;
+};
+
+const Layout layouts[] = {
+#ifdef ARDUINO_ARCH_ESP32
+    {"Basic",            3, 3, 2, 2, 2, true},
+    {"Advanced",         4, 4, 2, 2, 3, true},
+    {"ButtonBox_ACC",    4, 5, 0, 0, 5, false},
+#else
+    {"Basic",            3, 3, 2, 2, 2, true},
+    {"Advanced",         3, 3, 2, 2, 2, true},
+    {"ButtonBox_ACC",    3, 5, 0, 0, 4, false},
+#endif
+    {"Stress_Matrix8x8", 8, 8, 0, 0, 0, false},
+    {"Stress_Mcp8",      0, 0, 0, 8, 0, false},
+    {"Stress_Encoders8", 0, 0, 0, 0, 8, true},
+
+    // Idle cost against input count (should stay nearly flat)
+    {"Scale_20",         4, 5, 0, 0, 0, false},
+    {"Scale_50",         5, 10, 0, 0, 0, false},
+    {"Scale_100",        10, 10, 0, 0, 0, false},
+    {"Scale_200",        10, 20, 0, 0, 0, false},
+
+    // Idle encoder cost against encoder count (should stay nearly flat)
+    {"Scale_Encoders2",  0, 0, 0, 0, 2, false},
+    {"Scale_Encoders8",  0, 0, 0, 0, 8, false},
+    {"Scale_Encoders32", 0, 0, 0, 0, 32, false}
+};
+const uint8_t NUM_LAYOUTS = sizeof(layouts) / sizeof(layouts[0]);
+
+// Encoder counts of the tryUpdate() case
+const uint8_t updateEncoders[] = {2, 8, 32};
+
+// Free input pins for it, reused round robin (only read, pulled up)
+#ifdef ARDUINO_ARCH_ESP32
+const int benchPins[] = {4, 5, 13, 14, 16, 17, 18, 19, 21, 22, 23, 25, 26, 27, 32, 33};
+#else
+const int benchPins[] = {2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13};
+#endif
+const uint8_t NUM_BENCH_PINS = sizeof(benchPins) / sizeof(benchPins[0]);
+
+// Pin numbers are never touched by processFrame(), they only have to be valid
+int pins[64];
+McpConfig mcpConfigs[8];
+
+uint32_t callbacks = 0;
+void onMatrixChange(int, int, int, bool) { callbacks++; }
+void onGpioChange(int, int, bool) { callbacks++; }
+void onMcpChange(int, int, int, bool) { callbacks++; }
+void onEncoderChange(int, int, int) { callbacks++; }
+void onEncoderButtonChange(int, int, bool) { callbacks++; }
+
+// Calibrated costs
+uint32_t readNs;
+uint32_t writeNs;
+uint32_t i2cByteNs;
+uint32_t portReadNs;
+
+long freeHeap() {
+#if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_ESP8266)
+    return ESP.getFreeHeap();
+#elif defined(__AVR__)
+    extern char* __brkval;
+    extern char __heap_start;
+    char top;
+    return &top - (__brkval ? __brkval : &__heap_start);
+#else
+    return 0;
+#endif
+}
+
+void calibrate() {
+    pinMode(CALIBRATION_PIN, INPUT_PULLUP);
+    unsigned long start = micros();
+    for (int i = 0; i < 1000; i++) {
+        digitalRead(CALIBRATION_PIN);
+    }
+    readNs = micros() - start;  // us per 1000 calls = ns per call
+
+    pinMode(CALIBRATION_PIN, OUTPUT);
+    start = micros();
+    for (int i = 0; i < 1000; i++) {
+        digitalWrite(CALIBRATION_PIN, HIGH);
+    }
+    writeNs = micros() - start;
+    pinMode(CALIBRATION_PIN, INPUT_PULLUP);
+
+    i2cByteNs = 9UL * 1000000UL / (I2C_CLOCK_HZ / 1000UL);  // 8 data bits + ACK
+
+#if defined(ENCODER_PORT_READS)
+    PortRegister reg = portInputRegister(digitalPinToPort(CALIBRATION_PIN));
+    start = micros();
+    for (int i = 0; i < 1000; i++) {
+        (void)*reg;                 // Volatile: read every time
+    }
+    portReadNs = micros() - start;
+#endif
+}
+
+// Encoder pin reads per sample: pins[0..n-1] serve as A, B and button pins
+uint32_t encoderReads(uint8_t encoders, bool buttons) {
+#if defined(ENCODER_PORT_READS)
+    PortRegister ports[64];
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < encoders; i++) {
+        PortRegister reg = portInputRegister(digitalPinToPort(pins[i]));
+        uint8_t p = 0;
+        while (p < count && !(ports[p] == reg)) p++;
+        if (p == count) ports[count++] = reg;
+    }
+    return count;
+#else
+    return encoders * (buttons ? 3 : 2);
+#endif
+}
+
+uint32_t ioModelNs(const Layout& l) {
+    uint32_t ns = 0;
+    ns += l.rows * (2 * writeNs + MATRIX_SETTLE_US * 1000UL + l.cols * readNs);
+    ns += l.gpio * readNs;
+#if defined(ENCODER_PORT_READS)
+    ns += encoderReads(l.encoders, l.encoderButtons) * portReadNs;
+#else
+    ns += encoderReads(l.encoders, l.encoderButtons) * readNs;
+#endif
+    ns += l.mcp * MCP_READ_BYTES * i2cByteNs;
+    return ns;
+}
+
+void printField(const char* name, long value, bool last = false) {
+    Serial.print("\"");
+    Serial.print(name);
+    Serial.print("\":");
+    Serial.print(value);
+    if (!last) Serial.print(",");
+}
+
+void runLayout(const Layout& l) {
+    SimRacingController* controller = new SimRacingController();
+
+    if (l.rows) controller->setMatrix(pins, l.rows, pins, l.cols);
+    if (l.gpio) controller->setGpio(pins, l.gpio);
+    if (l.mcp) controller->setMcpDevices(mcpConfigs, l.mcp);
+    if (l.encoders) {
+        controller->setEncoders(pins, pins, l.encoderButtons ? pins : nullptr, l.encoders);
+    }
+    controller->setMatrixCallback(onMatrixChange);
+    controller->setGpioCallback(onGpioChange);
+    controller->setMcpCallback(onMcpChange);
+    controller->setEncoderCallback(onEncoderChange);
+    controller->setEncoderButtonCallback(onEncoderButtonChange);
+
+    // Idle frame: nothing pressed, encoders resting with A and B high
+    uint32_t words[32] = {0};
+    uint8_t encoderBase = l.rows + (l.gpio + 31) / 32 + l.mcp;
+    for (uint8_t i = 0; i < l.encoders; i++) {
+        words[encoderBase + i / 16] |= 3UL << ((i % 16) * 2);
+    }
+
+    unsigned long t = 0;
+    if (!controller->beginReplay(t, words)) {
+        Serial.print("{\"layout\":\"");
+        Serial.print(l.name);
+        Serial.println("\",\"error\":1}");
+        delete controller;
+        return;
+    }
+
+    long heapBefore = freeHeap();
+
+    // Idle phase
+    for (int i = 0; i < BENCH_SCANS; i++) {
+        controller->processFrame(++t, words);
+    }
+    ScanStats idle = controller->getScanStats();
+
+    // Active phase: one input of each source toggles every 100 scans,
+    // every encoder moves one quadrature state every 4 scans
+    const uint8_t sequence[4] = {3, 2, 0, 1};
+    controller->resetScanStats();
+    callbacks = 0;
+    for (int i = 0; i < BENCH_SCANS; i++) {
+        if (i % 100 == 0) {
+            for (uint8_t w = 0; w < encoderBase; w++) {
+                words[w] ^= 1;
+            }
+        }
+        if (i % 4 == 0) {
+            uint8_t state = sequence[(i / 4) % 4];
+            for (uint8_t e = 0; e < l.encoders; e++) {
+                uint32_t& word = words[encoderBase + e / 16];
+                uint8_t shift = (e % 16) * 2;
+                word = (word & ~(3UL << shift)) | ((uint32_t)state << shift);
+            }
+        }
+        controller->processFrame(++t, words);
+    }
+    ScanStats active = controller->getScanStats();
+
+    long heapAfter = freeHeap();
+
+    uint16_t inputs = l.rows * l.cols + l.gpio + l.mcp * 16 +
+                      (l.encoderButtons ? l.encoders : 0);
+
+    Serial.print("{\"layout\":\"");
+    Serial.print(l.name);
+    Serial.print("\",");
+    printField("inputs", inputs);
+    printField("encoders", l.encoders);
+    printField("scans", BENCH_SCANS);
+    printField("idle_ns", idle.totalMicros * 1000UL / idle.scans);
+    printField("active_ns", active.totalMicros * 1000UL / active.scans);
+    printField("max_us", idle.maxMicros > active.maxMicros ? idle.maxMicros : active.maxMicros);
+    printField("io_model_ns", ioModelNs(l));
+    printField("callbacks_per_s", callbacks * 1000UL / BENCH_SCANS);
+    printField("heap_delta", heapBefore - heapAfter, true);
+    Serial.println("}");
+
+    delete controller;
+}
+
+/**
+ * Input registers read per encoder sample, grouped as in begin()
+ * @return 0 if the encoders are read with digitalRead()
+ */
+uint8_t portReads(const int* pinsA, const int* pinsB, uint8_t encoders) {
+#if defined(ENCODER_PORT_READS)
+    PortRegister ports[NUM_BENCH_PINS];
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < 2 * encoders; i++) {
+        int pin = i < encoders ? pinsA[i] : pinsB[i - encoders];
+        PortRegister reg = portInputRegister(digitalPinToPort(pin));
+        uint8_t p = 0;
+        while (p < count && !(ports[p] == reg)) p++;
+        if (p == count) ports[count++] = reg;
+    }
+    return count;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Time per tryUpdate() call (ns) of an encoder-only controller
+ * Fastest of UPDATE_ROUNDS rounds, so interrupts and USB traffic hardly count.
+ * @param encoderHz Encoder sample rate, 0 = every call
+ * @return 0 if begin() failed
+ */
+uint32_t timeUpdates(const int* pinsA, const int* pinsB, uint8_t encoders, uint16_t encoderHz) {
+    SimRacingController* controller = new SimRacingController();
+    controller->setEncoders(pinsA, pinsB, encoders);
+    controller->setEncoderCallback(onEncoderChange);
+    controller->setSampleRate(SOURCE_ENCODER, encoderHz);
+
+    uint32_t ns = 0;
+    if (controller->begin()) {
+        controller->tryUpdate();        // First sample
+        for (uint8_t round = 0; round < UPDATE_ROUNDS; round++) {
+            unsigned long start = micros();
+            for (int i = 0; i < BENCH_SCANS; i++) {
+                controller->tryUpdate();
+            }
+            uint32_t roundNs = (micros() - start) * 1000UL / BENCH_SCANS;
+            if (ns == 0 || roundNs < ns) ns = roundNs;
+        }
+    }
+    delete controller;
+    return ns;
+}
+
+void runUpdates(uint8_t encoders) {
+    int pinsA[32];
+    int pinsB[32];
+    for (uint8_t i = 0; i < encoders; i++) {
+        pinsA[i] = benchPins[(2 * i) % NUM_BENCH_PINS];
+        pinsB[i] = benchPins[(2 * i + 1) % NUM_BENCH_PINS];
+    }
+
+    uint32_t updateNs = timeUpdates(pinsA, pinsB, encoders, 0);
+    uint32_t baseNs = timeUpdates(pinsA, pinsB, encoders, SKIP_ENCODER_HZ);
+
+    Serial.print("{\"layout\":\"Update_Encoders");
+    Serial.print(encoders);
+    Serial.print("\",");
+    if (!updateNs || !baseNs) {
+        printField("error", 1, true);
+        Serial.println("}");
+        return;
+    }
+    printField("encoders", encoders);
+    printField("port_reads", portReads(pinsA, pinsB, encoders));
+    printField("calls", BENCH_SCANS);
+    printField("update_ns", updateNs);
+    printField("base_ns", baseNs);
+    printField("encoder_ns", updateNs > baseNs ? updateNs - baseNs : 0, true);
+    Serial.println("}");
+}
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {}
+
+    for (int i = 0; i < 64; i++) {
+        pins[i] = i % NUM_DIGITAL_PINS;
+    }
+    for (uint8_t i = 0; i < 8; i++) {
+        mcpConfigs[i] = McpConfig(0x20 + i);
+    }
+
+    calibrate();
+    Serial.print("{\"calibration\":1,");
+    printField("read_ns", readNs);
+    printField("write_ns", writeNs);
+    printField("i2c_byte_ns", i2cByteNs, true);
+    Serial.println("}");
+
+    for (uint8_t i = 0; i < NUM_LAYOUTS; i++) {
+        runLayout(layouts[i]);
+    }
+    for (uint8_t i = 0; i < sizeof(updateEncoders); i++) {
+        runUpdates(updateEncoders[i]);
+    }
+}
+
+void loop() {
+}
@@ -5,10 +5,20 @@
  * 29/01/2025
  **************************/
 
-#include <KeySequence.h>
 #include <SimRacingController.h>
+#include <KeyMacro.h>
 #include "Sequenze.h"
 
+#ifdef ARDUINO_ARCH_ESP32
+    #include <USB.h>
+    #include <USBHIDKeyboard.h>
+    USBHIDKeyboard Keyboard;
+    typedef USBHIDKeyboard KeyboardType;
+#else
+    #include <Keyboard.h>
+    typedef Keyboard_ KeyboardType;
+#endif
+
 // Debug configuration
 #define DEBUG true
 
@@ -40,7 +50,7 @@
 #endif
 
 // Create instances
-KeySequence keys;
+KeyMacroPlayer<KeyboardType> keys(Keyboard);
 SimRacingController controller;
 
 // Error callback
@@ -59,31 +69,31 @@ void onMatrixChange(int profile, int row, int col, bool state) {
             // Row 1 - Basic Controls
             if (row == 0) {
                 switch (col) {
-                    case 0: keys.sendSequence(ACC_EngagePitLimiter); break;
-                    case 1: keys.sendSequence(ACC_CycleCarLightStages); break;
-                    case 2: keys.sendSequence(ACC_LeftDirectionalLight); break;
-                    case 3: keys.sendSequence(ACC_RightDirectionalLight); break;
-                    case 4: keys.sendSequence(ACC_CycleMultifunctionDisplay); break;
+                    case 0: keys.play(ACC_EngagePitLimiter); break;
+                    case 1: keys.play(ACC_CycleCarLightStages); break;
+                    case 2: keys.play(ACC_LeftDirectionalLight); break;
+                    case 3: keys.play(ACC_RightDirectionalLight); break;
+                    case 4: keys.play(ACC_CycleMultifunctionDisplay); break;
                 }
             }
             // Row 2 - Car Systems
             else if (row == 1) {
                 switch (col) {
-                    case 0: keys.sendSequence(ACC_Starter); break;
-                    case 1: keys.sendSequence(ACC_EnableRainLights); break;
-                    case 2: keys.sendSequence(ACC_EnableFlashingLights); break;
-                    case 3: keys.sendSequence(ACC_CycleWiper); break;
-                    case 4: keys.sendSequence(ACC_Savereplay); break;
+                    case 0: keys.play(ACC_Starter); break;
+                    case 1: keys.play(ACC_EnableRainLights); break;
+                    case 2: keys.play(ACC_EnableFlashingLights); break;
+                    case 3: keys.play(ACC_CycleWiper); break;
+                    case 4: keys.play(ACC_Savereplay); break;
                 }
             }
             // Row 3 - Additional Controls
             else if (row == 2) {
                 switch (col) {
-                    case 0: keys.sendSequence(ACC_IngitionSequence); break;
-                    case 1: keys.sendSequence(ACC_IncreaseTCC); break;
-                    case 2: keys.sendSequence(ACC_DecreaseTCC); break;
-                    case 3: keys.sendSequence(AUX2); break;
-                    case 4: keys.sendSequence(AUX1); break;
+                    case 0: keys.play(ACC_IngitionSequence); break;
+                    case 1: keys.play(ACC_IncreaseTCC); break;
+                    case 2: keys.play(ACC_DecreaseTCC); break;
+                    case 3: keys.play(AUX2); break;
+                    case 4: keys.play(AUX1); break;
                 }
             }
         } else {
@@ -97,16 +107,16 @@ void onEncoderChange(int profile, int encoder, int direction) {
     if (profile == 0) { // ACC profile
         switch (encoder) {
             case 0:  // Traction Control
-                keys.sendSequence(direction > 0 ? ACC_IncreaseTC : ACC_DecreaseTC);
+                keys.play(direction > 0 ? ACC_IncreaseTC : ACC_DecreaseTC);
                 break;
             case 1:  // ABS
-                keys.sendSequence(direction > 0 ? ACC_IncreaseABS : ACC_DecreaseABS);
+                keys.play(direction > 0 ? ACC_IncreaseABS : ACC_DecreaseABS);
                 break;
             case 2:  // Engine Map
-                keys.sendSequence(direction > 0 ? ACC_IncreaseEngineMap : ACC_DecreaseEngineMap);
+                keys.play(direction > 0 ? ACC_IncreaseEngineMap : ACC_DecreaseEngineMap);
                 break;
             case 3:  // Brake Bias
-                keys.sendSequence(direction > 0 ? ACC_IncreaseBrakeBias : ACC_DecreaseBrakeBIas);
+                keys.play(direction > 0 ? ACC_IncreaseBrakeBias : ACC_DecreaseBrakeBIas);
                 break;
         }
         keys.releaseAll();
@@ -119,11 +129,12 @@ void setup() {
         Serial.println("SimRacing ButtonBox ACC v2.2.0");
     }
 
-    // Initialize KeySequence
-    keys.setDebug(DEBUG);
-    keys.begin();
-    keys.setAutoRelease(false);
-    keys.setDefaultDelay(150);
+    // Initialize keyboard
+    Keyboard.begin();
+#ifdef ARDUINO_ARCH_ESP32
+    USB.begin();
+#endif
+    keys.setKeyDelay(150);
 
     // Configure controller
     controller.setMatrix(rowPins, MATRIX_ROWS, colPins, MATRIX_COLS);
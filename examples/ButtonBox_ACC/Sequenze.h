@@ -1,49 +1,53 @@
 #ifndef SEQUENZE_H
 #define SEQUENZE_H
 
-#define ACC_IncreaseTC "{SHIFT}t"
-#define ACC_DecreaseTC "{CTRL}t"
-#define ACC_IncreaseTCC "{SHIFT}y"
-#define ACC_DecreaseTCC "{CTRL}y"
-#define ACC_IncreaseABS "{SHIFT}a"
-#define ACC_DecreaseABS "{CTRL}a"
-#define ACC_IncreaseEngineMap "{SHIFT}e"
-#define ACC_DecreaseEngineMap "{CTRL}e"
-#define ACC_IncreaseBrakeBias "{SHIFT}b"
-#define ACC_DecreaseBrakeBIas "{CTRL}b"
+#include <KeyMacro.h>
 
-#define ACC_IngitionSequence "{SHIFT}i"
-#define ACC_Starter "s"
+// Sequences are compiled to key codes at build time (see KeyMacro.h)
 
-#define ACC_EngagePitLimiter "{ALT}l"
+KEY_MACRO(ACC_IncreaseTC, "{SHIFT}t");
+KEY_MACRO(ACC_DecreaseTC, "{CTRL}t");
+KEY_MACRO(ACC_IncreaseTCC, "{SHIFT}y");
+KEY_MACRO(ACC_DecreaseTCC, "{CTRL}y");
+KEY_MACRO(ACC_IncreaseABS, "{SHIFT}a");
+KEY_MACRO(ACC_DecreaseABS, "{CTRL}a");
+KEY_MACRO(ACC_IncreaseEngineMap, "{SHIFT}e");
+KEY_MACRO(ACC_DecreaseEngineMap, "{CTRL}e");
+KEY_MACRO(ACC_IncreaseBrakeBias, "{SHIFT}b");
+KEY_MACRO(ACC_DecreaseBrakeBIas, "{CTRL}b");
 
-#define ACC_EnableRainLights "{CTRL}l"
-#define ACC_CycleCarLightStages "l"
+KEY_MACRO(ACC_IngitionSequence, "{SHIFT}i");
+KEY_MACRO(ACC_Starter, "s");
 
-#define ACC_EnableFlashingLights "{SHIFT}l"
-#define ACC_LeftDirectionalLight "{ALT}{LEFT}"
-#define ACC_RightDirectionalLight "{ALT}{RIGHT}"
-#define ACC_CycleWiper "{ALT}r"
+KEY_MACRO(ACC_EngagePitLimiter, "{ALT}l");
 
-#define ACC_DisplayPageUp "{SHIFT}d"
-#define ACC_DisplayPageDown "{CTRL}d"
-#define ACC_CycleRacelogic "{ALT}d"       //piccolo display racelogic
+KEY_MACRO(ACC_EnableRainLights, "{CTRL}l");
+KEY_MACRO(ACC_CycleCarLightStages, "l");
 
-#define ACC_Savereplay "m"
+KEY_MACRO(ACC_EnableFlashingLights, "{SHIFT}l");
+KEY_MACRO(ACC_LeftDirectionalLight, "{ALT}{LEFT}");
+KEY_MACRO(ACC_RightDirectionalLight, "{ALT}{RIGHT}");
+KEY_MACRO(ACC_CycleWiper, "{ALT}r");
+
+KEY_MACRO(ACC_DisplayPageUp, "{SHIFT}d");
+KEY_MACRO(ACC_DisplayPageDown, "{CTRL}d");
+KEY_MACRO(ACC_CycleRacelogic, "{ALT}d");       //piccolo display racelogic
+
+KEY_MACRO(ACC_Savereplay, "m");
 
 // Multi Function Display (shows up in the bottom left of the screen)
-#define ACC_CycleMultifunctionDisplay "{INS}"
-#define ACC_MFD_UP "{UP}"
-#define ACC_MFD_DOWN "{DOWN}"
-#define ACC_MFD_LEFT "{LEFT}"
-#define ACC_MFD_RIGHT "{RIGHT}"
+KEY_MACRO(ACC_CycleMultifunctionDisplay, "{INS}");
+KEY_MACRO(ACC_MFD_UP, "{UP}");
+KEY_MACRO(ACC_MFD_DOWN, "{DOWN}");
+KEY_MACRO(ACC_MFD_LEFT, "{LEFT}");
+KEY_MACRO(ACC_MFD_RIGHT, "{RIGHT}");
 
 
 
-#define AUX1 "PRTSIM{ENTER}"
-#define AUX2 "unduetrestella{ENTER}"
-#define AUX3 ""
-#define AUX4 ""
-#define AUX5 ""
+KEY_MACRO(AUX1, "PRTSIM{ENTER}");
+KEY_MACRO(AUX2, "unduetrestella{ENTER}");
+KEY_MACRO(AUX3, "");
+KEY_MACRO(AUX4, "");
+KEY_MACRO(AUX5, "");
 
 #endif
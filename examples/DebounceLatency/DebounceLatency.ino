@@ -0,0 +1,240 @@
+/**************************
+ * SimRacingController
+ * Debounce Latency Example
+ * v 2.1.0
+ * by roncoa@gmail.com
+ * 29/01/2025
+ **************************/
+
+// End-to-end latency and edge accuracy of the debounce and encoder
+// decoder, measured with synthetic switches (SwitchModel.h): contact
+// bounce, glitch pulses, EMI spikes and quadrature phase jitter.
+// The models drive the controller through processFrame() on a virtual
+// clock, so results are exact and no hardware is needed.
+//
+// Output: one JSON object per case, then {"result":"PASS"} or "FAIL".
+// Regression gate: on bounce-only models the worst press-to-callback
+// latency must stay within debounce + bounce + 2 scan periods (deferred)
+// or bounce + 2 scan periods (eager), with no false or missed edges.
+
+#include <SimRacingController.h>
+#include "SwitchModel.h"
+
+#define SCAN_PERIOD_US    1000      // Virtual scan period
+#define PRESS_CYCLES      32        // Press/release cycles per case
+#define HOLD_US           150000UL  // Press and release duration
+#define ENCODER_DETENTS   24        // Detents per encoder case
+
+const SwitchModel switchModels[] = {
+    // name           bounce  chatter glitch every   spike every
+    {"clean",             0,    1,      0,     0,      0,    0},
+    {"bounce_1ms",     1000,   50,      0,     0,      0,    0},
+    {"bounce_5ms",     5000,  100,      0,     0,      0,    0},
+    {"worn_15ms",     15000,  300,      0,     0,      0,    0},
+    {"glitch",         1000,   50,    200, 20000,      0,    0},
+    {"emi",            1000,   50,      0,     0,     50, 7000}
+};
+
+const EncoderModel encoderModels[] = {
+    // name           step   jitter bounce chatter
+    {"slow_clean",     5000,     0,     0,    1},
+    {"slow_bouncy",    5000,   500,   300,   40},
+    {"fast_clean",     1000,     0,     0,    1},
+    {"fast_jitter",    1000,   300,   100,   20}
+};
+
+const unsigned long debounceSettings[] = {5, 10, 20, 50};   // ms
+const DebounceMode debounceModes[] = {DEBOUNCE_DEFERRED, DEBOUNCE_EAGER, DEBOUNCE_EAGER_PRESS};
+const char* modeNames[] = {"deferred", "eager", "eager_press"};
+const unsigned long encoderSettings[] = {0, 1, 5};          // ms
+
+// Test inputs: one GPIO button and one encoder
+const int gpioPins[1] = {2};
+const int encoderPinsA[1] = {3};
+const int encoderPinsB[1] = {4};
+
+// Frame layout for this configuration: GPIO word, encoder A/B word, button word
+#define GPIO_WORD     0
+#define ENCODER_WORD  1
+
+SimRacingController controller;
+
+// Measurement state
+uint32_t scanUs;
+bool idealLevel;
+uint32_t edgeUs;
+bool edgeReported;
+uint32_t latencies[PRESS_CYCLES];
+uint8_t numLatencies;
+uint16_t falseEdges;
+uint16_t missedEdges;
+int32_t encoderSteps;
+uint16_t wrongSteps;
+bool allPassed = true;
+
+void onGpioChange(int profile, int gpio, bool state) {
+    if (state == idealLevel && !edgeReported) {
+        edgeReported = true;
+        if (state && numLatencies < PRESS_CYCLES) {
+            latencies[numLatencies++] = scanUs - edgeUs;
+        }
+    } else {
+        falseEdges++;
+    }
+}
+
+void onEncoderChange(int profile, int encoder, int direction) {
+    if (direction > 0) encoderSteps++;
+    else wrongSteps++;
+}
+
+bool beginCase(unsigned long debounceMs, unsigned long encoderMs, DebounceMode mode) {
+    uint32_t words[3] = {0, 3, 0};
+    controller.setDebounceTime(debounceMs, encoderMs);
+    controller.setDebounceMode(SOURCE_GPIO, mode);
+    scanUs = 0;
+    return controller.beginReplay(0, words);
+}
+
+void printField(const char* name, long value, bool last = false) {
+    Serial.print("\"");
+    Serial.print(name);
+    Serial.print("\":");
+    Serial.print(value);
+    if (!last) Serial.print(",");
+}
+
+void sortLatencies() {
+    for (uint8_t i = 1; i < numLatencies; i++) {
+        uint32_t v = latencies[i];
+        uint8_t j = i;
+        while (j > 0 && latencies[j - 1] > v) {
+            latencies[j] = latencies[j - 1];
+            j--;
+        }
+        latencies[j] = v;
+    }
+}
+
+void runSwitchCase(const SwitchModel& m, unsigned long debounceMs, DebounceMode mode) {
+    if (!beginCase(debounceMs, 5, mode)) return;
+
+    idealLevel = false;
+    edgeUs = 0;
+    edgeReported = true;
+    numLatencies = 0;
+    falseEdges = 0;
+    missedEdges = 0;
+
+    uint32_t words[3] = {0, 3, 0};
+    uint32_t edgeId = 0;
+    uint32_t endUs = 2 * HOLD_US * PRESS_CYCLES + HOLD_US;
+
+    for (scanUs = SCAN_PERIOD_US; scanUs < endUs; scanUs += SCAN_PERIOD_US) {
+        // Ideal edges every HOLD_US
+        bool ideal = ((scanUs / HOLD_US) % 2) == 1 && scanUs < 2 * HOLD_US * PRESS_CYCLES;
+        if (ideal != idealLevel) {
+            if (!edgeReported) missedEdges++;
+            idealLevel = ideal;
+            edgeUs = (scanUs / HOLD_US) * HOLD_US;
+            edgeReported = false;
+            edgeId++;
+        }
+
+        bool level = switchLevel(m, scanUs, idealLevel, edgeUs, edgeId);
+        words[GPIO_WORD] = level ? 1 : 0;
+        controller.processFrame(scanUs / 1000, words);
+    }
+    if (!edgeReported) missedEdges++;
+
+    sortLatencies();
+    uint32_t sum = 0;
+    for (uint8_t i = 0; i < numLatencies; i++) sum += latencies[i];
+    uint32_t maxLatency = numLatencies ? latencies[numLatencies - 1] : 0;
+
+    // Regression gate on bounce-only models
+    bool gated = m.glitchUs == 0 && m.spikeUs == 0 && m.bounceUs < debounceMs * 1000UL;
+    uint32_t bound = m.bounceUs + 2 * SCAN_PERIOD_US;
+    if (mode == DEBOUNCE_DEFERRED) {
+        bound += debounceMs * 1000UL;
+    }
+    bool pass = !gated || (maxLatency <= bound && falseEdges == 0 && missedEdges == 0);
+    if (!pass) allPassed = false;
+
+    Serial.print("{\"switch\":\"");
+    Serial.print(m.name);
+    Serial.print("\",");
+    Serial.print("\"mode\":\"");
+    Serial.print(modeNames[mode]);
+    Serial.print("\",");
+    printField("debounce_ms", debounceMs);
+    printField("presses", numLatencies);
+    printField("lat_min_us", numLatencies ? latencies[0] : 0);
+    printField("lat_avg_us", numLatencies ? sum / numLatencies : 0);
+    printField("lat_p95_us", numLatencies ? latencies[(numLatencies * 95) / 100] : 0);
+    printField("lat_max_us", maxLatency);
+    printField("false_edges", falseEdges);
+    printField("missed_edges", missedEdges);
+    printField("gated", gated);
+    printField("pass", pass, true);
+    Serial.println("}");
+}
+
+void runEncoderCase(const EncoderModel& m, unsigned long encoderMs) {
+    if (!beginCase(50, encoderMs, DEBOUNCE_DEFERRED)) return;
+
+    encoderSteps = 0;
+    wrongSteps = 0;
+
+    uint32_t words[3] = {0, 3, 0};
+    uint32_t startUs = 10000;
+    uint32_t transitions = ENCODER_DETENTS * 4;
+    uint32_t endUs = startUs + m.stepUs * (transitions + 2) + 20000;
+
+    for (scanUs = SCAN_PERIOD_US; scanUs < endUs; scanUs += SCAN_PERIOD_US) {
+        words[ENCODER_WORD] = encoderLevels(m, scanUs, startUs, transitions);
+        controller.processFrame(scanUs / 1000, words);
+    }
+
+    int32_t missed = ENCODER_DETENTS - encoderSteps;
+
+    Serial.print("{\"encoder\":\"");
+    Serial.print(m.name);
+    Serial.print("\",");
+    printField("encoder_debounce_ms", encoderMs);
+    printField("detents", ENCODER_DETENTS);
+    printField("counted", encoderSteps);
+    printField("missed", missed > 0 ? missed : 0);
+    printField("extra", missed < 0 ? -missed : 0);
+    printField("wrong_direction", wrongSteps, true);
+    Serial.println("}");
+}
+
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {}
+
+    controller.setGpio(gpioPins, 1);
+    controller.setEncoders(encoderPinsA, encoderPinsB, 1);
+    controller.setGpioCallback(onGpioChange);
+    controller.setEncoderCallback(onEncoderChange);
+
+    for (uint8_t m = 0; m < sizeof(switchModels) / sizeof(switchModels[0]); m++) {
+        for (uint8_t d = 0; d < sizeof(debounceSettings) / sizeof(debounceSettings[0]); d++) {
+            for (uint8_t k = 0; k < sizeof(debounceModes) / sizeof(debounceModes[0]); k++) {
+                runSwitchCase(switchModels[m], debounceSettings[d], debounceModes[k]);
+            }
+        }
+    }
+
+    for (uint8_t m = 0; m < sizeof(encoderModels) / sizeof(encoderModels[0]); m++) {
+        for (uint8_t d = 0; d < sizeof(encoderSettings) / sizeof(encoderSettings[0]); d++) {
+            runEncoderCase(encoderModels[m], encoderSettings[d]);
+        }
+    }
+
+    Serial.println(allPassed ? "{\"result\":\"PASS\"}" : "{\"result\":\"FAIL\"}");
+}
+
+void loop() {
+}
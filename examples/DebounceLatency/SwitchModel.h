@@ -0,0 +1,108 @@
+#ifndef SWITCH_MODEL_H
+#define SWITCH_MODEL_H
+
+// Synthetic switch and encoder models
+// All functions are deterministic: the same model and time always give
+// the same level, so every run produces the same results.
+
+/**
+ * Push button / toggle switch model
+ */
+struct SwitchModel {
+    const char* name;
+    uint32_t bounceUs;       // Contact chatter after each edge
+    uint32_t chatterUs;      // Chatter toggle interval
+    uint32_t glitchUs;       // Width of isolated glitch pulses (0 = none)
+    uint32_t glitchEveryUs;  // Mean glitch interval
+    uint32_t spikeUs;        // Width of EMI spikes hitting every input (0 = none)
+    uint32_t spikeEveryUs;   // Mean spike interval
+};
+
+/**
+ * Quadrature encoder model
+ */
+struct EncoderModel {
+    const char* name;
+    uint32_t stepUs;         // Time between quadrature transitions
+    uint32_t jitterUs;       // Random phase error per transition (< stepUs / 2)
+    uint32_t bounceUs;       // Chatter of the changing line
+    uint32_t chatterUs;      // Chatter toggle interval
+};
+
+uint32_t modelHash(uint32_t a, uint32_t b) {
+    uint32_t h = a * 0x9E3779B1UL ^ (b + 0x7F4A7C15UL);
+    h ^= h >> 15;
+    h *= 0x2C1B3C6DUL;
+    h ^= h >> 12;
+    h *= 0x297A2D39UL;
+    h ^= h >> 15;
+    return h;
+}
+
+/**
+ * @return true if a pulse of the given width is active at time t
+ */
+bool pulseActive(uint32_t tUs, uint32_t widthUs, uint32_t everyUs, uint32_t seed) {
+    if (widthUs == 0 || everyUs <= widthUs) return false;
+    uint32_t slot = tUs / everyUs;
+    uint32_t offset = modelHash(slot, seed) % (everyUs - widthUs);
+    uint32_t inSlot = tUs % everyUs;
+    return inSlot >= offset && inSlot - offset < widthUs;
+}
+
+/**
+ * Switch level (true = active)
+ * @param ideal Ideal level at time t
+ * @param edgeUs Time of the last ideal edge
+ * @param edgeId Sequence number of the last ideal edge
+ */
+bool switchLevel(const SwitchModel& m, uint32_t tUs, bool ideal,
+                 uint32_t edgeUs, uint32_t edgeId) {
+    bool level = ideal;
+    uint32_t since = tUs - edgeUs;
+    if (since < m.bounceUs) {
+        level = modelHash(edgeId, since / m.chatterUs) & 1;
+    }
+    if (pulseActive(tUs, m.glitchUs, m.glitchEveryUs, 1)) level = !level;
+    if (pulseActive(tUs, m.spikeUs, m.spikeEveryUs, 2)) level = !level;
+    return level;
+}
+
+/**
+ * Time of quadrature transition k of a clockwise spin starting at startUs
+ */
+uint32_t encoderTransitionUs(const EncoderModel& m, uint32_t startUs, uint32_t k) {
+    int32_t jitter = 0;
+    if (m.jitterUs) {
+        jitter = (int32_t)(modelHash(k, 3) % (2 * m.jitterUs + 1)) - (int32_t)m.jitterUs;
+    }
+    return startUs + m.stepUs * (k + 1) + jitter;
+}
+
+/**
+ * Encoder A/B levels ((A << 1) | B) of a clockwise spin
+ * @param transitions Total transitions (4 per detent)
+ */
+uint8_t encoderLevels(const EncoderModel& m, uint32_t tUs, uint32_t startUs,
+                      uint32_t transitions) {
+    static const uint8_t CW[4] = {3, 2, 0, 1};
+    if (tUs < encoderTransitionUs(m, startUs, 0)) return CW[0];
+
+    // Last transition at or before t
+    uint32_t k = (tUs - startUs) / m.stepUs;
+    if (k >= transitions) k = transitions;
+    while (k > 0 && encoderTransitionUs(m, startUs, k - 1) > tUs) k--;
+    while (k < transitions && encoderTransitionUs(m, startUs, k) <= tUs) k++;
+    // k transitions done
+    uint8_t state = CW[k % 4];
+    if (k == 0) return state;
+
+    uint32_t since = tUs - encoderTransitionUs(m, startUs, k - 1);
+    if (since < m.bounceUs) {
+        uint8_t previous = CW[(k - 1) % 4];
+        if (modelHash(k, since / m.chatterUs) & 1) state = previous;
+    }
+    return state;
+}
+
+#endif
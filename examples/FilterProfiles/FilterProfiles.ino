@@ -0,0 +1,110 @@
+/**************************
+ * SimRacingController
+ * Filter Profiles Example
+ * v 2.1.0
+ * by roncoa@gmail.com
+ * 29/01/2025
+ **************************/
+
+// Per-input debounce: magnetic shift paddles get a short eager filter,
+// worn toggle switches a long integration, everything else the defaults.
+// Profile 1 (e.g. rally) swaps in a table with slower encoders.
+
+#include <SimRacingController.h>
+
+// Matrix configuration (row 0 holds the toggle switches)
+const int MATRIX_ROWS = 3;
+const int MATRIX_COLS = 3;
+const int rowPins[MATRIX_ROWS] = {2, 3, 4};
+const int colPins[MATRIX_COLS] = {5, 6, 7};
+
+// Shift paddles on direct GPIO
+const int NUM_GPIO = 2;
+const int gpioPins[NUM_GPIO] = {8, 9};
+
+// Encoder configuration
+const int NUM_ENCODERS = 2;
+const int encoderPinsA[NUM_ENCODERS] = {10, 12};
+const int encoderPinsB[NUM_ENCODERS] = {11, 13};
+
+// Free filter classes (0-4 are the defaults of each input source)
+const uint8_t FILTER_PADDLE = 5;
+const uint8_t FILTER_TOGGLE = 6;
+
+// Profile 1 table: classes by number, unlisted classes use the defaults
+const FilterClass rallyFilters[MAX_FILTER_CLASSES] = {
+    FilterClass(50),                        // SOURCE_MATRIX
+    FilterClass(50),                        // SOURCE_GPIO
+    FilterClass(50),                        // SOURCE_MCP
+    FilterClass(50),                        // SOURCE_ENCODER_BUTTON
+    FilterClass(20),                        // SOURCE_ENCODER: one step per 20ms
+    FilterClass(5, DEBOUNCE_EAGER_PRESS),   // FILTER_PADDLE
+    FilterClass(80),                        // FILTER_TOGGLE
+    FilterClass(50)
+};
+
+SimRacingController controller;
+
+void onMatrixChange(int profile, int row, int col, bool state) {
+    Serial.print("Matrix [");
+    Serial.print(row);
+    Serial.print(",");
+    Serial.print(col);
+    Serial.print("] = ");
+    Serial.println(state);
+
+    // Button [2,2] switches profile
+    if (row == 2 && col == 2 && state) {
+        controller.setProfile(controller.getProfile() == 0 ? 1 : 0);
+    }
+}
+
+void onGpioChange(int profile, int gpio, bool state) {
+    Serial.print("Paddle ");
+    Serial.print(gpio);
+    Serial.print(" = ");
+    Serial.println(state);
+}
+
+void onEncoderChange(int profile, int encoder, int direction) {
+    Serial.print("Encoder ");
+    Serial.print(encoder);
+    Serial.print(direction > 0 ? " CW" : " CCW");
+    Serial.print(" (Profile ");
+    Serial.print(profile);
+    Serial.println(")");
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    controller.setMatrix(rowPins, MATRIX_ROWS, colPins, MATRIX_COLS);
+    controller.setGpio(gpioPins, NUM_GPIO);
+    controller.setEncoders(encoderPinsA, encoderPinsB, NUM_ENCODERS);
+    controller.setProfiles(2);
+
+    controller.setMatrixCallback(onMatrixChange);
+    controller.setGpioCallback(onGpioChange);
+    controller.setEncoderCallback(onEncoderChange);
+
+    // Default table (profile 0)
+    controller.setFilterClass(FILTER_PADDLE, 2, DEBOUNCE_EAGER_PRESS);
+    controller.setFilterClass(FILTER_TOGGLE, 60);
+
+    // Assign inputs (after setMatrix/setGpio/setEncoders)
+    controller.setSourceFilter(SOURCE_GPIO, FILTER_PADDLE);
+    for (int col = 0; col < MATRIX_COLS; col++) {
+        controller.setInputFilter(SOURCE_MATRIX, 0 * MATRIX_COLS + col, FILTER_TOGGLE);
+    }
+
+    controller.setFilterTable(1, rallyFilters);
+
+    if (!controller.begin()) {
+        Serial.println("Error: " + String(controller.getLastError().message));
+        while(1);
+    }
+}
+
+void loop() {
+    controller.update();
+}
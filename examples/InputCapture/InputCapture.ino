@@ -0,0 +1,88 @@
+/**************************
+ * SimRacingController
+ * Input Capture Example
+ * v 2.1.0
+ * by roncoa@gmail.com
+ * 29/01/2025
+ **************************/
+
+// Records the raw samples of every scan so that "encoder skipped" or
+// "button double-fired" reports can be replayed later (see InputReplay).
+//
+// Serial commands:
+//   d - binary dump of the capture (save it, e.g. cat /dev/ttyACM0 > capture.bin,
+//       then convert it with xxd -i capture.bin for InputReplay/Capture.h)
+//   c - clear the capture
+//   s - print capture statistics
+
+#include <SimRacingController.h>
+#include <InputRecorder.h>
+
+// Matrix configuration
+const int MATRIX_ROWS = 3;
+const int MATRIX_COLS = 3;
+const int rowPins[MATRIX_ROWS] = {2, 3, 4};
+const int colPins[MATRIX_COLS] = {5, 6, 7};
+
+// Direct GPIO configuration
+const int NUM_GPIO = 2;
+const int gpioPins[NUM_GPIO] = {8, 9};
+
+// Encoder configuration
+const int NUM_ENCODERS = 2;
+const int encoderPinsA[NUM_ENCODERS] = {10, 12};
+const int encoderPinsB[NUM_ENCODERS] = {11, 13};
+const int encoderBtnPins[NUM_ENCODERS] = {14, 15};
+
+// Capture buffer (the oldest frames are dropped when full)
+#ifdef ARDUINO_ARCH_ESP32
+    #define CAPTURE_SIZE 32768
+#else
+    #define CAPTURE_SIZE 1024
+#endif
+uint8_t captureBuffer[CAPTURE_SIZE];
+
+// Create instances
+SimRacingController controller;
+InputRecorder recorder(captureBuffer, CAPTURE_SIZE);
+
+void setup() {
+    Serial.begin(115200);
+
+    // Configure components
+    controller.setMatrix(rowPins, MATRIX_ROWS, colPins, MATRIX_COLS);
+    controller.setGpio(gpioPins, NUM_GPIO);
+    controller.setEncoders(encoderPinsA, encoderPinsB, encoderBtnPins, NUM_ENCODERS);
+    controller.setRecorder(&recorder);
+
+    // Initialize controller
+    if (!controller.begin()) {
+        Serial.println("Error: " + String(controller.getLastError().message));
+        while(1);
+    }
+}
+
+void loop() {
+    controller.update();
+
+    if (Serial.available()) {
+        switch (Serial.read()) {
+            case 'd':
+                recorder.pause();
+                recorder.dump(Serial);
+                recorder.resume();
+                break;
+            case 'c':
+                recorder.clear();
+                break;
+            case 's':
+                Serial.print("Frames: ");
+                Serial.print(recorder.getFrameCount());
+                Serial.print(" Dropped: ");
+                Serial.print(recorder.getDroppedFrames());
+                Serial.print(" Bytes: ");
+                Serial.println((unsigned long)recorder.getUsedBytes());
+                break;
+        }
+    }
+}
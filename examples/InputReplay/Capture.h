@@ -0,0 +1,22 @@
+// Capture made with the InputCapture example (same layout):
+// bouncy matrix [0][1] press, GPIO 1 press, two encoder 0 detents
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+const uint8_t capture[] PROGMEM = {
+    0x53, 0x52, 0x43, 0x52, 0x01, 0x06, 0x01, 0x00, 0x00, 0x00, 0x58, 0x02,
+    0x00, 0x00, 0x66, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0F, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x12, 0x01, 0x81, 0x01, 0x00, 0x02,
+    0x3F, 0x01, 0x3F, 0x01, 0x32, 0x01, 0x81, 0x01, 0x00, 0x02, 0x81, 0x01,
+    0x00, 0x02, 0x81, 0x01, 0x00, 0x02, 0x81, 0x01, 0x00, 0x02, 0x81, 0x01,
+    0x00, 0x02, 0x2C, 0x01, 0x81, 0x01, 0x03, 0x02, 0x3F, 0x01, 0x0E, 0x01,
+    0x81, 0x01, 0x03, 0x02, 0x3F, 0x01, 0x04, 0x01, 0x81, 0x01, 0x04, 0x01,
+    0x06, 0x01, 0x81, 0x01, 0x04, 0x02, 0x06, 0x01, 0x81, 0x01, 0x04, 0x01,
+    0x06, 0x01, 0x81, 0x01, 0x04, 0x02, 0x06, 0x01, 0x81, 0x01, 0x04, 0x01,
+    0x06, 0x01, 0x81, 0x01, 0x04, 0x02, 0x06, 0x01, 0x81, 0x01, 0x04, 0x01,
+    0x06, 0x01, 0x81, 0x01, 0x04, 0x02, 0x3F, 0x01, 0x3F, 0x01, 0x0E, 0x01,
+};
+
+#endif
@@ -0,0 +1,116 @@
+/**************************
+ * SimRacingController
+ * Input Replay Example
+ * v 2.1.0
+ * by roncoa@gmail.com
+ * 29/01/2025
+ **************************/
+
+// Feeds a capture made with InputCapture back through the controller and
+// prints the resulting callbacks. No inputs need to be connected: the
+// controller processes the recorded frames instead of reading pins, so
+// the same capture always produces the same callback sequence. Use it to
+// check debounce or encoder changes against real field captures.
+//
+// The configuration must match the one used for the capture.
+
+#include <SimRacingController.h>
+#include <InputRecorder.h>
+#include "Capture.h"
+
+// Matrix configuration
+const int MATRIX_ROWS = 3;
+const int MATRIX_COLS = 3;
+const int rowPins[MATRIX_ROWS] = {2, 3, 4};
+const int colPins[MATRIX_COLS] = {5, 6, 7};
+
+// Direct GPIO configuration
+const int NUM_GPIO = 2;
+const int gpioPins[NUM_GPIO] = {8, 9};
+
+// Encoder configuration
+const int NUM_ENCODERS = 2;
+const int encoderPinsA[NUM_ENCODERS] = {10, 12};
+const int encoderPinsB[NUM_ENCODERS] = {11, 13};
+const int encoderBtnPins[NUM_ENCODERS] = {14, 15};
+
+// Largest frame this sketch can replay
+#define MAX_FRAME_WORDS 16
+
+// Create instances
+SimRacingController controller;
+InputReplayer replayer(capture, sizeof(capture), true);
+
+unsigned long frameTime = 0;
+
+void onMatrixChange(int profile, int row, int col, bool state) {
+    Serial.print(frameTime);
+    Serial.print(" Matrix [");
+    Serial.print(row);
+    Serial.print("][");
+    Serial.print(col);
+    Serial.print("] ");
+    Serial.println(state ? "PRESSED" : "RELEASED");
+}
+
+void onGpioChange(int profile, int gpio, bool state) {
+    Serial.print(frameTime);
+    Serial.print(" GPIO ");
+    Serial.print(gpio);
+    Serial.print(" ");
+    Serial.println(state ? "PRESSED" : "RELEASED");
+}
+
+void onEncoderChange(int profile, int encoder, int direction) {
+    Serial.print(frameTime);
+    Serial.print(" Encoder ");
+    Serial.print(encoder);
+    Serial.println(direction > 0 ? " CW" : " CCW");
+}
+
+void onEncoderButtonChange(int profile, int encoder, bool state) {
+    Serial.print(frameTime);
+    Serial.print(" Encoder ");
+    Serial.print(encoder);
+    Serial.print(" Button ");
+    Serial.println(state ? "PRESSED" : "RELEASED");
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    // Configure components (same layout as the capture)
+    controller.setMatrix(rowPins, MATRIX_ROWS, colPins, MATRIX_COLS);
+    controller.setGpio(gpioPins, NUM_GPIO);
+    controller.setEncoders(encoderPinsA, encoderPinsB, encoderBtnPins, NUM_ENCODERS);
+
+    controller.setMatrixCallback(onMatrixChange);
+    controller.setGpioCallback(onGpioChange);
+    controller.setEncoderCallback(onEncoderChange);
+    controller.setEncoderButtonCallback(onEncoderButtonChange);
+
+    if (!replayer.begin() || replayer.getFrameSize() > MAX_FRAME_WORDS) {
+        Serial.println("Error: invalid capture");
+        while(1);
+    }
+
+    uint32_t words[MAX_FRAME_WORDS];
+    uint32_t frames = 0;
+    while (replayer.next(frameTime, words)) {
+        if (frames++ == 0) {
+            if (!controller.beginReplay(frameTime, words) ||
+                controller.getFrameSize() != replayer.getFrameSize()) {
+                Serial.println("Error: capture does not match the configuration");
+                while(1);
+            }
+        } else {
+            controller.processFrame(frameTime, words, (FrameKind)replayer.getFrameKind());
+        }
+    }
+
+    Serial.print("Replayed frames: ");
+    Serial.println(frames);
+}
+
+void loop() {
+}
@@ -0,0 +1,58 @@
+/**************************
+ * SimRacingController
+ * Live Configuration Example
+ * v 2.1.0
+ * by roncoa@gmail.com
+ * 29/01/2025
+ **************************/
+
+// Debounce times, encoder divisors and profile filter tables can be read
+// and changed from the host while the box runs, and saved to the EEPROM:
+//
+//   python3 extras/config_client.py /dev/ttyACM0 info
+//   python3 extras/config_client.py /dev/ttyACM0 set-debounce 20 3
+//   python3 extras/config_client.py /dev/ttyACM0 set-filter 1 0 10 eager
+//   python3 extras/config_client.py /dev/ttyACM0 set-divisor 0 2
+//   python3 extras/config_client.py /dev/ttyACM0 save
+//
+// The saved configuration is loaded at the next start.
+
+#include <SimRacingController.h>
+#include <ConfigServer.h>
+
+// Matrix configuration
+const int MATRIX_ROWS = 3;
+const int MATRIX_COLS = 3;
+const int rowPins[MATRIX_ROWS] = {2, 3, 4};
+const int colPins[MATRIX_COLS] = {5, 6, 7};
+
+// Encoder configuration
+const int NUM_ENCODERS = 2;
+const int encoderPinsA[NUM_ENCODERS] = {10, 12};
+const int encoderPinsB[NUM_ENCODERS] = {11, 13};
+const int encoderBtnPins[NUM_ENCODERS] = {14, 15};
+
+// Create instances
+SimRacingController controller;
+EepromConfigStore eeprom;
+ConfigServer server(controller, Serial, &eeprom);
+
+void setup() {
+    Serial.begin(115200);
+
+    // Saved configuration, or the default layout on first start
+    if (!controller.begin(eeprom)) {
+        controller.setProfiles(2);
+        controller.setMatrix(rowPins, MATRIX_ROWS, colPins, MATRIX_COLS);
+        controller.setEncoders(encoderPinsA, encoderPinsB, encoderBtnPins, NUM_ENCODERS);
+
+        if (!controller.begin()) {
+            while(1);
+        }
+    }
+}
+
+void loop() {
+    controller.update();
+    server.poll();      // Requests apply between two scans
+}
@@ -0,0 +1,96 @@
+/**************************
+ * SimRacingController
+ * Multiple Controllers Example
+ * v 2.1.0
+ * by roncoa@gmail.com
+ * 29/01/2025
+ **************************/
+
+// Two controllers on one board: a wheel rim and a button box, each with
+// its own MCP23017 on the shared I2C bus. Callbacks take a context pointer,
+// so every panel handles its own inputs without globals.
+
+#include <SimRacingController.h>
+
+class Panel {
+    private:
+        const char* name;
+
+    public:
+        SimRacingController controller;
+
+        Panel(const char* name) : name(name) {}
+
+        void attach() {
+            controller.setGpioCallback([](void* context, int profile, int gpio, bool state) {
+                static_cast<Panel*>(context)->onButton(gpio, state);
+            }, this);
+            controller.setMcpCallback([](void* context, int profile, int device, int pin, bool state) {
+                static_cast<Panel*>(context)->onButton(device * 16 + pin, state);
+            }, this);
+            controller.setEncoderCallback([](void* context, int profile, int encoder, int direction) {
+                static_cast<Panel*>(context)->onEncoder(encoder, direction);
+            }, this);
+            controller.setErrorCallback([](void* context, const ControllerError& error) {
+                static_cast<Panel*>(context)->onError(error);
+                return true;
+            }, this);
+        }
+
+        void onButton(int button, bool pressed) {
+            Serial.print(name);
+            Serial.print(" button ");
+            Serial.print(button);
+            Serial.println(pressed ? " pressed" : " released");
+        }
+
+        void onEncoder(int encoder, int direction) {
+            Serial.print(name);
+            Serial.print(" encoder ");
+            Serial.print(encoder);
+            Serial.println(direction > 0 ? " CW" : " CCW");
+        }
+
+        void onError(const ControllerError& error) {
+            Serial.print(name);
+            Serial.print(" error: ");
+            Serial.println(error.message);
+        }
+};
+
+// Wheel rim: paddles on GPIO, two encoders, one MCP23017 at 0x20
+const int rimPaddles[2] = {2, 3};
+const int rimEncoderA[2] = {4, 6};
+const int rimEncoderB[2] = {5, 7};
+const McpConfig rimMcp[1] = {McpConfig(0x20)};
+
+// Button box: two MCP23017s at 0x21 and 0x22 on the same bus
+const McpConfig boxMcp[2] = {McpConfig(0x21), McpConfig(0x22)};
+
+Panel rim("rim");
+Panel box("box");
+
+void setup() {
+    Serial.begin(115200);
+
+    rim.controller.setGpio(rimPaddles, 2);
+    rim.controller.setEncoders(rimEncoderA, rimEncoderB, 2);
+    rim.controller.setMcpDevices(rimMcp, 1);
+    rim.attach();
+
+    // The box may use another bus clock; it is set for each of its transfers
+    box.controller.setMcpDevices(boxMcp, 2);
+    box.controller.setI2cClock(100000);
+    box.attach();
+
+    // A second controller using an address of the first fails with PIN_CONFLICT
+    if (!rim.controller.begin() || !box.controller.begin()) {
+        Serial.println("Error: controller setup failed");
+        while(1);
+    }
+}
+
+void loop() {
+    rim.controller.update();
+    box.controller.update();
+}
@@ -0,0 +1,236 @@
+/**************************
+ * SimRacingController
+ * Replay Check Example
+ * v 2.1.0
+ * by roncoa@gmail.com
+ * 29/01/2025
+ **************************/
+
+// Checks that a capture replays to the same callbacks as the live run.
+// The controller scans with a small scan budget and an encoder sample
+// rate, so the capture holds scan slices and encoder samples taken
+// between frame words (see FrameKind), not only complete scans. Every
+// live callback is logged. On 'v' the capture is replayed through a
+// second controller with the same configuration and the two callback
+// sequences are compared.
+//
+// Serial commands:
+//   v - replay the capture and compare, prints PASS or FAIL
+//   c - clear the capture and the log, start a new check (release all
+//       inputs first)
+//
+// The first recorded frame seeds the replay state, so callbacks are logged
+// from the update after it. Start a check with all inputs released.
+
+#include <SimRacingController.h>
+#include <InputRecorder.h>
+
+// Matrix configuration
+const int MATRIX_ROWS = 3;
+const int MATRIX_COLS = 3;
+const int rowPins[MATRIX_ROWS] = {2, 3, 4};
+const int colPins[MATRIX_COLS] = {5, 6, 7};
+
+// Direct GPIO configuration
+const int NUM_GPIO = 2;
+const int gpioPins[NUM_GPIO] = {8, 9};
+
+// Encoder configuration
+const int NUM_ENCODERS = 2;
+const int encoderPinsA[NUM_ENCODERS] = {10, 12};
+const int encoderPinsB[NUM_ENCODERS] = {11, 13};
+const int encoderBtnPins[NUM_ENCODERS] = {14, 15};
+
+// Scan settings: one or two words per update, encoders sampled in between
+#define SCAN_BUDGET_US    50
+#define ENCODER_RATE_HZ   4000
+
+// Capture and callback log sizes (on AVR a check covers a few hundred frames)
+#ifdef ARDUINO_ARCH_ESP32
+    #define CAPTURE_SIZE  16384
+    #define MAX_EVENTS    512
+#else
+    #define CAPTURE_SIZE  256
+    #define MAX_EVENTS    32
+#endif
+#define CAPTURE_MARGIN    64        // Room kept for the frames of one update
+#define MAX_FRAME_WORDS   16
+
+uint8_t captureBuffer[CAPTURE_SIZE];
+uint8_t dumpBuffer[18 + MAX_FRAME_WORDS * 4 + CAPTURE_SIZE];   // Header, base frame, records
+
+/**
+ * One callback
+ */
+struct LoggedEvent {
+    uint8_t source;
+    uint8_t index;
+    int16_t value;
+};
+
+/**
+ * Callback sequence of one controller
+ */
+struct EventLog {
+    LoggedEvent events[MAX_EVENTS];
+    uint16_t count;
+    bool enabled;
+
+    void clear() {
+        count = 0;
+    }
+
+    void add(InputSource source, int index, int value) {
+        if (!enabled || count >= MAX_EVENTS) return;
+        events[count].source = source;
+        events[count].index = index;
+        events[count].value = value;
+        count++;
+    }
+
+    bool isFull() const {
+        return count >= MAX_EVENTS;
+    }
+};
+
+/**
+ * Collects a recorder dump in RAM
+ */
+class DumpBuffer : public Print {
+    public:
+        size_t length = 0;
+
+        size_t write(uint8_t value) override {
+            if (length >= sizeof(dumpBuffer)) return 0;
+            dumpBuffer[length++] = value;
+            return 1;
+        }
+};
+
+// Create instances
+SimRacingController controller;
+SimRacingController replayController;
+InputRecorder recorder(captureBuffer, CAPTURE_SIZE);
+EventLog liveLog;
+EventLog replayLog;
+
+/**
+ * Applies the layout and logging callbacks shared by both controllers
+ */
+void configure(SimRacingController& target, EventLog& log) {
+    target.setMatrix(rowPins, MATRIX_ROWS, colPins, MATRIX_COLS);
+    target.setGpio(gpioPins, NUM_GPIO);
+    target.setEncoders(encoderPinsA, encoderPinsB, encoderBtnPins, NUM_ENCODERS);
+
+    target.setMatrixCallback([](void* context, int profile, int row, int col, bool state) {
+        static_cast<EventLog*>(context)->add(SOURCE_MATRIX, row * MATRIX_COLS + col, state);
+    }, &log);
+    target.setGpioCallback([](void* context, int profile, int gpio, bool state) {
+        static_cast<EventLog*>(context)->add(SOURCE_GPIO, gpio, state);
+    }, &log);
+    target.setEncoderCallback([](void* context, int profile, int encoder, int direction) {
+        static_cast<EventLog*>(context)->add(SOURCE_ENCODER, encoder, direction);
+    }, &log);
+    target.setEncoderButtonCallback([](void* context, int profile, int encoder, bool pressed) {
+        static_cast<EventLog*>(context)->add(SOURCE_ENCODER_BUTTON, encoder, pressed);
+    }, &log);
+}
+
+/**
+ * Replays the capture and compares the callbacks with the live log
+ */
+void checkReplay() {
+    if (recorder.getDroppedFrames() > 0) {
+        Serial.println("Capture overflowed, clear it and retry");
+        return;
+    }
+
+    DumpBuffer dump;
+    recorder.dump(dump);
+    InputReplayer replayer(dumpBuffer, dump.length);
+    if (!replayer.begin() || replayer.getFrameSize() > MAX_FRAME_WORDS) {
+        Serial.println("Error: invalid capture");
+        return;
+    }
+
+    replayLog.clear();
+    replayLog.enabled = true;
+
+    uint32_t words[MAX_FRAME_WORDS];
+    unsigned long frameTime;
+    uint32_t frames = 0;
+    while (replayer.next(frameTime, words)) {
+        if (frames++ == 0) {
+            if (!replayController.beginReplay(frameTime, words)) {
+                Serial.println("Error: " + String(replayController.getLastError().message));
+                return;
+            }
+        } else {
+            replayController.processFrame(frameTime, words, (FrameKind)replayer.getFrameKind());
+        }
+    }
+
+    Serial.print("Frames: ");
+    Serial.print(frames);
+    Serial.print(" Live events: ");
+    Serial.print(liveLog.count);
+    Serial.print(" Replayed events: ");
+    Serial.println(replayLog.count);
+
+    uint16_t count = liveLog.count < replayLog.count ? liveLog.count : replayLog.count;
+    for (uint16_t i = 0; i < count; i++) {
+        const LoggedEvent& live = liveLog.events[i];
+        const LoggedEvent& replayed = replayLog.events[i];
+        if (live.source != replayed.source || live.index != replayed.index ||
+            live.value != replayed.value) {
+            Serial.print("First difference at event ");
+            Serial.println(i);
+            Serial.println("FAIL");
+            return;
+        }
+    }
+    Serial.println(liveLog.count == replayLog.count ? "PASS" : "FAIL");
+}
+
+void setup() {
+    Serial.begin(115200);
+
+    configure(controller, liveLog);
+    configure(replayController, replayLog);
+    controller.setScanBudget(SCAN_BUDGET_US);
+    controller.setSampleRate(SOURCE_ENCODER, ENCODER_RATE_HZ);
+    controller.setRecorder(&recorder);
+
+    // Initialize controller
+    if (!controller.begin()) {
+        Serial.println("Error: " + String(controller.getLastError().message));
+        while(1);
+    }
+}
+
+void loop() {
+    // Log from the update after the first recorded frame
+    liveLog.enabled = recorder.isRecording() && recorder.getFrameCount() > 0;
+    controller.update();
+
+    // Stop before the capture drops frames or the log overflows
+    if (recorder.isRecording() &&
+        (liveLog.isFull() || recorder.getUsedBytes() + CAPTURE_MARGIN > CAPTURE_SIZE)) {
+        recorder.pause();
+        Serial.println("Capture full, send 'v' to check");
+    }
+
+    if (Serial.available()) {
+        switch (Serial.read()) {
+            case 'v':
+                recorder.pause();
+                checkReplay();
+                break;
+            case 'c':
+                recorder.clear();
+                recorder.resume();
+                liveLog.clear();
+                break;
+        }
+    }
+}
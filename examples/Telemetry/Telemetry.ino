@@ -0,0 +1,57 @@
+/**************************
+ * SimRacingController
+ * Binary Telemetry Example
+ * v 2.1.0
+ * by roncoa@gmail.com
+ * 29/01/2025
+ **************************/
+
+// Streams input events, encoder positions and scan statistics as binary
+// frames instead of text. Frames that do not fit in the serial buffer are
+// dropped (and counted), so the stream never stalls the scan.
+//
+// On the host:
+//   python3 extras/telemetry_decode.py /dev/ttyACM0
+//   python3 extras/telemetry_decode.py /dev/ttyACM0 --record session.bin
+
+#include <SimRacingController.h>
+#include <Telemetry.h>
+
+// Matrix configuration
+const int MATRIX_ROWS = 3;
+const int MATRIX_COLS = 3;
+const int rowPins[MATRIX_ROWS] = {2, 3, 4};
+const int colPins[MATRIX_COLS] = {5, 6, 7};
+
+// Encoder configuration
+const int NUM_ENCODERS = 2;
+const int encoderPinsA[NUM_ENCODERS] = {10, 12};
+const int encoderPinsB[NUM_ENCODERS] = {11, 13};
+const int encoderBtnPins[NUM_ENCODERS] = {14, 15};
+
+// Create instances
+SimRacingController controller;
+TelemetryWriter telemetry(Serial);
+
+void setup() {
+    Serial.begin(115200);
+
+    // Configure components
+    controller.setMatrix(rowPins, MATRIX_ROWS, colPins, MATRIX_COLS);
+    controller.setEncoders(encoderPinsA, encoderPinsB, encoderBtnPins, NUM_ENCODERS);
+
+    // Encoder snapshot every 50 ms, scan statistics every second
+    telemetry.setStateInterval(50);
+    telemetry.setStatsInterval(1000);
+    controller.setTelemetry(&telemetry);
+
+    // Initialize controller
+    if (!controller.begin()) {
+        Serial.println("Error: " + String(controller.getLastError().message));
+        while(1);
+    }
+}
+
+void loop() {
+    controller.update();
+}
@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""
+config_client.py
+v 2.1.0
+by roncoa@gmail.com
+
+Reads and changes the settings of a running SimRacingController through
+ConfigServer (see src/ConfigServer.h). Needs pyserial.
+
+  config_client.py /dev/ttyACM0 info
+  config_client.py /dev/ttyACM0 set-debounce 20 3
+  config_client.py /dev/ttyACM0 set-filter 1 5 40 eager      (profile 1, class 5)
+  config_client.py /dev/ttyACM0 get-filter default 0
+  config_client.py /dev/ttyACM0 set-divisor 0 2
+  config_client.py /dev/ttyACM0 set-input-filter matrix 7 5
+  config_client.py /dev/ttyACM0 save
+  config_client.py /dev/ttyACM0 ping                        (round trip check)
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+from telemetry_decode import SOURCES, cobs_decode, crc16
+
+PROTOCOL_VERSION = 1
+
+PING, INFO = 0x01, 0x02
+GET_FILTER, SET_FILTER, SET_DEBOUNCE = 0x10, 0x11, 0x12
+GET_DIVISOR, SET_DIVISOR = 0x20, 0x21
+GET_INPUT_FILTER, SET_INPUT_FILTER = 0x30, 0x31
+GET_PROFILE, SET_PROFILE = 0x40, 0x41
+SAVE = 0x50
+
+STATUS = ["ok", "unknown command", "bad length", "invalid value", "no store on the device",
+          "store write failed"]
+
+MODES = ["deferred", "eager", "eager-press"]
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code = 0
+    for value in data:
+        if value == 0:
+            out[code] = len(out) - code
+            code = len(out)
+            out.append(0)
+        else:
+            out.append(value)
+    out[code] = len(out) - code
+    return bytes(out)
+
+
+def encode_frame(payload):
+    return cobs_encode(payload + struct.pack("<H", crc16(payload))) + b"\x00"
+
+
+class ConfigError(Exception):
+    pass
+
+
+class Client:
+    def __init__(self, port, timeout=1.0):
+        self.port = port
+        self.timeout = timeout
+        self.sequence = 0
+        self.buffer = bytearray()
+
+    def request(self, command, args=b""):
+        """Sends one request and returns the values of its response"""
+        self.sequence = (self.sequence + 1) & 0xFF
+        self.port.write(encode_frame(bytes([command, self.sequence]) + args))
+
+        deadline = time.time() + self.timeout
+        while time.time() < deadline:
+            end = self.buffer.find(b"\x00")
+            if end < 0:
+                self.buffer += self.port.read(64)
+                continue
+            raw = bytes(self.buffer[:end])
+            del self.buffer[:end + 1]
+            try:
+                payload = cobs_decode(raw)
+            except ValueError:
+                continue
+            if len(payload) < 5 or crc16(payload[:-2]) != struct.unpack("<H", payload[-2:])[0]:
+                continue
+            # Telemetry frames and stale responses are skipped
+            if payload[0] != command | 0x80 or payload[1] != self.sequence:
+                continue
+            status = payload[2]
+            if status:
+                raise ConfigError(STATUS[status] if status < len(STATUS) else "status %d" % status)
+            return payload[3:-2]
+        raise ConfigError("no response")
+
+
+def profile_arg(text):
+    return 0xFF if text == "default" else int(text)
+
+
+def source_arg(text):
+    return SOURCES.index(text) if text in SOURCES else int(text)
+
+
+def mode_arg(text):
+    return MODES.index(text) if text in MODES else int(text)
+
+
+def run(client, command, args):
+    if command == "ping":
+        data = bytes(range(1, 33))
+        start = time.time()
+        if client.request(PING, data) != data:
+            raise ConfigError("ping data differs")
+        return "pong in %.1f ms" % ((time.time() - start) * 1000)
+
+    if command == "info":
+        version, profiles, profile, encoders, words = struct.unpack("<5B", client.request(INFO))
+        note = "" if version == PROTOCOL_VERSION else " (client expects %d)" % PROTOCOL_VERSION
+        return ("protocol %d%s, %d profiles, profile %d active, %d encoders, %d frame words" %
+                (version, note, profiles, profile, encoders, words))
+
+    if command == "get-filter":
+        ms, mode = struct.unpack("<HB", client.request(
+            GET_FILTER, bytes([profile_arg(args[0]), int(args[1])])))
+        return "%d ms %s" % (ms, MODES[mode] if mode < len(MODES) else mode)
+
+    if command == "set-filter":
+        client.request(SET_FILTER, struct.pack("<BBHB", profile_arg(args[0]), int(args[1]),
+                                               int(args[2]), mode_arg(args[3] if len(args) > 3 else "deferred")))
+    elif command == "set-debounce":
+        client.request(SET_DEBOUNCE, struct.pack("<HH", int(args[0]), int(args[1])))
+    elif command == "get-divisor":
+        return str(client.request(GET_DIVISOR, bytes([int(args[0])]))[0])
+    elif command == "set-divisor":
+        client.request(SET_DIVISOR, bytes([int(args[0]), int(args[1])]))
+    elif command == "get-input-filter":
+        return str(client.request(GET_INPUT_FILTER, struct.pack("<BH", source_arg(args[0]), int(args[1])))[0])
+    elif command == "set-input-filter":
+        client.request(SET_INPUT_FILTER, struct.pack("<BHB", source_arg(args[0]), int(args[1]), int(args[2])))
+    elif command == "get-profile":
+        return str(client.request(GET_PROFILE)[0])
+    elif command == "set-profile":
+        client.request(SET_PROFILE, bytes([int(args[0])]))
+    elif command == "save":
+        client.request(SAVE)
+    else:
+        raise ConfigError("unknown command %s" % command)
+    return "ok"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="SimRacingController live configuration client")
+    parser.add_argument("port", help="serial port")
+    parser.add_argument("command", help="ping, info, get-filter, set-filter, set-debounce, get-divisor, "
+                                        "set-divisor, get-input-filter, set-input-filter, get-profile, "
+                                        "set-profile, save")
+    parser.add_argument("args", nargs="*")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--timeout", type=float, default=1.0)
+    options = parser.parse_args()
+
+    try:
+        import serial
+    except ImportError:
+        sys.exit("pyserial is needed (pip install pyserial)")
+
+    with serial.Serial(options.port, options.baud, timeout=0.05) as port:
+        try:
+            print(run(Client(port, options.timeout), options.command, options.args))
+        except (ConfigError, IndexError, ValueError) as error:
+            sys.exit("error: %s" % (error or "missing argument"))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,98 @@
+/**************************
+   Arduino.h (host checks)
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+/*
+   Arduino core subset for the host checks in this folder
+
+   Just enough of the core to build the library with g++ and std::thread
+   (SCAN_TASK_THREAD). Pins are plain levels set by the check, the clock is
+   real time plus an offset the check can advance. SDA and SCL are pins of
+   their own, so the I2C bus recovery runs too.
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HIGH            1
+#define LOW             0
+#define INPUT           0x0
+#define OUTPUT          0x1
+#define INPUT_PULLUP    0x2
+
+#define NUM_DIGITAL_PINS 64
+#define SDA             62
+#define SCL             63
+#define PIN_WIRE_SDA    SDA
+
+#define PROGMEM
+#define pgm_read_byte(p)    (*(const uint8_t*)(p))
+#define pgm_read_word(p)    (*(const uint16_t*)(p))
+#define pgm_read_dword(p)   (*(const uint32_t*)(p))
+#define memcpy_P            memcpy
+#define F(text)             text
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// Pin levels and modes (set by the check, read by the library)
+extern volatile uint8_t hostPins[NUM_DIGITAL_PINS];
+extern volatile uint16_t hostAnalog[NUM_DIGITAL_PINS];
+extern void (*hostPinModeHook)(uint8_t pin, uint8_t mode);
+
+// Clock: real time since start plus hostAdvanceMillis()
+unsigned long millis();
+unsigned long micros();
+void hostAdvanceMillis(unsigned long ms);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+inline void yield() {}
+inline void noInterrupts() {}
+inline void interrupts() {}
+
+inline void pinMode(uint8_t pin, uint8_t mode) {
+    if (hostPinModeHook) hostPinModeHook(pin, mode);
+}
+
+inline void digitalWrite(uint8_t pin, uint8_t value) {
+    hostPins[pin] = value;
+}
+
+inline int digitalRead(uint8_t pin) {
+    return hostPins[pin];
+}
+
+inline int analogRead(uint8_t pin) {
+    return hostAnalog[pin];
+}
+
+class Print {
+    public:
+        virtual ~Print() {}
+        virtual size_t write(uint8_t value) = 0;
+        virtual size_t write(const uint8_t* buffer, size_t size) {
+            size_t written = 0;
+            while (size--) written += write(*buffer++);
+            return written;
+        }
+        virtual int availableForWrite() { return 0; }
+};
+
+class Stream : public Print {
+    public:
+        virtual int available() = 0;
+        virtual int read() = 0;
+        virtual int peek() { return -1; }
+};
+
+#endif
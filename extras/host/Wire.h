@@ -0,0 +1,62 @@
+/**************************
+   Wire.h (host checks)
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#ifndef HOST_WIRE_H
+#define HOST_WIRE_H
+
+#include <Arduino.h>
+
+/*
+   I2C bus with healthy MCP23017s
+
+   Every address in presentMask (bit n = address 0x20 + n) acknowledges and
+   reads back 0xFF (all inputs released).
+*/
+
+class TwoWire {
+    public:
+        uint8_t presentMask = 0xFF;     // Answering addresses 0x20..0x27
+        uint32_t begins = 0;            // begin() calls (bus restarts)
+        uint32_t transactions = 0;      // Started transactions
+
+        void begin() { begins++; }
+        void end() {}
+        void setClock(uint32_t) {}
+
+        void beginTransmission(uint8_t address) {
+            target = address;
+            transactions++;
+        }
+        size_t write(uint8_t) { return 1; }
+        uint8_t endTransmission(bool = true) {
+            return isPresent(target) ? 0 : 2;   // 2 = address NACK
+        }
+
+        uint8_t requestFrom(uint8_t address, uint8_t count, uint8_t = 1) {
+            transactions++;
+            pending = isPresent(address) ? count : 0;
+            return pending;
+        }
+        int available() { return pending; }
+        int read() {
+            if (!pending) return -1;
+            pending--;
+            return 0xFF;
+        }
+
+    private:
+        uint8_t target = 0;
+        uint8_t pending = 0;
+
+        bool isPresent(uint8_t address) const {
+            return address >= 0x20 && address <= 0x27 && (presentMask & (1 << (address - 0x20)));
+        }
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,166 @@
+/**************************
+   config_loopback_check.cpp
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+// Host loopback check of the live configuration protocol. Replays the
+// request frames recorded in config_frames.txt through ConfigServer and
+// compares every response byte for byte with the recorded one; a request
+// without a recorded response must get none (bad CRC, oversized frame).
+// The requests were encoded by extras/config_client.py.
+//
+//   config_loopback_check [frames]       check (default config_frames.txt)
+//   config_loopback_check -r [frames]    print the file with the responses
+//                                        of this build (to re-record)
+//
+// Prints one line per request, then PASS or FAIL (exit code 1).
+// Built and run by run_checks.sh.
+
+#include <SimRacingController.h>
+#include <ConfigServer.h>
+
+#define MAX_LINE    512
+#define MAX_BYTES   256
+
+/**
+ * Serial port fed with one request, collecting the responses
+ */
+class LoopbackPort : public Stream {
+    public:
+        const uint8_t* input = nullptr;
+        size_t inputLength = 0;
+        uint8_t output[MAX_BYTES];
+        size_t outputLength = 0;
+
+        int available() override { return inputLength; }
+        int read() override {
+            if (!inputLength) return -1;
+            inputLength--;
+            return *input++;
+        }
+        size_t write(uint8_t value) override {
+            if (outputLength >= sizeof(output)) return 0;
+            output[outputLength++] = value;
+            return 1;
+        }
+};
+
+// Controller the frames were recorded with
+static const int rowPins[2] = {2, 3};
+static const int colPins[2] = {4, 5};
+static const int gpioPins[2] = {6, 7};
+static const int encoderPinsA[1] = {8};
+static const int encoderPinsB[1] = {9};
+
+/**
+ * Parses the hex bytes of a frame line ("> 03 01 ..." or "< ...")
+ * @return Number of bytes
+ */
+static size_t parseHex(const char* text, uint8_t* bytes) {
+    size_t count = 0;
+    unsigned value;
+    int used;
+    while (count < MAX_BYTES && sscanf(text, " %2x%n", &value, &used) == 1) {
+        bytes[count++] = value;
+        text += used;
+    }
+    return count;
+}
+
+static void printHex(const char* prefix, const uint8_t* bytes, size_t length) {
+    printf("%s", prefix);
+    for (size_t i = 0; i < length; i++) {
+        printf(" %02x", bytes[i]);
+    }
+    printf("\n");
+}
+
+int main(int argc, char** argv) {
+    bool record = argc > 1 && strcmp(argv[1], "-r") == 0;
+    const char* path = argc > (record ? 2 : 1) ? argv[record ? 2 : 1] : "config_frames.txt";
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        printf("cannot open %s\nFAIL\n", path);
+        return 1;
+    }
+
+    SimRacingController controller;
+    LoopbackPort port;
+    ConfigServer server(controller, port);
+    hostPins[6] = hostPins[7] = HIGH;
+    controller.setMatrix(rowPins, 2, colPins, 2);
+    controller.setGpio(gpioPins, 2);
+    controller.setEncoders(encoderPinsA, encoderPinsB, 1);
+    controller.setProfiles(2);
+    if (!controller.begin()) {
+        printf("begin() failed\nFAIL\n");
+        return 1;
+    }
+
+    // A block is a name line, the request (> lines), then its recorded
+    // responses (< lines); the request is sent at the end of the block
+    char line[MAX_LINE];
+    char name[MAX_LINE] = "";
+    uint8_t request[MAX_BYTES];
+    uint8_t expected[MAX_BYTES];
+    size_t requestLength = 0;
+    size_t expectedLength = 0;
+    int requests = 0;
+    int failures = 0;
+
+    for (;;) {
+        bool more = fgets(line, sizeof(line), file) != nullptr;
+        if (more && line[0] == '>') {
+            requestLength += parseHex(line + 1, request + requestLength);
+            if (record) printf("%s", line);
+            continue;
+        }
+        if (more && line[0] == '<') {
+            expectedLength += parseHex(line + 1, expected + expectedLength);
+            continue;
+        }
+
+        if (requestLength) {
+            port.input = request;
+            port.inputLength = requestLength;
+            port.outputLength = 0;
+            server.poll();
+            controller.update();
+            requests++;
+
+            if (record) {
+                for (size_t i = 0; i < port.outputLength; i += 16) {
+                    size_t count = port.outputLength - i < 16 ? port.outputLength - i : 16;
+                    printHex("<", port.output + i, count);
+                }
+            } else {
+                bool ok = port.outputLength == expectedLength &&
+                          memcmp(port.output, expected, expectedLength) == 0;
+                printf("%-30s %s\n", name, ok ? "ok" : "FAILED");
+                if (!ok) {
+                    printHex("  expected", expected, expectedLength);
+                    printHex("  received", port.output, port.outputLength);
+                    failures++;
+                }
+            }
+            requestLength = 0;
+            expectedLength = 0;
+        }
+        if (!more) break;
+
+        // Comment, blank line or name of the next request
+        if (record) printf("%s", line);
+        if (line[0] != '#' && line[0] != '\n' && line[0] != '\r') {
+            snprintf(name, sizeof(name), "%s", line);
+            name[strcspn(name, "\r\n")] = 0;
+        }
+    }
+    fclose(file);
+
+    if (record) return 0;
+    printf("%d requests, %d failed\n%s\n", requests, failures,
+           failures || !requests ? "FAIL" : "PASS");
+    return failures || !requests ? 1 : 0;
+}
@@ -0,0 +1,46 @@
+/**************************
+   host.cpp (host checks)
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+volatile uint8_t hostPins[NUM_DIGITAL_PINS];
+volatile uint16_t hostAnalog[NUM_DIGITAL_PINS];
+void (*hostPinModeHook)(uint8_t pin, uint8_t mode) = nullptr;
+TwoWire Wire;
+
+static const std::chrono::steady_clock::time_point hostStart = std::chrono::steady_clock::now();
+static std::atomic<unsigned long> hostOffsetMs(0);
+
+unsigned long micros() {
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - hostStart;
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() +
+           hostOffsetMs * 1000UL;
+}
+
+unsigned long millis() {
+    return micros() / 1000;
+}
+
+void hostAdvanceMillis(unsigned long ms) {
+    hostOffsetMs += ms;
+}
+
+void delay(unsigned long ms) {
+    if (ms == 0) {
+        std::this_thread::yield();
+    } else {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+}
+
+void delayMicroseconds(unsigned int us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
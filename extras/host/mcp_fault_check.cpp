@@ -0,0 +1,162 @@
+/**************************
+   mcp_fault_check.cpp
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+// Host check of the MCP23017 link recovery, driven by the I2C fault hook
+// (setI2cFaultHook()). Two devices at 0x20 and 0x21:
+//   offline    - 0x21 stops answering and goes offline (MCP_ERROR) after
+//                MCP_FAIL_LIMIT failed reads, 0x20 stays online
+//   backoff    - each failed re-probe doubles the interval up to
+//                MCP_RETRY_MAX_MS
+//   re-probe   - once 0x21 answers again it is configured and read again
+//   bus clear  - a slave holding SDA low after a failed read of 0x20 gets
+//                SCL pulses until it lets go, then the bus restarts
+// Prints one line per check, then PASS or FAIL (exit code 1).
+// Built and run by run_checks.sh.
+
+#include <SimRacingController.h>
+#include <Wire.h>
+
+static bool failed = false;
+
+static void report(const char* name, bool ok, unsigned long a, unsigned long b) {
+    printf("%-10s %s (%lu / %lu)\n", name, ok ? "ok" : "FAILED", a, b);
+    failed |= !ok;
+}
+
+/*
+   Simulated faults
+*/
+
+struct Faults {
+    uint8_t address;                // Device with a fault
+    I2cFault fault;                 // Fault of its transactions
+    uint8_t sdaLowChecks;           // Bus checks that still find SDA low
+    uint32_t transactions[2];       // Transactions of 0x20 and 0x21
+};
+
+static Faults faults;
+static uint8_t sclPulses = 0;
+
+static I2cFault injectFault(void* context, uint8_t address) {
+    Faults& f = *static_cast<Faults*>(context);
+    if (address == I2C_FAULT_BUS) {
+        if (!f.sdaLowChecks) return I2C_FAULT_NONE;
+        f.sdaLowChecks--;
+        return I2C_FAULT_SDA_LOW;
+    }
+    f.transactions[address - 0x20]++;
+    return address == f.address ? f.fault : I2C_FAULT_NONE;
+}
+
+// Bus pull-ups: a released line reads high; count SCL pulses
+static void onPinMode(uint8_t pin, uint8_t mode) {
+    if (pin != SDA && pin != SCL) return;
+    if (mode == INPUT_PULLUP) hostPins[pin] = HIGH;
+    if (pin == SCL && mode == OUTPUT) sclPulses++;
+}
+
+/*
+   Checks
+*/
+
+static SimRacingController controller;
+static McpConfig mcpConfigs[2] = {McpConfig(0x20), McpConfig(0x21)};
+
+// One scan a millisecond later (timers and re-probes included)
+static void scan() {
+    hostAdvanceMillis(1);
+    controller.update();
+}
+
+// Lets the re-probe interval of 0x21 pass, then scans (runs the re-probe)
+static void waitForProbe() {
+    unsigned long retryMs = controller.getMcpHealth(1).retryMs;
+    hostAdvanceMillis(retryMs);
+    scan();
+}
+
+static void checkOffline() {
+    faults.address = 0x21;
+    faults.fault = I2C_FAULT_NACK;
+
+    int scans = 0;
+    while (controller.isMcpOnline(1) && scans < 10) {
+        scan();
+        scans++;
+    }
+    McpHealth health = controller.getMcpHealth(1);
+    report("offline", scans == MCP_FAIL_LIMIT && controller.isMcpOnline(0) &&
+           controller.getLastError().code == ControllerError::MCP_ERROR &&
+           health.retryMs == MCP_RETRY_MIN_MS, scans, MCP_FAIL_LIMIT);
+
+    // No traffic to an offline device
+    uint32_t before = faults.transactions[1];
+    scan();
+    if (faults.transactions[1] != before) report("offline", false, faults.transactions[1], before);
+}
+
+static void checkBackoff() {
+    unsigned long expected = MCP_RETRY_MIN_MS;
+    bool doubled = true;
+    while (expected < MCP_RETRY_MAX_MS) {
+        waitForProbe();
+        expected = expected * 2 > MCP_RETRY_MAX_MS ? MCP_RETRY_MAX_MS : expected * 2;
+        doubled &= !controller.isMcpOnline(1) && controller.getMcpHealth(1).retryMs == expected;
+    }
+    waitForProbe();
+    doubled &= controller.getMcpHealth(1).retryMs == MCP_RETRY_MAX_MS;
+    report("backoff", doubled, controller.getMcpHealth(1).retryMs, MCP_RETRY_MAX_MS);
+}
+
+static void checkReprobe() {
+    faults.fault = I2C_FAULT_NONE;
+    waitForProbe();
+    McpHealth health = controller.getMcpHealth(1);
+
+    // Read again from the next scan
+    uint32_t before = faults.transactions[1];
+    scan();
+    report("re-probe", health.online && health.failures == 0 && health.reconnects == 1 &&
+           faults.transactions[1] > before, health.reconnects, 1);
+}
+
+static void checkBusClear() {
+    uint32_t begins = Wire.begins;
+    sclPulses = 0;
+
+    // One failed read of 0x20, with SDA held for the first three pulses
+    faults.address = 0x20;
+    faults.fault = I2C_FAULT_SDA_LOW;
+    faults.sdaLowChecks = 4;
+    scan();
+    faults.fault = I2C_FAULT_NONE;
+    scan();
+
+    McpHealth health = controller.getMcpHealth(0);
+    report("bus clear", sclPulses == 3 && Wire.begins == begins + 1 && health.busClears == 1 &&
+           health.online && health.failures == 0, sclPulses, 3);
+}
+
+int main() {
+    hostPins[SDA] = hostPins[SCL] = HIGH;
+    hostPinModeHook = onPinMode;
+
+    controller.setMcpDevices(mcpConfigs, 2);
+    controller.setI2cFaultHook(injectFault, &faults);
+    if (!controller.begin()) {
+        report("begin", false, 0, 0);
+        return 1;
+    }
+
+    checkOffline();
+    checkBackoff();
+    checkReprobe();
+    checkBusClear();
+
+    printf("%s\n", failed ? "FAIL" : "PASS");
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,25 @@
+#!/bin/sh
+# Builds the library for the host (std::thread scan task) and runs the
+# checks in this folder. Usage: sh extras/host/run_checks.sh [check ...]
+# Needs g++ with C++11 and pthreads.
+
+set -e
+HOST_DIR=$(cd "$(dirname "$0")" && pwd)
+SRC_DIR="$HOST_DIR/../../src"
+CXX=${CXX:-g++}
+BUILD_DIR=$(mktemp -d)
+trap 'rm -rf "$BUILD_DIR"' EXIT
+
+if [ $# -eq 0 ]; then
+    set -- $(cd "$HOST_DIR" && ls *_check.cpp | sed 's/\.cpp$//')
+fi
+
+status=0
+for check in "$@"; do
+    echo "== $check"
+    "$CXX" -std=gnu++11 -O2 -Wall -pthread -I"$HOST_DIR" -I"$SRC_DIR" \
+        "$HOST_DIR/$check.cpp" "$HOST_DIR/host.cpp" "$SRC_DIR"/*.cpp \
+        -o "$BUILD_DIR/$check"
+    (cd "$HOST_DIR" && "$BUILD_DIR/$check") || status=1
+done
+exit $status
@@ -0,0 +1,256 @@
+/**************************
+   scan_task_check.cpp
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+// Host check of the cross-context synchronization (ScanSync.h), with the
+// background scan task running as a std::thread (SCAN_TASK_THREAD):
+//   seqlock    - a reader never keeps a half-written update
+//   try-lock   - two threads never hold the scan lock at once
+// The seqlock reader and the lock holders yield inside their critical
+// section, so the other threads run in the middle of it even on one core.
+//   scan task  - every press is reported while a reader thread calls
+//                readState() and a second thread contends with tryUpdate(),
+//                and the published state matches the pins afterwards
+//   change     - no scan runs between beginChange() and endChange() of the
+//                application while gesture callbacks in the scan task make
+//                changes of their own (setEncoderPosition())
+// Prints one line per check, then PASS or FAIL (exit code 1).
+// Built and run by run_checks.sh.
+
+#include <SimRacingController.h>
+#include <GestureEngine.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#define CHECK_MS          300       // Run time of the seqlock and lock checks
+#define LOCK_THREADS      4
+#define PRESS_CYCLES      40
+#define HOLD_MS           15
+#define CHANGES           200
+
+static bool failed = false;
+
+static std::chrono::steady_clock::time_point deadline() {
+    return std::chrono::steady_clock::now() + std::chrono::milliseconds(CHECK_MS);
+}
+
+static void report(const char* name, bool ok, unsigned long a, unsigned long b) {
+    printf("%-10s %s (%lu / %lu)\n", name, ok ? "ok" : "FAILED", a, b);
+    failed |= !ok;
+}
+
+/*
+   Seqlock
+*/
+
+struct Pair {
+    volatile uint32_t value;
+    volatile uint32_t inverse;
+};
+
+static void checkSeqlock() {
+    Pair pair = {0, 0xFFFFFFFFUL};
+    SeqCounter seq;
+    std::atomic<bool> writing(true);
+    std::atomic<unsigned long> reads(0);
+    unsigned long torn = 0;
+
+    std::thread reader([&]() {
+        while (writing) {
+            uint32_t start;
+            uint32_t value, inverse;
+            do {
+                start = seq.beginRead();
+                value = pair.value;
+                std::this_thread::yield();
+                inverse = pair.inverse;
+            } while (seq.retry(start));
+            if (inverse != ~value) torn++;
+            reads++;
+        }
+    });
+
+    while (reads == 0) std::this_thread::yield();
+    std::chrono::steady_clock::time_point end = deadline();
+    for (uint32_t i = 1; std::chrono::steady_clock::now() < end; i++) {
+        seq.beginWrite();
+        pair.value = i;
+        pair.inverse = ~i;
+        seq.endWrite();
+    }
+    writing = false;
+    reader.join();
+
+    report("seqlock", torn == 0 && reads > 0, torn, (unsigned long)reads);
+}
+
+/*
+   Try-lock
+*/
+
+static void checkTryLock() {
+    ScanLock lock;
+    std::atomic<int> inside(0);
+    std::atomic<unsigned long> overlaps(0);
+    std::atomic<unsigned long> acquired(0);
+    std::atomic<unsigned long> refused(0);
+
+    std::chrono::steady_clock::time_point end = deadline();
+    std::thread threads[LOCK_THREADS];
+    for (int t = 0; t < LOCK_THREADS; t++) {
+        threads[t] = std::thread([&]() {
+            while (std::chrono::steady_clock::now() < end) {
+                if (!lock.tryLock()) {
+                    refused++;
+                    std::this_thread::yield();
+                    continue;
+                }
+                if (inside.fetch_add(1) != 0) overlaps++;
+                acquired++;
+                std::this_thread::yield();
+                inside.fetch_sub(1);
+                lock.unlock();
+            }
+        });
+    }
+    for (int t = 0; t < LOCK_THREADS; t++) {
+        threads[t].join();
+    }
+
+    report("try-lock", overlaps == 0 && acquired > 0 && refused > 0, overlaps, (unsigned long)acquired);
+}
+
+/*
+   Scan task
+*/
+
+static const int gpioPins[2] = {2, 3};
+static unsigned long presses[2];
+static unsigned long releases[2];
+
+static void checkScanTask() {
+    SimRacingController controller;
+    hostPins[2] = hostPins[3] = HIGH;
+    controller.setGpio(gpioPins, 2);
+    controller.setDebounceTime(5, 1);
+    controller.setGpioCallback([](int profile, int gpio, bool state) {
+        if (state) presses[gpio]++;
+        else releases[gpio]++;
+    });
+    if (!controller.begin() || !controller.startScanTask(1)) {
+        report("scan task", false, 0, 0);
+        return;
+    }
+
+    std::atomic<bool> running(true);
+    std::atomic<unsigned long> readerViews(0);
+    std::atomic<unsigned long> contended(0);
+    std::thread reader([&]() {
+        uint32_t words[4];
+        while (running) {
+            if (controller.readState(words)) readerViews++;
+        }
+    });
+    std::thread contender([&]() {
+        while (running) {
+            if (!controller.tryUpdate()) contended++;
+            std::this_thread::yield();
+        }
+    });
+
+    for (int cycle = 0; cycle < PRESS_CYCLES; cycle++) {
+        for (uint8_t level = LOW; level <= HIGH; level++) {
+            hostPins[2] = hostPins[3] = level;
+            for (int ms = 0; ms < HOLD_MS; ms++) {
+                delay(1);
+                controller.processEvents();
+            }
+        }
+    }
+
+    running = false;
+    reader.join();
+    contender.join();
+    controller.stopScanTask();
+    controller.processEvents();
+
+    uint32_t words[4];
+    bool released = controller.readState(words) && (words[0] & 3) == 0;
+    bool counted = true;
+    for (int i = 0; i < 2; i++) {
+        counted &= presses[i] == PRESS_CYCLES && releases[i] == PRESS_CYCLES;
+    }
+    report("scan task", counted && released && controller.getDroppedEvents() == 0,
+           presses[0] + presses[1] + releases[0] + releases[1], 4UL * PRESS_CYCLES);
+    printf("           %lu reader views, %lu tryUpdate() calls found the scan running\n",
+           (unsigned long)readerViews, (unsigned long)contended);
+}
+
+/*
+   Changes from both contexts
+*/
+
+static const int encoderPinA[1] = {4};
+static const int encoderPinB[1] = {5};
+static SimRacingController* changed;
+static std::atomic<unsigned long> taskChanges(0);
+
+static void checkChanges() {
+    SimRacingController controller;
+    GestureEngine gestures(1);
+    changed = &controller;
+    hostPins[2] = hostPins[3] = hostPins[4] = hostPins[5] = HIGH;
+    controller.setGpio(gpioPins, 2);
+    controller.setEncoders(encoderPinA, encoderPinB, nullptr, 1);
+    controller.setProfiles(2);
+    controller.setDebounceTime(5, 1);
+
+    // Held button repeating every millisecond; each repeat changes the
+    // encoder position from the scan task and stays inside its change
+    gestures.addHoldRepeat(GestureInput(SOURCE_GPIO, 0), 1, 1);
+    gestures.setCallback([](int profile, int gesture, GestureType type, uint16_t repeat) {
+        changed->beginChange();
+        changed->setEncoderPosition(0, repeat);
+        delay(1);
+        changed->endChange();
+        taskChanges++;
+    });
+    controller.setGestureEngine(&gestures);
+
+    if (!controller.begin() || !controller.startScanTask(2)) {
+        report("change", false, 0, 0);
+        return;
+    }
+    hostPins[2] = LOW;
+
+    unsigned long violations = 0;
+    for (int i = 0; i < CHANGES; i++) {
+        controller.beginChange();
+        controller.setProfile(i & 1);
+        uint32_t scans = controller.getScanStats().scans;
+        delay(2);
+        if (controller.getScanStats().scans != scans) violations++;
+        controller.endChange();
+        delay(1);
+        controller.processEvents();
+    }
+
+    controller.stopScanTask();
+    hostPins[2] = HIGH;
+    report("change", violations == 0 && taskChanges > 0, violations, CHANGES);
+    printf("           %lu changes from the scan task\n", (unsigned long)taskChanges);
+}
+
+int main() {
+    checkSeqlock();
+    checkTryLock();
+    checkScanTask();
+    checkChanges();
+
+    printf("%s\n", failed ? "FAIL" : "PASS");
+    return failed ? 1 : 0;
+}
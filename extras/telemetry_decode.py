@@ -0,0 +1,194 @@
+#!/usr/bin/env python3
+"""
+telemetry_decode.py
+v 2.1.0
+by roncoa@gmail.com
+
+Decodes the binary telemetry stream of SimRacingController (see src/Telemetry.h).
+
+  telemetry_decode.py /dev/ttyACM0              print frames from a serial port (needs pyserial)
+  telemetry_decode.py COM5 --baud 115200 --record session.bin
+  telemetry_decode.py session.bin               print a recorded stream
+  telemetry_decode.py - < session.bin           read stdin
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+TELEMETRY_VERSION = 1
+
+HELLO, EVENT, STATE, STATS = 0, 1, 2, 3
+
+SOURCES = ["matrix", "gpio", "mcp", "encoder_button", "encoder", "analog", "switch"]
+
+
+def crc16(data):
+    """CRC-16/CCITT, 0xFFFF start (same as ConfigCursor::updateCrc)"""
+    crc = 0xFFFF
+    for value in data:
+        crc ^= value << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            raise ValueError("bad COBS code")
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def describe_event(body):
+    source, profile, index, value, time = struct.unpack("<BBHhI", body)
+    name = SOURCES[source] if source < len(SOURCES) else "source%d" % source
+    if source <= 3:
+        value = "PRESSED" if value else "RELEASED"
+    elif source == 4:
+        value = "CW" if value > 0 else "CCW"
+    return "%10u EVENT   profile %u %s[%u] %s" % (time, profile, name, index, value)
+
+
+def describe_state(body):
+    time, = struct.unpack_from("<I", body, 0)
+    pos = 4
+    count = body[pos]
+    pos += 1
+    encoders = struct.unpack_from("<%di" % count, body, pos)
+    pos += 4 * count
+    count = body[pos]
+    pos += 1
+    axes = struct.unpack_from("<%dH" % count, body, pos)
+    pos += 2 * count
+    count = body[pos]
+    pos += 1
+    switches = ["-" if s == 0xFF else str(s) for s in body[pos:pos + count]]
+    return "%10u STATE   encoders %s analog %s switches %s" % (
+        time, list(encoders), list(axes), "[" + ", ".join(switches) + "]")
+
+
+def describe_stats(body):
+    time, scans, events, total, longest, dropped_events, dropped_frames = struct.unpack("<7I", body)
+    average = total / scans if scans else 0
+    return ("%10u STATS   scans %u events %u avg %.1f us max %u us "
+            "dropped events %u frames %u" %
+            (time, scans, events, average, longest, dropped_events, dropped_frames))
+
+
+class Decoder:
+    def __init__(self):
+        self.buffer = bytearray()
+        self.sequence = None
+        self.lost = 0
+        self.bad = 0
+
+    def feed(self, data):
+        """Returns the lines printed for the complete frames in data"""
+        lines = []
+        self.buffer += data
+        while True:
+            end = self.buffer.find(b"\x00")
+            if end < 0:
+                return lines
+            raw = bytes(self.buffer[:end])
+            del self.buffer[:end + 1]
+            if raw:
+                lines.append(self.frame(raw))
+
+    def frame(self, raw):
+        try:
+            payload = cobs_decode(raw)
+        except ValueError:
+            self.bad += 1
+            return "           BAD     framing"
+        if len(payload) < 4 or crc16(payload[:-2]) != struct.unpack("<H", payload[-2:])[0]:
+            self.bad += 1
+            return "           BAD     CRC"
+
+        kind, sequence = payload[0], payload[1]
+        body = payload[2:-2]
+        if kind & 0x80:
+            # ConfigServer response sharing the port (own sequence numbers)
+            return "           REPLY   command 0x%02x status %u" % (kind & 0x7F, body[0] if body else 0)
+
+        line = ""
+        if self.sequence is not None and kind != HELLO:
+            gap = (sequence - self.sequence - 1) & 0xFF
+            if gap:
+                self.lost += gap
+                line = "           LOST    %u frames\n" % gap
+        self.sequence = sequence
+
+        try:
+            if kind == HELLO:
+                version, time = struct.unpack("<BI", body)
+                note = "" if version == TELEMETRY_VERSION else " (decoder expects %d)" % TELEMETRY_VERSION
+                return line + "%10u HELLO   version %u%s" % (time, version, note)
+            if kind == EVENT:
+                return line + describe_event(body)
+            if kind == STATE:
+                return line + describe_state(body)
+            if kind == STATS:
+                return line + describe_stats(body)
+        except (struct.error, IndexError):
+            self.bad += 1
+            return line + "           BAD     frame type %u length %u" % (kind, len(body))
+        return line + "           UNKNOWN type %u" % kind
+
+
+def open_input(name, baud):
+    if name == "-":
+        return sys.stdin.buffer, False
+    if os.path.isfile(name):
+        return open(name, "rb"), False
+    try:
+        import serial
+    except ImportError:
+        sys.exit("pyserial is needed to read %s (pip install pyserial)" % name)
+    return serial.Serial(name, baud, timeout=0.1), True
+
+
+def main():
+    parser = argparse.ArgumentParser(description="SimRacingController telemetry decoder")
+    parser.add_argument("input", help="serial port, recorded file or - for stdin")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--record", metavar="FILE", help="also save the raw stream")
+    parser.add_argument("--quiet", action="store_true", help="do not print frames")
+    args = parser.parse_args()
+
+    source, live = open_input(args.input, args.baud)
+    record = open(args.record, "wb") if args.record else None
+    decoder = Decoder()
+    try:
+        while True:
+            data = source.read(256)
+            if not data:
+                if live:
+                    continue
+                break
+            if record:
+                record.write(data)
+            for line in decoder.feed(data):
+                if not args.quiet:
+                    print(line)
+    except KeyboardInterrupt:
+        pass
+    finally:
+        if record:
+            record.close()
+    if decoder.lost or decoder.bad:
+        print("lost %u frames, %u bad frames" % (decoder.lost, decoder.bad), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
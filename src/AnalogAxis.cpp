@@ -0,0 +1,212 @@
+/**************************
+   AnalogAxis.cpp
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#include "AnalogAxis.h"
+
+#define ANALOG_INPUT_SHIFT  (16 - ANALOG_ADC_BITS)   // ADC units to 16-bit scale
+
+AnalogAxis::AnalogAxis() :
+    config(),
+    oversampleShift(0),
+    inverted(false),
+    low(0),
+    high(0xFFFF),
+    scale(0),
+    curve(nullptr),
+    curveShift(0),
+    sum(0),
+    count(0),
+    primed(false),
+    filtered(0),
+    speed(0),
+    lastInput(0),
+    value(0) {}
+
+/**
+ * Applies a configuration and clears the filter
+ * @param axisConfig Axis configuration
+ * @return false on invalid oversampling, smoothing, calibration or deadzones
+ */
+bool AnalogAxis::configure(const AnalogAxisConfig& axisConfig) {
+    uint8_t shift = 0;
+    while ((1 << shift) < axisConfig.oversample) {
+        shift++;
+    }
+    if (axisConfig.oversample == 0 || axisConfig.oversample > MAX_ANALOG_OVERSAMPLE ||
+        (1 << shift) != axisConfig.oversample || axisConfig.smoothing > MAX_ANALOG_SMOOTHING ||
+        axisConfig.rawMin > ANALOG_ADC_MAX || axisConfig.rawMax > ANALOG_ADC_MAX ||
+        axisConfig.rawMin == axisConfig.rawMax) {
+        return false;
+    }
+
+    // Calibration and deadzones in the 16-bit scale, ascending
+    uint32_t rawLow = (uint32_t)axisConfig.rawMin << ANALOG_INPUT_SHIFT;
+    uint32_t rawHigh = (uint32_t)axisConfig.rawMax << ANALOG_INPUT_SHIFT;
+    bool invert = rawLow > rawHigh;
+    if (invert) {
+        rawLow = 0xFFFF - rawLow;
+        rawHigh = 0xFFFF - rawHigh;
+    }
+    uint32_t span = rawHigh - rawLow;
+    uint32_t from = rawLow + span * axisConfig.deadzoneLow / ANALOG_MAX;
+    uint32_t to = rawHigh - span * axisConfig.deadzoneHigh / ANALOG_MAX;
+    if (axisConfig.deadzoneLow > ANALOG_MAX || axisConfig.deadzoneHigh > ANALOG_MAX ||
+        to <= from || to > rawHigh) {
+        return false;
+    }
+
+    config = axisConfig;
+    oversampleShift = shift;
+    inverted = invert;
+    low = from;
+    high = to;
+    scale = ((uint32_t)ANALOG_MAX << 16) / (to - from);
+    reset();
+    return true;
+}
+
+/**
+ * Sets a response curve
+ * @param points Output values (0..ANALOG_MAX) at equally spaced travel,
+ *               first at rest, last at full travel (sketch owned)
+ * @param numPoints 2, 3, 5, 9 or 17 points (nullptr / 0 = linear)
+ * @return false on invalid point count
+ */
+bool AnalogAxis::setCurve(const uint16_t* points, uint8_t numPoints) {
+    if (!points || numPoints == 0) {
+        curve = nullptr;
+        return true;
+    }
+
+    uint8_t shift = 0;
+    while ((1 << shift) + 1 < numPoints) {
+        shift++;
+    }
+    if (numPoints > ANALOG_CURVE_MAX_POINTS || (1 << shift) + 1 != numPoints) {
+        return false;
+    }
+
+    curve = points;
+    curveShift = shift;
+    return true;
+}
+
+/**
+ * Adds one ADC reading
+ * @param reading analogRead() result
+ * @return true if a new value is due for reporting (see getValue())
+ */
+bool AnalogAxis::addSample(uint16_t reading) {
+    sum += reading;
+    if (++count < config.oversample) {
+        return false;
+    }
+
+    uint16_t input = (sum << ANALOG_INPUT_SHIFT) >> oversampleShift;
+    sum = 0;
+    count = 0;
+
+    if (!primed) {
+        filtered = (int32_t)input << 8;
+        speed = 0;
+        primed = true;
+    } else if (config.filter == ANALOG_FILTER_NONE) {
+        filtered = (int32_t)input << 8;
+    } else {
+        uint8_t shift = config.smoothing;
+        if (config.filter == ANALOG_FILTER_ADAPTIVE) {
+            // Each doubling of the speed halves the smoothing time
+            int32_t delta = (int32_t)input - lastInput;
+            speed += ((delta < 0 ? -delta : delta) - speed) >> 2;
+            for (uint32_t s = (uint32_t)speed >> ANALOG_ADAPT_SHIFT; s && shift; s >>= 1) {
+                shift--;
+            }
+        }
+        filtered += (((int32_t)input << 8) - filtered) >> shift;
+    }
+    lastInput = input;
+
+    uint16_t output = map((uint32_t)filtered >> 8);
+    if (output == value) {
+        return false;
+    }
+
+    // Reaching either end is always reported
+    uint16_t change = output > value ? output - value : value - output;
+    if (change < config.threshold && output != 0 && output != ANALOG_MAX) {
+        return false;
+    }
+    value = output;
+    return true;
+}
+
+/**
+ * Maps a filtered value to the axis range
+ * @param input Filtered value (16-bit scale)
+ * @return Value 0..ANALOG_MAX
+ */
+uint16_t AnalogAxis::map(uint16_t input) const {
+    if (inverted) {
+        input = 0xFFFF - input;
+    }
+
+    uint16_t output;
+    if (input <= low) {
+        output = 0;
+    } else if (input >= high) {
+        output = ANALOG_MAX;
+    } else {
+        output = ((uint32_t)(input - low) * scale) >> 16;
+    }
+
+    if (curve) {
+        if (output >= ANALOG_MAX) {
+            return curve[1 << curveShift];
+        }
+        // Linear between the two points around the value (4096 steps per range)
+        uint16_t position = (uint32_t)output << curveShift;
+        uint8_t segment = position >> 12;
+        int32_t from = curve[segment];
+        int32_t to = curve[segment + 1];
+        output = from + (((to - from) * (int32_t)(position & 0x0FFF)) >> 12);
+    }
+    return output;
+}
+
+/**
+ * Clears the filter, the next value is reported
+ */
+void AnalogAxis::reset() {
+    sum = 0;
+    count = 0;
+    primed = false;
+    filtered = 0;
+    speed = 0;
+    lastInput = 0;
+    value = 0xFFFF;         // Out of range: first value always differs
+}
+
+/**
+ * @return Current configuration
+ */
+const AnalogAxisConfig& AnalogAxis::getConfig() const {
+    return config;
+}
+
+/**
+ * @return Last decimated reading before filtering (ADC units), for calibration
+ */
+uint16_t AnalogAxis::getReading() const {
+    return lastInput >> ANALOG_INPUT_SHIFT;
+}
+
+/**
+ * @return Last reported value (0..ANALOG_MAX)
+ */
+uint16_t AnalogAxis::getValue() const {
+    return value == 0xFFFF ? 0 : value;
+}
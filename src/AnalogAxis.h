@@ -0,0 +1,110 @@
+/**************************
+   AnalogAxis.h
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#ifndef ANALOG_AXIS_H
+#define ANALOG_AXIS_H
+
+#include <Arduino.h>
+
+/*
+   Analog axes
+
+   Each axis averages `oversample` ADC readings into one value (decimation),
+   filters it, maps it through its calibration, deadzones and optional
+   response curve to 0..ANALOG_MAX and reports it when it moved by at least
+   `threshold`. Everything runs in integer arithmetic (16-bit readings,
+   filter state with 8 fraction bits), divisions only happen when an axis is
+   configured, so a sample costs a few adds, shifts and one multiply besides
+   the ADC conversion itself.
+
+     ANALOG_FILTER_NONE       decimated value as is
+     ANALOG_FILTER_EMA        exponential moving average, alpha = 1 / 2^smoothing
+     ANALOG_FILTER_ADAPTIVE   EMA whose smoothing drops while the axis moves
+                              (one-euro style: smooth at rest, no lag in motion)
+*/
+
+#ifndef ANALOG_ADC_BITS
+#if defined(ARDUINO_ARCH_ESP32)
+#define ANALOG_ADC_BITS     12     // analogRead() resolution
+#else
+#define ANALOG_ADC_BITS     10
+#endif
+#endif
+
+#define ANALOG_ADC_MAX      ((1 << ANALOG_ADC_BITS) - 1)
+#define ANALOG_MAX          4095   // Reported axis range 0..ANALOG_MAX
+#define MAX_ANALOG_AXES     16     // Axes per controller
+#define MAX_ANALOG_OVERSAMPLE 16   // Readings per value
+#define MAX_ANALOG_SMOOTHING 8     // Largest filter shift
+#define ANALOG_CURVE_MAX_POINTS 17 // Response curve points (2, 3, 5, 9 or 17)
+#define ANALOG_ADAPT_SHIFT  8      // Adaptive filter: speed (16-bit scale) of the first smoothing step
+
+enum AnalogFilter {
+    ANALOG_FILTER_NONE = 0,
+    ANALOG_FILTER_EMA = 1,
+    ANALOG_FILTER_ADAPTIVE = 2
+};
+
+/**
+ * Analog axis configuration
+ * rawMin above rawMax inverts the axis
+ */
+struct AnalogAxisConfig {
+    int pin;                 // ADC pin
+    uint16_t rawMin;         // Reading at rest (ADC units)
+    uint16_t rawMax;         // Reading at full travel (ADC units)
+    uint8_t oversample;      // Readings averaged per value (1, 2, 4, 8 or 16)
+    AnalogFilter filter;     // Filter type
+    uint8_t smoothing;       // Filter shift (0 to MAX_ANALOG_SMOOTHING), adaptive: at rest
+    uint16_t threshold;      // Smallest reported change (output units)
+    uint16_t deadzoneLow;    // Travel reported as 0 (output units)
+    uint16_t deadzoneHigh;   // Travel reported as ANALOG_MAX (output units)
+
+    AnalogAxisConfig(int _pin = -1, uint16_t _rawMin = 0, uint16_t _rawMax = ANALOG_ADC_MAX,
+                     uint8_t _oversample = 4, AnalogFilter _filter = ANALOG_FILTER_ADAPTIVE,
+                     uint8_t _smoothing = 4, uint16_t _threshold = 8,
+                     uint16_t _deadzoneLow = 0, uint16_t _deadzoneHigh = 0) :
+        pin(_pin), rawMin(_rawMin), rawMax(_rawMax), oversample(_oversample), filter(_filter),
+        smoothing(_smoothing), threshold(_threshold),
+        deadzoneLow(_deadzoneLow), deadzoneHigh(_deadzoneHigh) {}
+};
+
+class AnalogAxis {
+    private:
+        AnalogAxisConfig config;
+        uint8_t oversampleShift;    // log2(oversample)
+        bool inverted;              // rawMin above rawMax
+        uint16_t low;               // Filtered reading mapped to 0 (16-bit scale)
+        uint16_t high;              // Filtered reading mapped to ANALOG_MAX
+        uint32_t scale;             // ANALOG_MAX / (high - low), 16 fraction bits
+        const uint16_t* curve;      // Response curve (sketch owned, nullptr = linear)
+        uint8_t curveShift;         // log2(curve points - 1)
+
+        uint32_t sum;               // Readings of the current value
+        uint8_t count;
+        bool primed;                // Filter holds a value
+        int32_t filtered;           // Filter state (16-bit scale, 8 fraction bits)
+        int32_t speed;              // Smoothed change per value (adaptive filter)
+        uint16_t lastInput;         // Previous decimated value
+        uint16_t value;             // Last reported value
+
+        uint16_t map(uint16_t input) const;
+
+    public:
+        AnalogAxis();
+
+        bool configure(const AnalogAxisConfig& config);
+        bool setCurve(const uint16_t* points, uint8_t count);
+        bool addSample(uint16_t reading);   // true when the value is to be reported
+        void reset();
+
+        const AnalogAxisConfig& getConfig() const;
+        uint16_t getReading() const;        // Last decimated reading (ADC units)
+        uint16_t getValue() const;          // Last reported value
+};
+
+#endif
@@ -0,0 +1,66 @@
+/**************************
+   Callback.h
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#ifndef CALLBACK_H
+#define CALLBACK_H
+
+#include <Arduino.h>
+
+/*
+   Callbacks with a context
+
+   Holds either a plain function or a function taking a context pointer
+   first, so a callback can reach its own object instead of a global:
+
+     controller.setMatrixCallback([](void* context, int profile, int row, int col, bool state) {
+         static_cast<ButtonBox*>(context)->onMatrix(profile, row, col, state);
+     }, &box);
+
+   A captureless lambda converts to a function pointer and the member call
+   is inlined into it, so a call costs one indirect call as before. Nothing
+   is allocated; the context is owned by the sketch.
+*/
+
+template <typename R, typename... Args>
+class Callback {
+    public:
+        typedef R (*Function)(Args...);
+        typedef R (*ContextFunction)(void* context, Args...);
+
+    private:
+        union {
+            Function function;
+            ContextFunction contextFunction;
+        };
+        void* context;
+        bool hasContext;
+
+    public:
+        Callback() : function(nullptr), context(nullptr), hasContext(false) {}
+
+        void set(Function callback) {
+            function = callback;
+            context = nullptr;
+            hasContext = false;
+        }
+
+        void set(ContextFunction callback, void* callbackContext) {
+            contextFunction = callback;
+            context = callbackContext;
+            hasContext = callback != nullptr;
+        }
+
+        explicit operator bool() const {
+            return hasContext ? contextFunction != nullptr : function != nullptr;
+        }
+
+        R operator()(Args... args) const {
+            return hasContext ? contextFunction(context, args...) : function(args...);
+        }
+};
+
+#endif
@@ -0,0 +1,199 @@
+/**************************
+   ConfigServer.cpp
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#include "ConfigServer.h"
+#include "SimRacingController.h"
+
+ConfigServer::ConfigServer(SimRacingController& controller, Stream& port, ConfigStore* store) :
+    controller(controller),
+    port(port),
+    store(store),
+    received(0),
+    overflow(false) {}
+
+/**
+ * Reads the port and answers every complete request
+ * Call from loop(), like update().
+ * @return Number of requests answered
+ */
+uint8_t ConfigServer::poll() {
+    uint8_t answered = 0;
+
+    while (port.available() > 0) {
+        int value = port.read();
+        if (value < 0) break;
+
+        if (value != 0) {
+            if (received < CONFIG_SERVER_MAX_FRAME) {
+                request[received++] = value;
+            } else {
+                overflow = true;
+            }
+            continue;
+        }
+
+        // Delimiter: corrupted or oversized requests get no answer
+        uint8_t length;
+        if (!overflow && received && decodeFrame(request, received, length) && length >= 2) {
+            port.write(response, handle(length));
+            answered++;
+        }
+        received = 0;
+        overflow = false;
+    }
+    return answered;
+}
+
+/**
+ * Runs one decoded request and builds its response frame
+ * @param length Request payload bytes (command, sequence, arguments)
+ * @return Response bytes to send
+ */
+uint8_t ConfigServer::handle(uint8_t length) {
+    uint8_t count = 0;
+    uint8_t status = execute(request[0], request + 2, length - 2, response + 4, count);
+
+    response[1] = request[0] | 0x80;
+    response[2] = request[1];
+    response[3] = status;
+    return encodeFrame(response, 3 + (status == CONFIG_OK ? count : 0));
+}
+
+/**
+ * Executes a command between two scans
+ * @param command Command (CONFIG_CMD_...)
+ * @param args Arguments
+ * @param length Argument bytes
+ * @param values Receives the returned values
+ * @param count Receives the returned value bytes
+ * @return Status (CONFIG_OK...)
+ */
+uint8_t ConfigServer::execute(uint8_t command, const uint8_t* args, uint8_t length,
+                              uint8_t* values, uint8_t& count) {
+    // Expected argument bytes per command
+    uint8_t expected;
+    switch (command) {
+        case CONFIG_CMD_PING:             expected = length; break;
+        case CONFIG_CMD_INFO:             expected = 0; break;
+        case CONFIG_CMD_GET_FILTER:       expected = 2; break;
+        case CONFIG_CMD_SET_FILTER:       expected = 5; break;
+        case CONFIG_CMD_SET_DEBOUNCE:     expected = 4; break;
+        case CONFIG_CMD_GET_DIVISOR:      expected = 1; break;
+        case CONFIG_CMD_SET_DIVISOR:      expected = 2; break;
+        case CONFIG_CMD_GET_INPUT_FILTER: expected = 3; break;
+        case CONFIG_CMD_SET_INPUT_FILTER: expected = 4; break;
+        case CONFIG_CMD_GET_PROFILE:      expected = 0; break;
+        case CONFIG_CMD_SET_PROFILE:      expected = 1; break;
+        case CONFIG_CMD_SAVE:             expected = 0; break;
+        default:                          return CONFIG_UNKNOWN_COMMAND;
+    }
+    if (length != expected || length > CONFIG_SERVER_MAX_FRAME - 4) {
+        return CONFIG_BAD_LENGTH;
+    }
+
+    uint8_t status = CONFIG_OK;
+    int profile = args[0] == 0xFF ? -1 : args[0];     // -1 = default table
+    uint16_t index = args[1] | (uint16_t)args[2] << 8;
+
+    controller.beginChange();
+    switch (command) {
+        case CONFIG_CMD_PING:
+            memcpy(values, args, length);
+            count = length;
+            break;
+
+        case CONFIG_CMD_INFO:
+            values[0] = CONFIG_PROTOCOL_VERSION;
+            values[1] = controller.getNumProfiles();
+            values[2] = controller.getProfile();
+            values[3] = controller.getNumEncoders();
+            values[4] = controller.getFrameSize();
+            count = 5;
+            break;
+
+        case CONFIG_CMD_GET_FILTER: {
+            if (args[1] >= MAX_FILTER_CLASSES || profile >= controller.getNumProfiles()) {
+                status = CONFIG_INVALID_VALUE;
+                break;
+            }
+            FilterClass filter = controller.getProfileFilterClass(profile, args[1]);
+            values[0] = filter.debounceMs;
+            values[1] = filter.debounceMs >> 8;
+            values[2] = filter.mode;
+            count = 3;
+            break;
+        }
+
+        case CONFIG_CMD_SET_FILTER: {
+            uint16_t ms = args[2] | (uint16_t)args[3] << 8;
+            if (args[4] > DEBOUNCE_EAGER_PRESS ||
+                !controller.setProfileFilterClass(profile, args[1], ms, (DebounceMode)args[4])) {
+                status = CONFIG_INVALID_VALUE;
+            }
+            break;
+        }
+
+        case CONFIG_CMD_SET_DEBOUNCE:
+            controller.setDebounceTime(args[0] | (uint16_t)args[1] << 8,
+                                       args[2] | (uint16_t)args[3] << 8);
+            break;
+
+        case CONFIG_CMD_GET_DIVISOR:
+            if (args[0] >= controller.getNumEncoders()) {
+                status = CONFIG_INVALID_VALUE;
+                break;
+            }
+            values[0] = controller.getEncoderDivisor(args[0]);
+            count = 1;
+            break;
+
+        case CONFIG_CMD_SET_DIVISOR:
+            if (args[0] >= controller.getNumEncoders() || args[1] < 1 || args[1] > 4) {
+                status = CONFIG_INVALID_VALUE;
+                break;
+            }
+            controller.setEncoderDivisor(args[0], args[1]);
+            break;
+
+        case CONFIG_CMD_GET_INPUT_FILTER:
+        case CONFIG_CMD_SET_INPUT_FILTER:
+            if (args[0] >= NUM_INPUT_SOURCES) {
+                status = CONFIG_INVALID_VALUE;
+            } else if (command == CONFIG_CMD_SET_INPUT_FILTER) {
+                if (!controller.setInputFilter((InputSource)args[0], index, args[3])) {
+                    status = CONFIG_INVALID_VALUE;
+                }
+            } else {
+                values[0] = controller.getInputFilter((InputSource)args[0], index);
+                count = 1;
+            }
+            break;
+
+        case CONFIG_CMD_GET_PROFILE:
+            values[0] = controller.getProfile();
+            count = 1;
+            break;
+
+        case CONFIG_CMD_SET_PROFILE:
+            if (profile < 0 || profile >= controller.getNumProfiles()) {
+                status = CONFIG_INVALID_VALUE;
+                break;
+            }
+            controller.setProfile(profile);
+            break;
+
+        case CONFIG_CMD_SAVE:
+            if (!store) {
+                status = CONFIG_NO_STORE;
+            } else if (!controller.saveConfig(*store)) {
+                status = CONFIG_STORE_FAILED;
+            }
+            break;
+    }
+    controller.endChange();
+    return status;
+}
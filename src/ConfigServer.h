@@ -0,0 +1,99 @@
+/**************************
+   ConfigServer.h
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#ifndef CONFIG_SERVER_H
+#define CONFIG_SERVER_H
+
+#include <Arduino.h>
+#include "FrameCodec.h"
+
+class SimRacingController;
+class ConfigStore;
+
+/*
+   Live configuration protocol
+
+   Request/response commands on a serial port to read and change settings
+   of a running controller. Every request is answered by one response;
+   changes apply between two scans (see SimRacingController::beginChange())
+   without begin() and persist on SAVE. extras/config_client.py is the host
+   side.
+
+   Frames (see FrameCodec.h):
+     request   command, sequence, arguments
+     response  command | 0x80, sequence of the request, status, values
+   Responses have bit 7 set in the first byte, so they can share the port
+   with a telemetry stream (types below 0x80). Values are little endian;
+   profile 0xFF selects the default filter table.
+
+     PING             bytes...              -> the same bytes
+     INFO                                   -> version, profiles, profile, encoders, frame words
+     GET_FILTER       profile, class        -> ms (u16), mode
+     SET_FILTER       profile, class, ms (u16), mode
+     SET_DEBOUNCE     button ms (u16), encoder ms (u16)
+     GET_DIVISOR      encoder               -> divisor
+     SET_DIVISOR      encoder, divisor
+     GET_INPUT_FILTER source, index (u16)   -> class
+     SET_INPUT_FILTER source, index (u16), class
+     GET_PROFILE                            -> profile
+     SET_PROFILE      profile
+     SAVE                                   (ConfigStore given to the server)
+*/
+
+#define CONFIG_PROTOCOL_VERSION  1
+#define CONFIG_SERVER_MAX_FRAME  64     // Largest request (encoded bytes)
+
+// Commands
+#define CONFIG_CMD_PING             0x01
+#define CONFIG_CMD_INFO             0x02
+#define CONFIG_CMD_GET_FILTER       0x10
+#define CONFIG_CMD_SET_FILTER       0x11
+#define CONFIG_CMD_SET_DEBOUNCE     0x12
+#define CONFIG_CMD_GET_DIVISOR      0x20
+#define CONFIG_CMD_SET_DIVISOR      0x21
+#define CONFIG_CMD_GET_INPUT_FILTER 0x30
+#define CONFIG_CMD_SET_INPUT_FILTER 0x31
+#define CONFIG_CMD_GET_PROFILE      0x40
+#define CONFIG_CMD_SET_PROFILE      0x41
+#define CONFIG_CMD_SAVE             0x50
+
+// Response status
+#define CONFIG_OK                   0
+#define CONFIG_UNKNOWN_COMMAND      1
+#define CONFIG_BAD_LENGTH           2
+#define CONFIG_INVALID_VALUE        3
+#define CONFIG_NO_STORE             4
+#define CONFIG_STORE_FAILED         5
+
+class ConfigServer {
+    private:
+        SimRacingController& controller;
+        Stream& port;
+        ConfigStore* store;         // SAVE target (nullptr = not supported)
+
+        uint8_t request[CONFIG_SERVER_MAX_FRAME];
+        uint8_t received;           // Request bytes before the delimiter
+        bool overflow;              // Request too long, skipped to the next delimiter
+        uint8_t response[CONFIG_SERVER_MAX_FRAME + FRAME_OVERHEAD];
+
+        uint8_t handle(uint8_t length);
+        uint8_t execute(uint8_t command, const uint8_t* args, uint8_t length,
+                        uint8_t* values, uint8_t& count);
+
+    public:
+        /**
+         * Constructor
+         * @param controller Controller to configure
+         * @param port Serial port
+         * @param store Storage written by SAVE (optional)
+         */
+        ConfigServer(SimRacingController& controller, Stream& port, ConfigStore* store = nullptr);
+
+        uint8_t poll();     // Answers received requests, returns their number
+};
+
+#endif
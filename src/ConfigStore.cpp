@@ -0,0 +1,255 @@
+/**************************
+   ConfigStore.cpp
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#include "ConfigStore.h"
+
+#if defined(CONFIG_HAS_EEPROM)
+#include <EEPROM.h>
+#endif
+
+/*
+   Memory store
+*/
+
+/**
+ * Writable blob in RAM
+ * @param buffer Storage (sketch owned)
+ * @param size Storage size in bytes
+ */
+MemoryConfigStore::MemoryConfigStore(uint8_t* buffer, size_t size) :
+    buffer(buffer),
+    data(buffer),
+    capacity(size),
+    progmem(false) {}
+
+/**
+ * Read only blob
+ * @param data Blob bytes (sketch owned)
+ * @param size Blob size in bytes
+ * @param progmem true if the blob is stored in flash (PROGMEM)
+ */
+MemoryConfigStore::MemoryConfigStore(const uint8_t* data, size_t size, bool progmem) :
+    buffer(nullptr),
+    data(data),
+    capacity(size),
+    progmem(progmem) {}
+
+size_t MemoryConfigStore::size() const {
+    return capacity;
+}
+
+bool MemoryConfigStore::read(size_t offset, uint8_t* out, size_t length) {
+    if (offset > capacity || length > capacity - offset) return false;
+
+    for (size_t i = 0; i < length; i++) {
+        out[i] = progmem ? pgm_read_byte(data + offset + i) : data[offset + i];
+    }
+    return true;
+}
+
+bool MemoryConfigStore::write(size_t offset, const uint8_t* in, size_t length) {
+    if (!buffer || offset > capacity || length > capacity - offset) return false;
+
+    memcpy(buffer + offset, in, length);
+    return true;
+}
+
+/*
+   EEPROM store
+*/
+
+#if defined(CONFIG_HAS_EEPROM)
+/**
+ * Blob in the EEPROM
+ * @param base First EEPROM address used
+ * @param size Bytes reserved for the blob
+ */
+EepromConfigStore::EepromConfigStore(size_t base, size_t size) :
+    base(base),
+    capacity(size),
+    started(false) {}
+
+void EepromConfigStore::start() {
+#if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_ESP8266)
+    if (!started) {
+        EEPROM.begin(base + capacity);
+    }
+#endif
+    started = true;
+}
+
+size_t EepromConfigStore::size() const {
+    return capacity;
+}
+
+bool EepromConfigStore::read(size_t offset, uint8_t* out, size_t length) {
+    if (offset > capacity || length > capacity - offset) return false;
+
+    start();
+    for (size_t i = 0; i < length; i++) {
+        out[i] = EEPROM.read(base + offset + i);
+    }
+    return true;
+}
+
+bool EepromConfigStore::write(size_t offset, const uint8_t* in, size_t length) {
+    if (offset > capacity || length > capacity - offset) return false;
+
+    start();
+    for (size_t i = 0; i < length; i++) {
+#if defined(__AVR__)
+        EEPROM.update(base + offset + i, in[i]);   // Skips unchanged cells
+#else
+        EEPROM.write(base + offset + i, in[i]);
+#endif
+    }
+    return true;
+}
+
+bool EepromConfigStore::commit() {
+#if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_ESP8266)
+    start();
+    return EEPROM.commit();
+#else
+    return true;
+#endif
+}
+#endif
+
+/*
+   File store (host builds)
+*/
+
+#if !defined(ARDUINO)
+/**
+ * Blob in a file
+ * @param path File path (caller owned)
+ * @param size Largest blob written
+ */
+FileConfigStore::FileConfigStore(const char* path, size_t size) :
+    path(path),
+    capacity(size),
+    file(nullptr) {}
+
+FileConfigStore::~FileConfigStore() {
+    commit();
+}
+
+bool FileConfigStore::open(bool create) {
+    if (!file) {
+        file = fopen(path, "r+b");
+    }
+    if (!file && create) {
+        file = fopen(path, "w+b");
+    }
+    return file != nullptr;
+}
+
+size_t FileConfigStore::size() const {
+    return capacity;
+}
+
+bool FileConfigStore::read(size_t offset, uint8_t* out, size_t length) {
+    if (offset > capacity || length > capacity - offset || !open(false)) return false;
+
+    return fseek(file, (long)offset, SEEK_SET) == 0 &&
+           fread(out, 1, length, file) == length;
+}
+
+bool FileConfigStore::write(size_t offset, const uint8_t* in, size_t length) {
+    if (offset > capacity || length > capacity - offset || !open(true)) return false;
+
+    return fseek(file, (long)offset, SEEK_SET) == 0 &&
+           fwrite(in, 1, length, file) == length;
+}
+
+bool FileConfigStore::commit() {
+    if (!file) return true;
+
+    bool done = fclose(file) == 0;
+    file = nullptr;
+    return done;
+}
+#endif
+
+/*
+   Sequential access
+*/
+
+/**
+ * @param store Blob storage
+ * @param position First byte
+ * @param end First byte past the range
+ */
+ConfigCursor::ConfigCursor(ConfigStore& store, size_t position, size_t end) :
+    store(store),
+    position(position),
+    end(end),
+    crc(0xFFFF),
+    ok(true) {}
+
+size_t ConfigCursor::getPosition() const {
+    return position;
+}
+
+void ConfigCursor::seek(size_t to) {
+    position = to;
+}
+
+uint8_t ConfigCursor::readU8() {
+    uint8_t value = 0;
+    if (!ok || position >= end || !store.read(position, &value, 1)) {
+        ok = false;
+        return 0;
+    }
+    position++;
+    crc = updateCrc(crc, value);
+    return value;
+}
+
+uint16_t ConfigCursor::readU16() {
+    uint16_t value = readU8();
+    return value | ((uint16_t)readU8() << 8);
+}
+
+uint32_t ConfigCursor::readU32() {
+    uint32_t value = readU16();
+    return value | ((uint32_t)readU16() << 16);
+}
+
+void ConfigCursor::writeU8(uint8_t value) {
+    if (!ok || position >= end || !store.write(position, &value, 1)) {
+        ok = false;
+        return;
+    }
+    position++;
+    crc = updateCrc(crc, value);
+}
+
+void ConfigCursor::writeU16(uint16_t value) {
+    writeU8(value);
+    writeU8(value >> 8);
+}
+
+void ConfigCursor::writeU32(uint32_t value) {
+    writeU16(value);
+    writeU16(value >> 16);
+}
+
+/**
+ * CRC-16/CCITT step
+ * @param crc Current CRC
+ * @param value Next byte
+ * @return Updated CRC
+ */
+uint16_t ConfigCursor::updateCrc(uint16_t crc, uint8_t value) {
+    crc ^= (uint16_t)value << 8;
+    for (uint8_t bit = 0; bit < 8; bit++) {
+        crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+    return crc;
+}
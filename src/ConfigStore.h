@@ -0,0 +1,160 @@
+/**************************
+   ConfigStore.h
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#ifndef CONFIG_STORE_H
+#define CONFIG_STORE_H
+
+#include <Arduino.h>
+
+#if !defined(ARDUINO)
+#include <stdio.h>
+#endif
+
+/*
+   Configuration blob storage
+
+   SimRacingController::saveConfig() writes the whole layout (pins, MCP
+   devices, encoders, profiles, debounce filter tables, analog inputs) as
+   one binary blob, loadConfig() / begin(store) applies it again. The blob
+   lives in a ConfigStore: RAM or flash (MemoryConfigStore), EEPROM
+   (EepromConfigStore) or a file on host builds (FileConfigStore).
+
+   Format (little endian):
+     header   "SRCF", version, reserved, section bytes (u16), CRC-16 (u16)
+     sections tag (u8), payload bytes (u16), payload
+   The CRC (CCITT, 0xFFFF start) covers the sections. Unknown tags are
+   skipped, so newer blobs load on older code as far as it understands them.
+*/
+
+#define CONFIG_VERSION      1
+#define CONFIG_HEADER_SIZE  10
+#define CONFIG_MAX_SIZE     4096   // Largest blob accepted
+
+// Section tags
+#define CONFIG_PROFILES     1      // numProfiles (u8)
+#define CONFIG_MATRIX       2      // rows, cols, row pins, column pins (u8 each)
+#define CONFIG_GPIO         3      // count, pins (u8 each)
+#define CONFIG_MCP          4      // count, {address, flags (1 = pullups, 2 = interrupts), INT pin}
+#define CONFIG_ENCODERS     5      // count, {pin A, pin B, button pin (0xFF = none), divisor}
+#define CONFIG_FILTERS      6      // profile (0xFF = default table), MAX_FILTER_CLASSES x {ms (u16), mode}
+#define CONFIG_INPUT_FILTERS 7     // count (u16), filter class per input (u8)
+#define CONFIG_SYSTEM       8      // I2C clock (u32), power save ms (u32, 0 = off), analog period (u8)
+#define CONFIG_ANALOG       9      // count, {pin, min, max (u16), oversample, filter, smoothing,
+                                   //         threshold, deadzone low, deadzone high (u16)}
+#define CONFIG_LADDERS      10     // count, {pin, positions, hysteresis (u16), settle ms,
+                                   //         custom levels (u8), levels (u16 each if custom)}
+#define CONFIG_INPUT_DEBOUNCE 11   // count (u16), debounce ms per button (u8, 0 = filter class time)
+
+/**
+ * Byte storage of a configuration blob
+ */
+class ConfigStore {
+    public:
+        virtual ~ConfigStore() {}
+
+        virtual size_t size() const = 0;    // Capacity in bytes
+        virtual bool read(size_t offset, uint8_t* data, size_t length) = 0;
+        virtual bool write(size_t offset, const uint8_t* data, size_t length) = 0;
+        virtual bool commit() { return true; }  // Makes written bytes persistent
+};
+
+/**
+ * Blob in RAM (read/write) or flash (read only)
+ */
+class MemoryConfigStore : public ConfigStore {
+    private:
+        uint8_t* buffer;            // Writable storage (nullptr = read only)
+        const uint8_t* data;
+        size_t capacity;
+        bool progmem;               // Data stored in flash
+
+    public:
+        MemoryConfigStore(uint8_t* buffer, size_t size);
+        MemoryConfigStore(const uint8_t* data, size_t size, bool progmem = false);
+
+        size_t size() const;
+        bool read(size_t offset, uint8_t* data, size_t length);
+        bool write(size_t offset, const uint8_t* data, size_t length);
+};
+
+#if defined(__AVR__) || defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_ESP8266)
+#define CONFIG_HAS_EEPROM
+
+/**
+ * Blob in the EEPROM (emulated in flash on ESP32/ESP8266)
+ */
+class EepromConfigStore : public ConfigStore {
+    private:
+        size_t base;                // First EEPROM address
+        size_t capacity;
+        bool started;               // EEPROM.begin() called (ESP)
+
+        void start();
+
+    public:
+        EepromConfigStore(size_t base = 0, size_t size = 512);
+
+        size_t size() const;
+        bool read(size_t offset, uint8_t* data, size_t length);
+        bool write(size_t offset, const uint8_t* data, size_t length);
+        bool commit();
+};
+#endif
+
+#if !defined(ARDUINO)
+/**
+ * Blob in a file (host builds)
+ */
+class FileConfigStore : public ConfigStore {
+    private:
+        const char* path;
+        size_t capacity;
+        FILE* file;                 // Open from the first access to commit()
+
+        bool open(bool create);
+
+    public:
+        FileConfigStore(const char* path, size_t size = CONFIG_MAX_SIZE);
+        ~FileConfigStore();
+
+        size_t size() const;
+        bool read(size_t offset, uint8_t* data, size_t length);
+        bool write(size_t offset, const uint8_t* data, size_t length);
+        bool commit();              // Flushes and closes the file
+};
+#endif
+
+/**
+ * Sequential blob access with CRC, used by the controller
+ * A failed access clears ok; the values read after it are 0.
+ */
+class ConfigCursor {
+    private:
+        ConfigStore& store;
+        size_t position;
+        size_t end;                 // First byte past the readable/writable range
+
+    public:
+        uint16_t crc;
+        bool ok;
+
+        ConfigCursor(ConfigStore& store, size_t position, size_t end);
+
+        size_t getPosition() const;
+        void seek(size_t position);
+
+        uint8_t readU8();
+        uint16_t readU16();
+        uint32_t readU32();
+        void writeU8(uint8_t value);
+        void writeU16(uint16_t value);
+        void writeU32(uint32_t value);
+
+        static uint16_t updateCrc(uint16_t crc, uint8_t value);
+};
+
+#endif
@@ -0,0 +1,167 @@
+/**************************
+   DeadlineQueue.cpp
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#include "DeadlineQueue.h"
+
+DeadlineQueue::DeadlineQueue() :
+    deadlines(nullptr),
+    positions(nullptr),
+    heap(nullptr),
+    capacity(0),
+    count(0) {}
+
+DeadlineQueue::~DeadlineQueue() {
+    delete[] deadlines;
+    delete[] positions;
+    delete[] heap;
+}
+
+/**
+ * Allocates timers, all idle
+ * @param numTimers Number of timers
+ * @return true if successful, false if too many timers
+ */
+bool DeadlineQueue::begin(uint16_t numTimers) {
+    if (numTimers >= DEADLINE_NONE) {
+        return false;
+    }
+
+    if (numTimers != capacity) {
+        delete[] deadlines;
+        delete[] positions;
+        delete[] heap;
+        capacity = numTimers;
+        deadlines = new unsigned long[capacity]();
+        positions = new uint16_t[capacity];
+        heap = new uint16_t[capacity];
+    }
+
+    clear();
+    return true;
+}
+
+/**
+ * Cancels all timers
+ */
+void DeadlineQueue::clear() {
+    for (uint16_t i = 0; i < capacity; i++) {
+        positions[i] = DEADLINE_NONE;
+    }
+    count = 0;
+}
+
+/*
+   Heap Helpers
+*/
+
+bool DeadlineQueue::before(uint16_t a, uint16_t b) const {
+    return (long)(deadlines[a] - deadlines[b]) < 0;
+}
+
+void DeadlineQueue::place(uint16_t pos, uint16_t id) {
+    heap[pos] = id;
+    positions[id] = pos;
+}
+
+void DeadlineQueue::siftUp(uint16_t pos) {
+    uint16_t id = heap[pos];
+    while (pos > 0) {
+        uint16_t parent = (pos - 1) / 2;
+        if (!before(id, heap[parent])) break;
+        place(pos, heap[parent]);
+        pos = parent;
+    }
+    place(pos, id);
+}
+
+void DeadlineQueue::siftDown(uint16_t pos) {
+    uint16_t id = heap[pos];
+    while (true) {
+        uint16_t child = pos * 2 + 1;
+        if (child >= count) break;
+        if (child + 1 < count && before(heap[child + 1], heap[child])) child++;
+        if (!before(heap[child], id)) break;
+        place(pos, heap[child]);
+        pos = child;
+    }
+    place(pos, id);
+}
+
+void DeadlineQueue::removeAt(uint16_t pos) {
+    uint16_t id = heap[pos];
+    positions[id] = DEADLINE_NONE;
+    count--;
+    if (pos == count) return;
+
+    uint16_t moved = heap[count];
+    place(pos, moved);
+    siftDown(pos);
+    siftUp(positions[moved]);
+}
+
+/*
+   Timers
+*/
+
+/**
+ * Schedules or moves a timer
+ * @param id Timer id
+ * @param deadline Expiry time (ms)
+ */
+void DeadlineQueue::schedule(uint16_t id, unsigned long deadline) {
+    if (id >= capacity) return;
+
+    deadlines[id] = deadline;
+    if (positions[id] == DEADLINE_NONE) {
+        place(count, id);
+        count++;
+        siftUp(count - 1);
+    } else {
+        siftUp(positions[id]);
+        siftDown(positions[id]);
+    }
+}
+
+/**
+ * Cancels a timer (no effect if idle)
+ * @param id Timer id
+ */
+void DeadlineQueue::cancel(uint16_t id) {
+    if (id < capacity && positions[id] != DEADLINE_NONE) {
+        removeAt(positions[id]);
+    }
+}
+
+bool DeadlineQueue::isScheduled(uint16_t id) const {
+    return id < capacity && positions[id] != DEADLINE_NONE;
+}
+
+/**
+ * @return Deadline of a timer (last scheduled value if idle)
+ */
+unsigned long DeadlineQueue::getDeadline(uint16_t id) const {
+    return id < capacity ? deadlines[id] : 0;
+}
+
+uint16_t DeadlineQueue::size() const {
+    return count;
+}
+
+/**
+ * Removes the earliest expired timer
+ * @param now Current time (ms)
+ * @param id Expired timer id
+ * @return false if no timer is due
+ */
+bool DeadlineQueue::pop(unsigned long now, uint16_t& id) {
+    if (count == 0 || (long)(now - deadlines[heap[0]]) < 0) {
+        return false;
+    }
+    id = heap[0];
+    removeAt(0);
+    return true;
+}
@@ -0,0 +1,55 @@
+/**************************
+   DeadlineQueue.h
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#ifndef DEADLINE_QUEUE_H
+#define DEADLINE_QUEUE_H
+
+#include <Arduino.h>
+
+/*
+   Pending deadlines
+
+   Indexed binary min-heap of timers identified by a number in
+   [0, numTimers). Only scheduled timers are in the heap, so checking for
+   expired deadlines costs O(1) when nothing is due and O(log n) per
+   expiring timer. Rescheduling a timer moves it in place.
+
+   Deadlines are compared with wrap-around arithmetic (millis() rollover),
+   they must lie within 24 days of each other.
+*/
+
+#define DEADLINE_NONE   0xFFFF      // Heap position of an idle timer
+
+class DeadlineQueue {
+    private:
+        unsigned long* deadlines;   // Deadline per timer
+        uint16_t* positions;        // Heap position per timer (DEADLINE_NONE = idle)
+        uint16_t* heap;             // Timer ids, earliest first
+        uint16_t capacity;          // Number of timers
+        uint16_t count;             // Scheduled timers
+
+        bool before(uint16_t a, uint16_t b) const;
+        void place(uint16_t pos, uint16_t id);
+        void siftUp(uint16_t pos);
+        void siftDown(uint16_t pos);
+        void removeAt(uint16_t pos);
+
+    public:
+        DeadlineQueue();
+        ~DeadlineQueue();
+
+        bool begin(uint16_t numTimers);   // Allocates and clears all timers
+        void schedule(uint16_t id, unsigned long deadline);
+        void cancel(uint16_t id);
+        void clear();
+        bool isScheduled(uint16_t id) const;
+        unsigned long getDeadline(uint16_t id) const;
+        uint16_t size() const;
+        bool pop(unsigned long now, uint16_t& id);   // Next expired timer
+};
+
+#endif
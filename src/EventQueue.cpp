@@ -0,0 +1,108 @@
+/**************************
+   EventQueue.cpp
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#include "EventQueue.h"
+
+#if defined(__AVR__)
+#define EQ_LOAD(index)              (index)
+#define EQ_LOAD_ACQUIRE(index)      (index)
+#define EQ_STORE_RELEASE(index, v)  do { __asm__ __volatile__("" ::: "memory"); (index) = (v); } while (0)
+#define EQ_MAX_SIZE                 255
+#else
+#define EQ_LOAD(index)              (index).load(std::memory_order_relaxed)
+#define EQ_LOAD_ACQUIRE(index)      (index).load(std::memory_order_acquire)
+#define EQ_STORE_RELEASE(index, v)  (index).store((v), std::memory_order_release)
+#define EQ_MAX_SIZE                 65535
+#endif
+
+EventQueue::EventQueue() :
+    head(0),
+    tail(0),
+    slots(nullptr),
+    capacity(0),
+    dropped(0) {}
+
+EventQueue::~EventQueue() {
+    delete[] slots;
+}
+
+/**
+ * Allocates the queue
+ * @param size Maximum number of queued events
+ * @return true if successful, false on invalid size
+ */
+bool EventQueue::begin(uint16_t size) {
+    if (size == 0 || size >= EQ_MAX_SIZE) {
+        return false;
+    }
+
+    if (size + 1 != capacity) {
+        delete[] slots;
+        capacity = size + 1;
+        slots = new ControllerEvent[capacity];
+    }
+
+    EQ_STORE_RELEASE(head, 0);
+    EQ_STORE_RELEASE(tail, 0);
+    dropped = 0;
+    return true;
+}
+
+/**
+ * Appends an event (producer side)
+ * @param event Event to copy
+ * @return false if the queue is full (event dropped)
+ */
+bool EventQueue::push(const ControllerEvent& event) {
+    if (!slots) return false;
+
+    uint16_t at = EQ_LOAD(tail);
+    uint16_t next = (at + 1) % capacity;
+    if (next == EQ_LOAD_ACQUIRE(head)) {
+        dropped++;
+        return false;
+    }
+
+    slots[at] = event;
+    EQ_STORE_RELEASE(tail, next);
+    return true;
+}
+
+/**
+ * Removes the oldest event (consumer side)
+ * @param event Receives the event
+ * @return false if the queue is empty
+ */
+bool EventQueue::pop(ControllerEvent& event) {
+    if (!slots) return false;
+
+    uint16_t at = EQ_LOAD(head);
+    if (at == EQ_LOAD_ACQUIRE(tail)) {
+        return false;
+    }
+
+    event = slots[at];
+    EQ_STORE_RELEASE(head, (at + 1) % capacity);
+    return true;
+}
+
+/**
+ * @return Number of queued events
+ */
+uint16_t EventQueue::size() const {
+    if (!slots) return 0;
+    uint16_t h = EQ_LOAD_ACQUIRE(head);
+    uint16_t t = EQ_LOAD_ACQUIRE(tail);
+    return (t + capacity - h) % capacity;
+}
+
+/**
+ * @return Events dropped because the queue was full
+ */
+uint32_t EventQueue::getDropped() const {
+    return dropped;
+}
@@ -0,0 +1,62 @@
+/**************************
+   EventQueue.h
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#ifndef EVENT_QUEUE_H
+#define EVENT_QUEUE_H
+
+#include <Arduino.h>
+
+#if !defined(__AVR__)
+#include <atomic>
+#endif
+
+/*
+   Input events
+
+   Lock-free single producer / single consumer ring used by the background
+   scan task: the scan pushes, the application pops. A full queue drops the
+   new event and counts it.
+*/
+
+/**
+ * One reported input change
+ */
+struct ControllerEvent {
+    uint8_t source;          // InputSource (SOURCE_ENCODER = rotation)
+    uint8_t profile;         // Active profile when the change was reported
+    uint16_t index;          // Input index (matrix: row * numCols + col, MCP: device * 16 + pin)
+    int16_t value;           // 1 = pressed, 0 = released, rotation: 1 = CW, -1 = CCW, analog value
+    unsigned long time;      // Scan time (ms)
+
+    ControllerEvent() : source(0), profile(0), index(0), value(0), time(0) {}
+};
+
+class EventQueue {
+    private:
+#if defined(__AVR__)
+        volatile uint8_t head;      // Next slot to pop (single byte: atomic)
+        volatile uint8_t tail;      // Next slot to push
+#else
+        std::atomic<uint16_t> head; // Next slot to pop
+        std::atomic<uint16_t> tail; // Next slot to push
+#endif
+        ControllerEvent* slots;
+        uint16_t capacity;          // Slots (one stays free)
+        uint32_t dropped;           // Events lost on a full queue
+
+    public:
+        EventQueue();
+        ~EventQueue();
+
+        bool begin(uint16_t size);  // Allocates and empties (not while in use)
+        bool push(const ControllerEvent& event);   // Producer
+        bool pop(ControllerEvent& event);          // Consumer
+        uint16_t size() const;
+        uint32_t getDropped() const;
+};
+
+#endif
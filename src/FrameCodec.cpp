@@ -0,0 +1,56 @@
+/**************************
+   FrameCodec.cpp
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#include "FrameCodec.h"
+#include "ConfigStore.h"
+
+uint8_t encodeFrame(uint8_t* frame, uint8_t length) {
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 1; i <= length; i++) {
+        crc = ConfigCursor::updateCrc(crc, frame[i]);
+    }
+    frame[length + 1] = crc;
+    frame[length + 2] = crc >> 8;
+    length += 2;
+
+    // Each 0x00 becomes the distance to the next one (or to the end)
+    uint8_t code = 0;
+    for (uint8_t i = 1; i <= length; i++) {
+        if (frame[i] == 0) {
+            frame[code] = i - code;
+            code = i;
+        }
+    }
+    frame[code] = length + 1 - code;
+    frame[length + 1] = 0;
+    return length + 2;
+}
+
+bool decodeFrame(uint8_t* frame, uint8_t size, uint8_t& length) {
+    uint8_t in = 0;
+    uint8_t out = 0;
+    while (in < size) {
+        uint8_t code = frame[in];
+        if (code == 0 || in + code > size) return false;
+
+        for (uint8_t i = 1; i < code; i++) {
+            frame[out++] = frame[in + i];
+        }
+        in += code;
+        if (code < 0xFF && in < size) {
+            frame[out++] = 0;
+        }
+    }
+    if (out < 2) return false;
+
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 0; i + 2 < out; i++) {
+        crc = ConfigCursor::updateCrc(crc, frame[i]);
+    }
+    length = out - 2;
+    return frame[length] == (crc & 0xFF) && frame[length + 1] == (crc >> 8);
+}
@@ -0,0 +1,44 @@
+/**************************
+   FrameCodec.h
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#ifndef FRAME_CODEC_H
+#define FRAME_CODEC_H
+
+#include <Arduino.h>
+
+/*
+   Serial frames
+
+   Shared by the telemetry stream and the configuration protocol:
+     COBS(payload, CRC-16) 0x00
+   COBS removes every 0x00 from the frame, so the delimiter always marks
+   a frame end and a reader resynchronizes on the next one. The CRC is
+   CCITT with a 0xFFFF start (same as the configuration blob), little endian.
+*/
+
+#define FRAME_MAX_PAYLOAD   250    // Payload bytes (COBS without 0xFF blocks)
+#define FRAME_OVERHEAD      4      // COBS code byte, CRC, delimiter
+
+/**
+ * Encodes a frame in place
+ * @param frame Buffer: frame[0] free, payload from frame[1],
+ *        room for FRAME_OVERHEAD bytes past the payload
+ * @param length Payload bytes (at most FRAME_MAX_PAYLOAD)
+ * @return Bytes to send (length + FRAME_OVERHEAD)
+ */
+uint8_t encodeFrame(uint8_t* frame, uint8_t length);
+
+/**
+ * Decodes a received frame in place and checks its CRC
+ * @param frame Received bytes without the delimiter, receives the payload
+ * @param size Received bytes
+ * @param length Receives the payload bytes
+ * @return false on invalid encoding or CRC
+ */
+bool decodeFrame(uint8_t* frame, uint8_t size, uint8_t& length);
+
+#endif
@@ -0,0 +1,312 @@
+/**************************
+   GestureEngine.cpp
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#include "GestureEngine.h"
+
+/*
+   Constructor
+   @param maxGestures Maximum number of gestures
+*/
+GestureEngine::GestureEngine(uint8_t maxGestures) :
+    gestures(new Gesture[maxGestures]),
+    maxGestures(maxGestures),
+    numGestures(0),
+    numArmed(0),
+    nextDeadline(0),
+    callback() {}
+
+GestureEngine::~GestureEngine() {
+    delete[] gestures;
+}
+
+/*
+   Gesture Definition
+*/
+
+/**
+ * Adds a single input gesture
+ * @return Gesture id, -1 if full
+ */
+int GestureEngine::add(GestureType type, GestureInput input, unsigned long timeMs,
+                       unsigned long intervalMs) {
+    if (numGestures >= maxGestures) return -1;
+
+    Gesture& g = gestures[numGestures];
+    g.type = type;
+    g.input = input;
+    g.inputs = nullptr;
+    g.numInputs = 0;
+    g.timeMs = timeMs;
+    g.intervalMs = intervalMs;
+    g.armed = false;
+    g.deadline = 0;
+    g.startTime = 0;
+    g.heldMask = 0;
+    g.waiting = false;
+    g.repeat = 0;
+    return numGestures++;
+}
+
+/**
+ * Adds a long press
+ * @param input Input
+ * @param holdMs Hold time (ms)
+ * @return Gesture id, -1 if full
+ */
+int GestureEngine::addLongPress(GestureInput input, unsigned long holdMs) {
+    return add(GESTURE_LONG_PRESS, input, holdMs, 0);
+}
+
+/**
+ * Adds a double tap
+ * @param input Input
+ * @param gapMs Maximum time between the two presses (ms)
+ * @return Gesture id, -1 if full
+ */
+int GestureEngine::addDoubleTap(GestureInput input, unsigned long gapMs) {
+    return add(GESTURE_DOUBLE_TAP, input, gapMs, 0);
+}
+
+/**
+ * Adds a hold repeat
+ * @param input Input
+ * @param delayMs Time to the first repeat (ms)
+ * @param intervalMs Time between repeats (ms, > 0)
+ * @return Gesture id, -1 if full or invalid
+ */
+int GestureEngine::addHoldRepeat(GestureInput input, unsigned long delayMs,
+                                 unsigned long intervalMs) {
+    if (intervalMs == 0) return -1;
+    return add(GESTURE_HOLD_REPEAT, input, delayMs, intervalMs);
+}
+
+/**
+ * Adds a chord
+ * @param inputs Chord inputs (kept by reference)
+ * @param count Number of inputs (2 to GESTURE_MAX_CHORD)
+ * @param windowMs Maximum time between first and last press (ms, 0 = no limit)
+ * @return Gesture id, -1 if full or invalid
+ */
+int GestureEngine::addChord(const GestureInput* inputs, uint8_t count, unsigned long windowMs) {
+    if (!inputs || count < 2 || count > GESTURE_MAX_CHORD) return -1;
+
+    int id = add(GESTURE_CHORD, inputs[0], windowMs, 0);
+    if (id >= 0) {
+        gestures[id].inputs = inputs;
+        gestures[id].numInputs = count;
+    }
+    return id;
+}
+
+/**
+ * Removes all gestures
+ */
+void GestureEngine::clear() {
+    numGestures = 0;
+    numArmed = 0;
+}
+
+void GestureEngine::setCallback(GestureCallback cb) {
+    callback.set(cb);
+}
+
+void GestureEngine::setCallback(GestureContextCallback cb, void* context) {
+    callback.set(cb, context);
+}
+
+uint8_t GestureEngine::getGestureCount() const {
+    return numGestures;
+}
+
+/**
+ * @return true if a timed gesture is pending
+ */
+bool GestureEngine::isPending() const {
+    return numArmed > 0;
+}
+
+/**
+ * Gets the time update() has to run next
+ * May be earlier than needed after a cancelled deadline
+ * @param deadline Earliest deadline (ms)
+ * @return false if nothing is pending
+ */
+bool GestureEngine::getNextDeadline(unsigned long& deadline) const {
+    deadline = nextDeadline;
+    return numArmed > 0;
+}
+
+/*
+   Deadlines
+*/
+
+void GestureEngine::arm(Gesture& g, unsigned long deadline) {
+    if (!g.armed) {
+        g.armed = true;
+        numArmed++;
+    }
+    g.deadline = deadline;
+    if (numArmed == 1 || (long)(deadline - nextDeadline) < 0) {
+        nextDeadline = deadline;
+    }
+}
+
+/**
+ * Cancels a deadline
+ * nextDeadline may stay early, update() then rescans once
+ */
+void GestureEngine::disarm(Gesture& g) {
+    if (g.armed) {
+        g.armed = false;
+        numArmed--;
+    }
+}
+
+void GestureEngine::findNextDeadline() {
+    bool found = false;
+    for (uint8_t i = 0; i < numGestures; i++) {
+        if (gestures[i].armed &&
+            (!found || (long)(gestures[i].deadline - nextDeadline) < 0)) {
+            nextDeadline = gestures[i].deadline;
+            found = true;
+        }
+    }
+}
+
+void GestureEngine::fire(int profile, uint8_t id, uint16_t repeat) {
+    if (callback) {
+        callback(profile, id, gestures[id].type, repeat);
+    }
+}
+
+/*
+   Evaluation
+*/
+
+/**
+ * Handles a debounced input edge
+ * @param source Input source
+ * @param index Input index
+ * @param state New state (true = pressed)
+ * @param now Edge time (ms)
+ * @param profile Active profile
+ */
+void GestureEngine::processEdge(InputSource source, uint16_t index, bool state,
+                                unsigned long now, int profile) {
+    for (uint8_t id = 0; id < numGestures; id++) {
+        Gesture& g = gestures[id];
+
+        if (g.type == GESTURE_CHORD) {
+            for (uint8_t k = 0; k < g.numInputs; k++) {
+                if (g.inputs[k].source != source || g.inputs[k].index != index) continue;
+
+                uint8_t bit = 1 << k;
+                if (state) {
+                    if (!g.heldMask) {
+                        g.startTime = now;
+                        g.waiting = false;
+                    }
+                    g.heldMask |= bit;
+                    uint8_t full = (uint8_t)((1U << g.numInputs) - 1);
+                    if (g.heldMask == full && !g.waiting &&
+                        (g.timeMs == 0 || now - g.startTime <= g.timeMs)) {
+                        g.waiting = true;   // Fire once until all inputs are released
+                        fire(profile, id, 1);
+                    }
+                } else {
+                    g.heldMask &= ~bit;
+                }
+            }
+            continue;
+        }
+
+        if (g.input.source != source || g.input.index != index) continue;
+
+        switch (g.type) {
+            case GESTURE_LONG_PRESS:
+                if (state) arm(g, now + g.timeMs);
+                else disarm(g);
+                break;
+
+            case GESTURE_HOLD_REPEAT:
+                if (state) {
+                    g.repeat = 0;
+                    arm(g, now + g.timeMs);
+                } else {
+                    disarm(g);
+                }
+                break;
+
+            case GESTURE_DOUBLE_TAP:
+                if (!state) break;
+                if (g.waiting && now - g.startTime <= g.timeMs) {
+                    g.waiting = false;
+                    disarm(g);
+                    fire(profile, id, 1);
+                } else {
+                    g.waiting = true;
+                    g.startTime = now;
+                    arm(g, now + g.timeMs);
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+/**
+ * Fires expired deadlines, called once per scan
+ * @param now Scan time (ms)
+ * @param profile Active profile
+ */
+void GestureEngine::update(unsigned long now, int profile) {
+    if (numArmed == 0 || (long)(now - nextDeadline) < 0) return;
+
+    for (uint8_t id = 0; id < numGestures; id++) {
+        Gesture& g = gestures[id];
+        if (!g.armed || (long)(now - g.deadline) < 0) continue;
+
+        switch (g.type) {
+            case GESTURE_LONG_PRESS:
+                disarm(g);
+                fire(profile, id, 1);
+                break;
+
+            case GESTURE_HOLD_REPEAT:
+                g.deadline += g.intervalMs;
+                if ((long)(now - g.deadline) >= 0) {
+                    g.deadline = now + g.intervalMs;    // Late scan, skip missed repeats
+                }
+                fire(profile, id, ++g.repeat);
+                break;
+
+            case GESTURE_DOUBLE_TAP:
+                g.waiting = false;                      // Second tap too late
+                disarm(g);
+                break;
+
+            default:
+                disarm(g);
+                break;
+        }
+    }
+    findNextDeadline();
+}
+
+/**
+ * Cancels everything pending (inputs treated as released)
+ */
+void GestureEngine::reset() {
+    for (uint8_t id = 0; id < numGestures; id++) {
+        gestures[id].armed = false;
+        gestures[id].waiting = false;
+        gestures[id].heldMask = 0;
+    }
+    numArmed = 0;
+}
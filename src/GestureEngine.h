@@ -0,0 +1,119 @@
+/**************************
+   GestureEngine.h
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#ifndef GESTURE_ENGINE_H
+#define GESTURE_ENGINE_H
+
+#include "SimRacingController.h"
+
+/*
+   Gesture recognition
+
+   The engine is driven by SimRacingController: every debounced edge of a
+   matrix, GPIO, MCP or encoder button input is passed to processEdge(),
+   and update() runs once per scan to fire timed gestures. Timed gestures
+   keep a deadline; update() only compares the scan time with the earliest
+   deadline, so a scan with nothing pending costs the same regardless of
+   the number of gestures.
+
+     Long press    input held for holdMs (fires once per press)
+     Double tap    second press within gapMs of the first
+     Hold repeat   fires after delayMs, then every intervalMs while held
+     Chord         all inputs held, pressed within windowMs (0 = any time)
+
+   The plain input callbacks keep firing for inputs used in gestures.
+*/
+
+#define GESTURE_MAX_CHORD   8   // Inputs per chord
+
+enum GestureType {
+    GESTURE_LONG_PRESS = 0,
+    GESTURE_DOUBLE_TAP = 1,
+    GESTURE_HOLD_REPEAT = 2,
+    GESTURE_CHORD = 3
+};
+
+/**
+ * Input reference (matrix index: row * numCols + col, MCP: device * 16 + pin)
+ */
+struct GestureInput {
+    InputSource source;
+    uint16_t index;
+
+    GestureInput(InputSource s = SOURCE_MATRIX, uint16_t i = 0) : source(s), index(i) {}
+};
+
+class GestureEngine {
+    public:
+        /**
+         * Gesture callback
+         * @param profile Active profile
+         * @param gesture Gesture id returned by add...()
+         * @param type Gesture type
+         * @param repeat Repeat count (hold repeat), otherwise 1
+         */
+        typedef void (*GestureCallback)(int profile, int gesture, GestureType type, uint16_t repeat);
+        typedef void (*GestureContextCallback)(void* context, int profile, int gesture,
+                                               GestureType type, uint16_t repeat);
+
+    private:
+        struct Gesture {
+            GestureType type;
+            GestureInput input;             // Single input gestures
+            const GestureInput* inputs;     // Chord inputs (sketch owned)
+            uint8_t numInputs;              // Chord size
+            unsigned long timeMs;           // holdMs, gapMs, delayMs or windowMs
+            unsigned long intervalMs;       // Hold repeat interval
+            bool armed;                     // Deadline pending
+            unsigned long deadline;         // Next timed event
+            unsigned long startTime;        // First press (double tap, chord)
+            uint8_t heldMask;               // Chord inputs held
+            bool waiting;                   // Double tap: first tap seen, chord: fired
+            uint16_t repeat;                // Hold repeat count
+        };
+
+        Gesture* gestures;
+        uint8_t maxGestures;
+        uint8_t numGestures;
+        uint8_t numArmed;                   // Gestures with a deadline
+        unsigned long nextDeadline;         // Earliest deadline
+        Callback<void, int, int, GestureType, uint16_t> callback;
+
+        int add(GestureType type, GestureInput input, unsigned long timeMs,
+                unsigned long intervalMs);
+        void arm(Gesture& g, unsigned long deadline);
+        void disarm(Gesture& g);
+        void fire(int profile, uint8_t id, uint16_t repeat);
+        void findNextDeadline();
+
+    public:
+        /**
+         * Constructor
+         * @param maxGestures Maximum number of gestures
+         */
+        GestureEngine(uint8_t maxGestures = 16);
+        ~GestureEngine();
+
+        int addLongPress(GestureInput input, unsigned long holdMs);
+        int addDoubleTap(GestureInput input, unsigned long gapMs);
+        int addHoldRepeat(GestureInput input, unsigned long delayMs, unsigned long intervalMs);
+        int addChord(const GestureInput* inputs, uint8_t count, unsigned long windowMs = 0);
+        void clear();
+        void setCallback(GestureCallback callback);
+        void setCallback(GestureContextCallback callback, void* context);
+        uint8_t getGestureCount() const;
+        bool isPending() const;
+        bool getNextDeadline(unsigned long& deadline) const;
+
+        // Called by the controller
+        void processEdge(InputSource source, uint16_t index, bool state,
+                         unsigned long now, int profile);
+        void update(unsigned long now, int profile);
+        void reset();
+};
+
+#endif
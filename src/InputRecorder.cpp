@@ -0,0 +1,445 @@
+/**************************
+   InputRecorder.cpp
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#include "InputRecorder.h"
+
+static const uint8_t DUMP_MAGIC[4] = {'S', 'R', 'C', 'R'};
+static const size_t DUMP_HEADER_SIZE = 4 + 1 + 1 + 4 + 4 + 4;
+
+/*
+   Constructor - Recording starts when the controller calls begin()
+   @param buffer Storage for recorded frames
+   @param size Storage size in bytes
+*/
+InputRecorder::InputRecorder(uint8_t* buffer, size_t size) :
+    buffer(buffer),
+    capacity(size),
+    head(0),
+    tail(0),
+    used(0),
+    numWords(0),
+    baseWords(nullptr),
+    lastWords(nullptr),
+    baseTime(0),
+    lastTime(0),
+    hasBase(false),
+    recording(true),
+    lastRunPos(0),
+    lastRunDt(0),
+    lastRunKind(0),
+    lastRunValid(false),
+    frameCount(0),
+    droppedFrames(0) {}
+
+InputRecorder::~InputRecorder() {
+    delete[] baseWords;
+    delete[] lastWords;
+}
+
+/**
+ * Allocates frame storage and clears the buffer
+ * @param frameSize Words per frame
+ * @return true if successful, false if the frame is too large
+ */
+bool InputRecorder::begin(uint8_t frameSize) {
+    if (frameSize > INPUT_RECORDER_MAX_WORDS) {
+        numWords = 0;
+        return false;
+    }
+
+    if (frameSize != numWords) {
+        delete[] baseWords;
+        delete[] lastWords;
+        numWords = frameSize;
+        baseWords = new uint32_t[numWords]();
+        lastWords = new uint32_t[numWords]();
+    }
+
+    clear();
+    return true;
+}
+
+/**
+ * Discards all recorded frames
+ */
+void InputRecorder::clear() {
+    head = tail = used = 0;
+    hasBase = false;
+    lastRunValid = false;
+    frameCount = 0;
+    droppedFrames = 0;
+}
+
+void InputRecorder::pause() {
+    recording = false;
+    lastRunValid = false;
+}
+
+void InputRecorder::resume() {
+    recording = true;
+}
+
+bool InputRecorder::isRecording() const {
+    return recording;
+}
+
+/*
+   Ring Buffer Helpers
+*/
+
+void InputRecorder::put(uint8_t value) {
+    buffer[head] = value;
+    head = (head + 1) % capacity;
+    used++;
+}
+
+void InputRecorder::putVarint(uint32_t value) {
+    while (value >= 0x80) {
+        put((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    put((uint8_t)value);
+}
+
+uint8_t InputRecorder::peek(size_t offset) const {
+    return buffer[(tail + offset) % capacity];
+}
+
+uint32_t InputRecorder::peekVarint(size_t& offset) const {
+    uint32_t value = 0;
+    uint8_t shift = 0;
+    uint8_t b;
+    do {
+        b = peek(offset++);
+        value |= (uint32_t)(b & 0x7F) << shift;
+        shift += 7;
+    } while ((b & 0x80) && shift < 35);
+    return value;
+}
+
+/**
+ * @return Encoded size of a varint
+ */
+uint8_t InputRecorder::varintSize(uint32_t value) {
+    uint8_t bytes = 1;
+    while (value >= 0x80) {
+        value >>= 7;
+        bytes++;
+    }
+    return bytes;
+}
+
+/**
+ * Drops old records until the requested space is free
+ * @param bytes Bytes needed
+ * @return false if the record can never fit
+ */
+bool InputRecorder::makeRoom(size_t bytes) {
+    if (bytes > capacity) return false;
+    while (capacity - used < bytes) {
+        dropOldest();
+    }
+    return true;
+}
+
+/**
+ * Folds the oldest record into the base frame
+ */
+void InputRecorder::dropOldest() {
+    size_t start = peek(0) == 0x80 ? 2 : 0;     // Frame kind prefix
+    size_t offset = start + 1;
+    uint8_t header = peek(start);
+    uint32_t frames;
+
+    if (header & 0x80) {
+        baseTime += peekVarint(offset);
+        for (uint8_t n = header & 0x7F; n > 0; n--) {
+            uint8_t index = peek(offset++);
+            baseWords[index] ^= peekVarint(offset);
+        }
+        frames = 1;
+    } else {
+        frames = (header & 0x3F) + 1;
+        unsigned long dt = (header & 0x40) ? 0 : peekVarint(offset);
+        baseTime += dt * frames;
+    }
+
+    if (lastRunValid && lastRunPos == (tail + start) % capacity) {
+        lastRunValid = false;
+    }
+
+    tail = (tail + offset) % capacity;
+    used -= offset;
+    frameCount -= frames;
+    droppedFrames += frames;
+}
+
+/*
+   Recording
+*/
+
+/**
+ * Records one frame
+ * @param time Frame time (ms)
+ * @param words Frame words
+ * @param kind Frame kind (FrameKind, 0 = complete scan)
+ */
+void InputRecorder::record(unsigned long time, const uint32_t* words, uint8_t kind) {
+    if (!recording || !numWords || !capacity) return;
+
+    if (!hasBase) {
+        for (uint8_t i = 0; i < numWords; i++) {
+            baseWords[i] = lastWords[i] = words[i];
+        }
+        baseTime = lastTime = time;
+        hasBase = true;
+        frameCount = 1;
+        return;
+    }
+
+    unsigned long dt = time - lastTime;
+    uint8_t changed = 0;
+    uint8_t prefix = kind ? 2 : 0;
+    size_t bytes = prefix + 1 + varintSize(dt);
+    for (uint8_t i = 0; i < numWords; i++) {
+        uint32_t diff = words[i] ^ lastWords[i];
+        if (diff) {
+            changed++;
+            bytes += 1 + varintSize(diff);
+        }
+    }
+
+    if (changed == 0) {
+        // Extend the current run of unchanged frames
+        if (lastRunValid && lastRunDt == dt && lastRunKind == kind &&
+            (buffer[lastRunPos] & 0x3F) < 0x3F) {
+            buffer[lastRunPos]++;
+        } else {
+            if (dt == 0) bytes = prefix + 1;
+            if (!makeRoom(bytes)) {
+                droppedFrames++;
+                return;
+            }
+            if (kind) {
+                put(0x80);
+                put(kind);
+            }
+            lastRunPos = head;
+            lastRunDt = dt;
+            lastRunKind = kind;
+            lastRunValid = true;
+            if (dt == 0) {
+                put(0x40);
+            } else {
+                put(0x00);
+                putVarint(dt);
+            }
+        }
+    } else {
+        if (!makeRoom(bytes)) {
+            droppedFrames++;
+            return;
+        }
+        lastRunValid = false;
+        if (kind) {
+            put(0x80);
+            put(kind);
+        }
+        put(0x80 | changed);
+        putVarint(dt);
+        for (uint8_t i = 0; i < numWords; i++) {
+            uint32_t diff = words[i] ^ lastWords[i];
+            if (diff) {
+                put(i);
+                putVarint(diff);
+                lastWords[i] = words[i];
+            }
+        }
+    }
+
+    lastTime = time;
+    frameCount++;
+}
+
+/**
+ * Writes the recording in binary form
+ * @param out Output (e.g. Serial)
+ * @return Bytes written
+ */
+size_t InputRecorder::dump(Print& out) const {
+    uint8_t header[DUMP_HEADER_SIZE];
+    uint32_t fields[3] = {(uint32_t)baseTime, frameCount, (uint32_t)used};
+
+    memcpy(header, DUMP_MAGIC, 4);
+    header[4] = INPUT_RECORDER_VERSION;
+    header[5] = numWords;
+    for (uint8_t f = 0; f < 3; f++) {
+        for (uint8_t b = 0; b < 4; b++) {
+            header[6 + f * 4 + b] = (uint8_t)(fields[f] >> (b * 8));
+        }
+    }
+
+    size_t written = out.write(header, DUMP_HEADER_SIZE);
+    for (uint8_t i = 0; i < numWords; i++) {
+        uint32_t word = hasBase ? baseWords[i] : 0;
+        for (uint8_t b = 0; b < 4; b++) {
+            written += out.write((uint8_t)(word >> (b * 8)));
+        }
+    }
+
+    // Records (ring buffer may wrap)
+    size_t first = (tail + used <= capacity) ? used : capacity - tail;
+    if (first) written += out.write(buffer + tail, first);
+    if (used > first) written += out.write(buffer, used - first);
+    return written;
+}
+
+uint32_t InputRecorder::getFrameCount() const {
+    return frameCount;
+}
+
+uint32_t InputRecorder::getDroppedFrames() const {
+    return droppedFrames;
+}
+
+size_t InputRecorder::getUsedBytes() const {
+    return used;
+}
+
+/*
+   Replay
+*/
+
+/*
+   Constructor
+   @param data Dump bytes
+   @param size Dump size in bytes
+   @param progmem true if the dump is stored in flash (PROGMEM)
+*/
+InputReplayer::InputReplayer(const uint8_t* data, size_t size, bool progmem) :
+    data(data),
+    size(size),
+    progmem(progmem),
+    numWords(0),
+    pos(0),
+    recordsEnd(0),
+    time(0),
+    baseSent(false),
+    runLeft(0),
+    runDt(0),
+    kind(0) {}
+
+uint8_t InputReplayer::byteAt(size_t index) const {
+    return progmem ? pgm_read_byte(data + index) : data[index];
+}
+
+uint32_t InputReplayer::readLe32(size_t index) const {
+    return (uint32_t)byteAt(index) | ((uint32_t)byteAt(index + 1) << 8) |
+           ((uint32_t)byteAt(index + 2) << 16) | ((uint32_t)byteAt(index + 3) << 24);
+}
+
+uint32_t InputReplayer::readVarint() {
+    uint32_t value = 0;
+    uint8_t shift = 0;
+    uint8_t b;
+    do {
+        if (pos >= recordsEnd) return value;
+        b = byteAt(pos++);
+        value |= (uint32_t)(b & 0x7F) << shift;
+        shift += 7;
+    } while ((b & 0x80) && shift < 35);
+    return value;
+}
+
+/**
+ * Validates the dump header and rewinds to the first frame
+ * @return true if the dump is valid
+ */
+bool InputReplayer::begin() {
+    if (size < DUMP_HEADER_SIZE) return false;
+    for (uint8_t i = 0; i < 4; i++) {
+        if (byteAt(i) != DUMP_MAGIC[i]) return false;
+    }
+    // Version 1 dumps hold complete scans only
+    if (byteAt(4) < 1 || byteAt(4) > INPUT_RECORDER_VERSION) return false;
+
+    numWords = byteAt(5);
+    size_t recordsStart = DUMP_HEADER_SIZE + (size_t)numWords * 4;
+    recordsEnd = recordsStart + readLe32(14);
+    if (recordsEnd > size) return false;
+
+    pos = recordsStart;
+    time = readLe32(6);
+    baseSent = false;
+    runLeft = 0;
+    kind = 0;
+    return true;
+}
+
+uint8_t InputReplayer::getFrameSize() const {
+    return numWords;
+}
+
+uint32_t InputReplayer::getFrameCount() const {
+    return size >= DUMP_HEADER_SIZE ? readLe32(10) : 0;
+}
+
+/**
+ * Produces the next frame
+ * words must be the same buffer on every call, the first frame fills it
+ * @param frameTime Frame time (ms)
+ * @param words Frame words (getFrameSize() entries)
+ * @return false when the dump is exhausted
+ */
+bool InputReplayer::next(unsigned long& frameTime, uint32_t* words) {
+    if (!baseSent) {
+        for (uint8_t i = 0; i < numWords; i++) {
+            words[i] = readLe32(DUMP_HEADER_SIZE + i * 4);
+        }
+        baseSent = true;
+        frameTime = time;
+        return true;
+    }
+
+    if (runLeft == 0) {
+        if (pos >= recordsEnd) return false;
+
+        uint8_t header = byteAt(pos++);
+        kind = 0;
+        if (header == 0x80 && pos + 1 < recordsEnd) {
+            kind = byteAt(pos++);
+            header = byteAt(pos++);
+        }
+        if (header & 0x80) {
+            time += readVarint();
+            for (uint8_t n = header & 0x7F; n > 0 && pos < recordsEnd; n--) {
+                uint8_t index = byteAt(pos++);
+                uint32_t diff = readVarint();
+                if (index < numWords) {
+                    words[index] ^= diff;
+                }
+            }
+            frameTime = time;
+            return true;
+        }
+
+        runLeft = (header & 0x3F) + 1;
+        runDt = (header & 0x40) ? 0 : readVarint();
+    }
+
+    runLeft--;
+    time += runDt;
+    frameTime = time;
+    return true;
+}
+
+/**
+ * @return Kind of the last frame returned by next() (FrameKind, 0 = complete scan)
+ */
+uint8_t InputReplayer::getFrameKind() const {
+    return kind;
+}
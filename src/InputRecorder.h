@@ -0,0 +1,127 @@
+/**************************
+   InputRecorder.h
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#ifndef INPUT_RECORDER_H
+#define INPUT_RECORDER_H
+
+#include <Arduino.h>
+
+/*
+   Raw input capture
+
+   The recorder logs every frame scanned by SimRacingController (matrix
+   rows, GPIO, MCP ports, encoder A/B and encoder buttons) into a ring
+   buffer supplied by the sketch. Encoder samples taken between scan words
+   are frames of their own. Frames are delta encoded against the previous
+   frame:
+
+     00cccccc dt        c+1 unchanged frames, each dt ms after the previous
+     01cccccc           c+1 unchanged frames in the same millisecond
+     1nnnnnnn dt {i x}  n changed words, word i XOR x (dt and x are varints)
+     10000000 k         the next record holds frames of kind k (FrameKind),
+                        records without it hold complete scans
+
+   When the buffer is full the oldest records are folded into the base
+   frame, so the buffer always holds the most recent history.
+
+   Dump format (little endian):
+     "SRCR", version, frame size, base time (u32), frame count (u32),
+     record bytes (u32), base frame (u32 per word), records
+*/
+
+#define INPUT_RECORDER_VERSION    2
+#define INPUT_RECORDER_MAX_WORDS  127   // Changed words per record
+
+class InputRecorder {
+    private:
+        uint8_t* buffer;            // Ring buffer (sketch owned)
+        size_t capacity;            // Ring buffer size
+        size_t head;                // Next write position
+        size_t tail;                // Oldest record
+        size_t used;                // Bytes in use
+
+        uint8_t numWords;           // Words per frame
+        uint32_t* baseWords;        // Frame before the oldest record
+        uint32_t* lastWords;        // Last recorded frame
+        unsigned long baseTime;     // Time of the base frame
+        unsigned long lastTime;     // Time of the last frame
+        bool hasBase;               // Base frame captured
+        bool recording;             // Recording enabled
+
+        size_t lastRunPos;          // Header of the last unchanged-frame run
+        unsigned long lastRunDt;    // Time step of the last run
+        uint8_t lastRunKind;        // Frame kind of the last run
+        bool lastRunValid;          // Last record is an extendable run
+
+        uint32_t frameCount;        // Frames held (base included)
+        uint32_t droppedFrames;     // Frames folded into the base
+
+        void put(uint8_t value);
+        void putVarint(uint32_t value);
+        uint8_t peek(size_t offset) const;
+        uint32_t peekVarint(size_t& offset) const;
+        bool makeRoom(size_t bytes);
+        void dropOldest();
+
+    public:
+        /**
+         * Constructor
+         * @param buffer Storage for recorded frames
+         * @param size Storage size in bytes
+         */
+        InputRecorder(uint8_t* buffer, size_t size);
+        ~InputRecorder();
+
+        bool begin(uint8_t frameSize);    // Called by the controller
+        void record(unsigned long time, const uint32_t* words, uint8_t kind = 0);
+        void clear();
+        void pause();
+        void resume();
+        bool isRecording() const;
+
+        size_t dump(Print& out) const;    // Binary dump
+        uint32_t getFrameCount() const;
+        uint32_t getDroppedFrames() const;
+        size_t getUsedBytes() const;
+
+        static uint8_t varintSize(uint32_t value);
+};
+
+/**
+ * Replays a recorder dump frame by frame
+ * Feed each frame to SimRacingController::processFrame()
+ */
+class InputReplayer {
+    private:
+        const uint8_t* data;        // Dump bytes
+        size_t size;                // Dump size
+        bool progmem;               // Dump stored in flash
+
+        uint8_t numWords;           // Words per frame
+        size_t pos;                 // Read position
+        size_t recordsEnd;          // End of records
+        unsigned long time;         // Current frame time
+        bool baseSent;              // Base frame returned
+        uint8_t runLeft;            // Frames left in current run
+        unsigned long runDt;        // Time step of current run
+        uint8_t kind;               // Frame kind of current record
+
+        uint8_t byteAt(size_t index) const;
+        uint32_t readLe32(size_t index) const;
+        uint32_t readVarint();
+
+    public:
+        InputReplayer(const uint8_t* data, size_t size, bool progmem = false);
+
+        bool begin();                     // Validates the header
+        uint8_t getFrameSize() const;
+        uint32_t getFrameCount() const;
+        bool next(unsigned long& frameTime, uint32_t* words);
+        uint8_t getFrameKind() const;     // Kind of the frame from next()
+};
+
+#endif
@@ -0,0 +1,200 @@
+/**************************
+   KeyMacro.h
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#ifndef KEY_MACRO_H
+#define KEY_MACRO_H
+
+#include <Arduino.h>
+
+/*
+   Compile-time key macros
+
+   Key sequences such as "{ALT}{LEFT}" or "{SHIFT}l" are compiled by the
+   C++ compiler into a zero-terminated array of key codes stored in flash:
+
+       KEY_MACRO(ACC_EngagePitLimiter, "{ALT}l");
+
+   Every byte is an Arduino Keyboard key code (ASCII for printable
+   characters, 0x80-0x87 for modifiers, 0xB0+ for special keys), so the
+   player only has to forward bytes to press()/release(). Unknown tokens,
+   unterminated braces and non printable characters fail the build.
+
+   Only C++11 constexpr is used, so the default AVR toolchain is enough.
+*/
+
+// Modifier key codes (same values as Keyboard.h)
+#define KEY_MACRO_FIRST_MODIFIER  0x80
+#define KEY_MACRO_LAST_MODIFIER   0x87
+
+/**
+ * Compiled key macro
+ * Zero-terminated array of key codes
+ */
+template <unsigned N>
+struct KeyMacroCode {
+    uint8_t codes[N];
+};
+
+namespace KeyMacroCompiler {
+
+    /**
+     * Token name to key code mapping
+     */
+    struct Token {
+        const char* name;
+        uint8_t code;
+    };
+
+    constexpr Token TOKENS[] = {
+        // Modifiers (held until the end of the macro)
+        {"CTRL", 0x80},  {"SHIFT", 0x81},  {"ALT", 0x82},  {"GUI", 0x83},
+        {"RCTRL", 0x84}, {"RSHIFT", 0x85}, {"RALT", 0x86}, {"RGUI", 0x87},
+        // Navigation
+        {"UP", 0xDA},    {"DOWN", 0xD9},   {"LEFT", 0xD8}, {"RIGHT", 0xD7},
+        {"INS", 0xD1},   {"DEL", 0xD4},    {"HOME", 0xD2}, {"END", 0xD5},
+        {"PGUP", 0xD3},  {"PGDN", 0xD6},
+        // Editing
+        {"ENTER", 0xB0}, {"ESC", 0xB1},    {"BKSP", 0xB2}, {"TAB", 0xB3},
+        {"SPACE", ' '},  {"CAPS", 0xC1},
+        // Function keys
+        {"F1", 0xC2},    {"F2", 0xC3},     {"F3", 0xC4},   {"F4", 0xC5},
+        {"F5", 0xC6},    {"F6", 0xC7},     {"F7", 0xC8},   {"F8", 0xC9},
+        {"F9", 0xCA},    {"F10", 0xCB},    {"F11", 0xCC},  {"F12", 0xCD}
+    };
+
+    constexpr unsigned NUM_TOKENS = sizeof(TOKENS) / sizeof(TOKENS[0]);
+
+    // Never defined: reaching it while compiling a macro stops the build
+    uint8_t unknownKeyToken();
+
+    /**
+     * Checks if the token starting at pos is exactly name followed by '}'
+     */
+    constexpr bool matches(const char* s, unsigned pos, const char* name) {
+        return *name == '\0' ? s[pos] == '}'
+             : (s[pos] == *name && matches(s, pos + 1, name + 1));
+    }
+
+    constexpr uint8_t lookup(const char* s, unsigned pos, unsigned index) {
+        return index >= NUM_TOKENS ? unknownKeyToken()
+             : matches(s, pos, TOKENS[index].name) ? TOKENS[index].code
+             : lookup(s, pos, index + 1);
+    }
+
+    /**
+     * Position of the closing brace of the token starting at pos
+     */
+    constexpr unsigned closeBrace(const char* s, unsigned pos) {
+        return (s[pos] == '}' || s[pos] == '\0') ? pos : closeBrace(s, pos + 1);
+    }
+
+    /**
+     * Position of the element following the one at pos
+     */
+    constexpr unsigned next(const char* s, unsigned pos) {
+        return s[pos] == '{' ? closeBrace(s, pos) + 1 : pos + 1;
+    }
+
+    /**
+     * Key code of the element at pos
+     */
+    constexpr uint8_t codeOf(const char* s, unsigned pos) {
+        return s[pos] == '{' ? lookup(s, pos + 1, 0)
+             : (s[pos] >= ' ' && s[pos] <= '~') ? (uint8_t)s[pos]
+             : unknownKeyToken();
+    }
+
+    /**
+     * Number of key codes produced by the macro text
+     */
+    constexpr unsigned length(const char* s, unsigned pos = 0) {
+        return s[pos] == '\0' ? 0 : 1 + length(s, next(s, pos));
+    }
+
+    /**
+     * Key code number n of the macro text (0 past the end)
+     */
+    constexpr uint8_t codeAt(const char* s, unsigned n, unsigned pos = 0) {
+        return s[pos] == '\0' ? 0
+             : n == 0 ? codeOf(s, pos)
+             : codeAt(s, n - 1, next(s, pos));
+    }
+
+    // Index sequence (no STL on AVR)
+    template <unsigned... I> struct Indices {};
+    template <unsigned N, unsigned... I>
+    struct BuildIndices : BuildIndices<N - 1, N - 1, I...> {};
+    template <unsigned... I>
+    struct BuildIndices<0, I...> { typedef Indices<I...> type; };
+
+    template <unsigned... I>
+    constexpr KeyMacroCode<sizeof...(I)> compile(const char* s, Indices<I...>) {
+        return KeyMacroCode<sizeof...(I)>{{ codeAt(s, I)... }};
+    }
+}
+
+/**
+ * Declares a compiled key macro stored in flash
+ * @param name Macro identifier
+ * @param text Key sequence, e.g. "{SHIFT}t" or "PRTSIM{ENTER}"
+ */
+#define KEY_MACRO(name, text) \
+    constexpr KeyMacroCode<KeyMacroCompiler::length(text) + 1> name PROGMEM = \
+        KeyMacroCompiler::compile(text, \
+            KeyMacroCompiler::BuildIndices<KeyMacroCompiler::length(text) + 1>::type())
+
+/**
+ * Key macro player
+ * Plays compiled macros on any keyboard object providing
+ * press(uint8_t), release(uint8_t) and releaseAll()
+ * (Keyboard on AVR, USBHIDKeyboard on ESP32)
+ */
+template <typename Keyboard>
+class KeyMacroPlayer {
+    private:
+        Keyboard& keyboard;
+        unsigned long keyDelay;     // Delay after each key press (ms)
+
+    public:
+        KeyMacroPlayer(Keyboard& kb, unsigned long keyDelayMs = 0) :
+            keyboard(kb), keyDelay(keyDelayMs) {}
+
+        void setKeyDelay(unsigned long keyDelayMs) {
+            keyDelay = keyDelayMs;
+        }
+
+        /**
+         * Plays a compiled macro
+         * Modifiers stay pressed, keys are tapped, the last key stays
+         * pressed until releaseAll()
+         * @param codes Zero-terminated key codes in flash
+         */
+        void play(const uint8_t* codes) {
+            uint8_t code = pgm_read_byte(codes);
+            while (code) {
+                uint8_t nextCode = pgm_read_byte(++codes);
+                keyboard.press(code);
+                if (keyDelay) delay(keyDelay);
+                if (nextCode && (code < KEY_MACRO_FIRST_MODIFIER ||
+                                 code > KEY_MACRO_LAST_MODIFIER)) {
+                    keyboard.release(code);
+                }
+                code = nextCode;
+            }
+        }
+
+        template <unsigned N>
+        void play(const KeyMacroCode<N>& macro) {
+            play(macro.codes);
+        }
+
+        void releaseAll() {
+            keyboard.releaseAll();
+        }
+};
+
+#endif
@@ -0,0 +1,126 @@
+/**************************
+   LadderSwitch.cpp
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#include "LadderSwitch.h"
+
+LadderSwitch::LadderSwitch() :
+    config(),
+    descending(false),
+    slot(LADDER_NONE),
+    candidate(LADDER_NONE),
+    candidateTime(0) {}
+
+/**
+ * Applies a configuration and builds the threshold table
+ * @param switchConfig Switch configuration
+ * @return false on invalid position count, levels or hysteresis
+ */
+bool LadderSwitch::configure(const LadderSwitchConfig& switchConfig) {
+    uint8_t count = switchConfig.positions;
+    if (count < 2 || count > MAX_LADDER_POSITIONS) {
+        return false;
+    }
+
+    // Level of each position in ascending reading order
+    uint16_t levels[MAX_LADDER_POSITIONS];
+    bool down = switchConfig.levels && switchConfig.levels[0] > switchConfig.levels[count - 1];
+    for (uint8_t i = 0; i < count; i++) {
+        if (!switchConfig.levels) {
+            levels[i] = (uint32_t)ANALOG_ADC_MAX * i / (count - 1);
+        } else {
+            levels[i] = switchConfig.levels[down ? count - 1 - i : i];
+        }
+    }
+
+    // Boundaries halfway between levels, each band wider than the hysteresis
+    for (uint8_t i = 0; i + 1 < count; i++) {
+        if (levels[i + 1] <= levels[i] ||
+            (uint32_t)(levels[i + 1] - levels[i]) <= 2 * (uint32_t)switchConfig.hysteresis) {
+            return false;
+        }
+        thresholds[i] = levels[i] + (levels[i + 1] - levels[i]) / 2;
+    }
+
+    config = switchConfig;
+    descending = down;
+    reset();
+    return true;
+}
+
+/**
+ * Finds the position of a reading (binary search in the threshold table)
+ * @param reading ADC reading
+ * @return Position in ascending reading order
+ */
+uint8_t LadderSwitch::decode(uint16_t reading) const {
+    uint8_t low = 0;
+    uint8_t high = config.positions - 1;
+    while (low < high) {
+        uint8_t middle = (low + high) / 2;
+        if (reading < thresholds[middle]) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return low;
+}
+
+/**
+ * Adds one ADC reading
+ * @param reading analogRead() result
+ * @param now Reading time (ms)
+ * @return true if a new position is to be reported (see getPosition())
+ */
+bool LadderSwitch::addSample(uint16_t reading, unsigned long now) {
+    uint8_t position = decode(reading);
+
+    // Stay inside the hysteresis band around the reported position
+    if (slot != LADDER_NONE && position != slot) {
+        if (position < slot && reading + config.hysteresis >= thresholds[slot - 1]) {
+            position = slot;
+        } else if (position > slot && reading < thresholds[slot] + config.hysteresis) {
+            position = slot;
+        }
+    }
+
+    if (position != candidate) {
+        candidate = position;
+        candidateTime = now;
+    }
+    if (candidate == slot || now - candidateTime < config.settleMs) {
+        return false;
+    }
+
+    slot = candidate;
+    return true;
+}
+
+/**
+ * Forgets the reported position, the next settled position is reported
+ */
+void LadderSwitch::reset() {
+    slot = LADDER_NONE;
+    candidate = LADDER_NONE;
+    candidateTime = 0;
+}
+
+/**
+ * @return Current configuration
+ */
+const LadderSwitchConfig& LadderSwitch::getConfig() const {
+    return config;
+}
+
+/**
+ * @return Reported position (0 = first level of the configuration),
+ *         LADDER_NONE before the first
+ */
+uint8_t LadderSwitch::getPosition() const {
+    if (slot == LADDER_NONE) return LADDER_NONE;
+    return descending ? config.positions - 1 - slot : slot;
+}
@@ -0,0 +1,67 @@
+/**************************
+   LadderSwitch.h
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#ifndef LADDER_SWITCH_H
+#define LADDER_SWITCH_H
+
+#include "AnalogAxis.h"
+
+/*
+   Resistor ladder switches
+
+   A multi-position rotary switch wired to a resistor ladder gives one ADC
+   level per position. The boundaries between adjacent levels are computed
+   once (threshold table), a reading is decoded with a binary search. A
+   reading must pass a boundary by `hysteresis` to leave the current
+   position, and a new position must hold for `settleMs` before it is
+   reported, so the levels crossed while the knob turns are never reported.
+*/
+
+#define MAX_LADDER_POSITIONS 16    // Positions per switch
+#define MAX_LADDER_SWITCHES  8     // Switches per controller
+#define LADDER_NONE          0xFF  // No position reported yet
+
+/**
+ * Ladder switch configuration
+ */
+struct LadderSwitchConfig {
+    int pin;                 // ADC pin
+    uint8_t positions;       // Number of positions (2 to MAX_LADDER_POSITIONS)
+    const uint16_t* levels;  // Reading per position (ADC units, ascending or descending,
+                             // sketch owned), nullptr = evenly spaced from 0 to ANALOG_ADC_MAX
+    uint16_t hysteresis;     // ADC units past a boundary before the position changes
+    uint8_t settleMs;        // Time a new position must hold before it is reported
+
+    LadderSwitchConfig(int _pin = -1, uint8_t _positions = 12, const uint16_t* _levels = nullptr,
+                       uint16_t _hysteresis = 8, uint8_t _settleMs = 20) :
+        pin(_pin), positions(_positions), levels(_levels),
+        hysteresis(_hysteresis), settleMs(_settleMs) {}
+};
+
+class LadderSwitch {
+    private:
+        LadderSwitchConfig config;
+        uint16_t thresholds[MAX_LADDER_POSITIONS - 1]; // Boundaries, ascending readings
+        bool descending;            // Position 0 has the highest reading
+        uint8_t slot;               // Reported position in ascending reading order
+        uint8_t candidate;          // Position being settled (ascending order)
+        unsigned long candidateTime; // First reading of the candidate
+
+        uint8_t decode(uint16_t reading) const;
+
+    public:
+        LadderSwitch();
+
+        bool configure(const LadderSwitchConfig& config);
+        bool addSample(uint16_t reading, unsigned long now);   // true on a position change
+        void reset();
+
+        const LadderSwitchConfig& getConfig() const;
+        uint8_t getPosition() const;        // Reported position (LADDER_NONE before the first)
+};
+
+#endif
@@ -0,0 +1,149 @@
+/**************************
+   ScanSync.h
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#ifndef SCAN_SYNC_H
+#define SCAN_SYNC_H
+
+#include <Arduino.h>
+
+/*
+   Cross-context synchronization
+
+   ScanLock: try-lock taken by the scan. A second context (other core,
+   task or ISR) that tries to scan at the same time fails instead of
+   entering the scan.
+
+   SeqCounter: sequence counter of a seqlock. The scan (single writer)
+   publishes state between beginWrite() and endWrite(), readers copy it
+   and retry when the counter moved. Readers never block the writer.
+
+   AVR: interrupts are masked while the lock flag changes and while state
+   is published, so a reader in an ISR never waits for the code it
+   interrupted. Other cores: std::atomic (also used by host builds with
+   std::thread).
+*/
+
+#if defined(__AVR__)
+#include <util/atomic.h>
+#define SCAN_SYNC_BARRIER()     __asm__ __volatile__("" ::: "memory")
+#else
+#include <atomic>
+#endif
+
+class ScanLock {
+    private:
+#if defined(__AVR__)
+        volatile bool locked;
+#else
+        std::atomic<bool> locked;
+#endif
+
+    public:
+        ScanLock() : locked(false) {}
+
+        bool tryLock() {
+#if defined(__AVR__)
+            bool acquired;
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                acquired = !locked;
+                locked = true;
+            }
+            return acquired;
+#else
+            return !locked.exchange(true, std::memory_order_acquire);
+#endif
+        }
+
+        void unlock() {
+#if defined(__AVR__)
+            SCAN_SYNC_BARRIER();
+            locked = false;
+#else
+            locked.store(false, std::memory_order_release);
+#endif
+        }
+
+        bool isLocked() const {
+#if defined(__AVR__)
+            return locked;
+#else
+            return locked.load(std::memory_order_relaxed);
+#endif
+        }
+};
+
+class SeqCounter {
+    private:
+#if defined(__AVR__)
+        volatile uint16_t sequence;
+        uint8_t savedSreg;          // Interrupt state of the writer
+#else
+        std::atomic<uint32_t> sequence;
+#endif
+
+    public:
+#if defined(__AVR__)
+        SeqCounter() : sequence(0), savedSreg(0) {}
+#else
+        SeqCounter() : sequence(0) {}
+#endif
+
+        // Writer (one context only)
+        void beginWrite() {
+#if defined(__AVR__)
+            savedSreg = SREG;
+            cli();
+            sequence = sequence + 1;
+            SCAN_SYNC_BARRIER();
+#else
+            sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+#endif
+        }
+
+        void endWrite() {
+#if defined(__AVR__)
+            SCAN_SYNC_BARRIER();
+            sequence = sequence + 1;
+            SREG = savedSreg;
+#else
+            sequence.store(sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+#endif
+        }
+
+        // Reader: copy the data between beginRead() and retry()
+        uint32_t beginRead() const {
+            uint32_t seq;
+            do {
+#if defined(__AVR__)
+                ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                    seq = sequence;
+                }
+                SCAN_SYNC_BARRIER();
+#else
+                seq = sequence.load(std::memory_order_acquire);
+#endif
+            } while (seq & 1);      // Write in progress
+            return seq;
+        }
+
+        bool retry(uint32_t seq) const {
+#if defined(__AVR__)
+            SCAN_SYNC_BARRIER();
+            uint32_t now;
+            ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+                now = sequence;
+            }
+            return now != seq;
+#else
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return sequence.load(std::memory_order_relaxed) != seq;
+#endif
+        }
+};
+
+#endif
@@ -6,6 +6,14 @@
  **************************/
 
 #include "SimRacingController.h"
+#include "InputRecorder.h"
+#include "GestureEngine.h"
+#include "Telemetry.h"
+
+// I2C bus shared by every instance
+ScanLock SimRacingController::i2cBus;
+uint32_t SimRacingController::i2cBusClock = 0;
+uint8_t SimRacingController::claimedMcpAddresses = 0;
 
 /*
    Constructor - Initializes all variables to safe default values
@@ -13,7 +21,18 @@
 */
 SimRacingController::SimRacingController(unsigned long powerSaveTimeoutMs) :
     // Thread safety
-    isUpdating(false),
+    scanLock(),
+
+    // Background scan task
+    events(nullptr),
+    taskPeriodMs(1),
+    taskPriority(2),
+    taskRunning(false),
+#if defined(SCAN_TASK_FREERTOS)
+    taskHandle(nullptr),
+#elif defined(SCAN_TASK_THREAD)
+    taskThread(nullptr),
+#endif
     
     // Power management
     isPowerSaving(false),
@@ -23,7 +42,6 @@ SimRacingController::SimRacingController(unsigned long powerSaveTimeoutMs) :
     
     // Error handling
     lastError(ControllerError::NO_ERROR),
-    errorCallback(nullptr),
     errorReported(false),
 
     // Button Matrix
@@ -31,55 +49,142 @@ SimRacingController::SimRacingController(unsigned long powerSaveTimeoutMs) :
     numCols(0),
     rowPins(nullptr),
     colPins(nullptr),
-    lastMatrixStates(nullptr),
-    matrixStates(nullptr),
-    lastMatrixDebounceTime(nullptr),
-    matrixDebounceDelay(50),    // 50ms default debounce for buttons
 
     // Direct GPIO
     gpioPins(nullptr),
-    lastGpioStates(nullptr),
-    gpioStates(nullptr),
-    gpioDebounceTime(nullptr),
     numGpio(0),
 
     // MCP23017
     mcpConfigs(nullptr),
     numMcpDevices(0),
-    lastMcpStates(nullptr),
-    mcpStates(nullptr),
-    mcpDebounceTime(nullptr),
     mcpInitialized(false),
+    i2cClock(400000),
+    mcpHealth(nullptr),
+    mcpTimerBase(0),
+    ownMcpAddresses(0),
+
+    // Analog axes and ladder switches
+    analogAxes(nullptr),
+    numAnalogAxes(0),
+    ladders(nullptr),
+    numLadders(0),
+    analogPeriodMs(1),
+    analogTimer(0),
+    analogDue(false),
+
+    // Configuration blob
+    blobMatrixPins(nullptr),
+    blobGpioPins(nullptr),
+    blobFilterTables(nullptr),
+    changeLocked(false),
+    changeDepth(0),
+    blobLevels(nullptr),
+
+    // Input frame
+    frameWords(nullptr),
+    frameSize(0),
+    frameGpioBase(0),
+    frameMcpBase(0),
+    frameEncoderBase(0),
+    frameButtonBase(0),
+    recorder(nullptr),
+    gestures(nullptr),
+    telemetry(nullptr),
+
+    // Debounce state
+    lastRawWords(nullptr),
+    stableWords(nullptr),
+    validMasks(nullptr),
+    waitingWords(nullptr),
+    activeWords(nullptr),
+    wordInputBase(nullptr),
+    inputDeadlines(nullptr),
+    powerSaveTimer(0),
+    gestureTimer(0),
+    gestureSync(false),
+
+    // Debounce filters: 50ms for buttons, 5ms for encoders
+    defaultFilters{FilterClass(50), FilterClass(50), FilterClass(50), FilterClass(50), FilterClass(5)},
+    profileFilters(nullptr),
+    activeFilters(defaultFilters),
+    inputFilters(nullptr),
+    numFilterInputs(0),
+    inputDebounce(nullptr),
+    bounceStats(nullptr),
+    learning(false),
+    learnMinMs(1),
+    learnMaxMs(50),
+    learnMarginMs(2),
+    learnPercentile(95),
+
+    // Incremental scan and sample rates
+    scanBudgetUs(0),
+    nextScanWord(0),
+    samplePeriodUs{0, 0, 0, 0, 0},
+    lastSampleMicros{0, 0, 0, 0, 0},
+    scanSources(0),
+    numRateTiers(0),
+    rateTier(0),
+    lastEdgeTime(0),
+    lastScanMicros(0),
+    tierTime(0),
 
     // Encoders
     numEncoders(0),
     encoders(nullptr),
-    encoderDebounceTime(5),    // 5ms default debounce for encoders
+#if defined(ENCODER_PORT_READS)
+    encoderPorts(nullptr),
+    numEncoderPorts(0),
+    encoderPortsRead(false),
+#endif
+
+    // Published state
+    stateSeq(),
+    publishedWords(nullptr),
+    publishedEncoders(nullptr),
+    publishedAnalog(nullptr),
+    publishedSwitches(nullptr),
+    stateDirty(false),
 
     // Profiles
     currentProfile(0),
-    numProfiles(1),
-
-    // Callbacks
-    onMatrixChange(nullptr),
-    onGpioChange(nullptr),
-    onEncoderChange(nullptr),
-    onEncoderButtonChange(nullptr),
-    onMcpChange(nullptr) {}
+    numProfiles(1) {}
 
 /*
    Destructor - Ensures proper cleanup of allocated memory
 */
 SimRacingController::~SimRacingController() {
-    cleanupArrays();
+    stopScanTask();
+    releaseMcpAddresses();
+    delete events;
     delete[] encoders;
-    delete[] lastGpioStates;
-    delete[] gpioStates;
-    delete[] gpioDebounceTime;
+#if defined(ENCODER_PORT_READS)
+    delete[] encoderPorts;
+#endif
     delete[] mcpConfigs;
-    delete[] lastMcpStates;
-    delete[] mcpStates;
-    delete[] mcpDebounceTime;
+    delete[] mcpHealth;
+    delete[] frameWords;
+    delete[] lastRawWords;
+    delete[] stableWords;
+    delete[] validMasks;
+    delete[] waitingWords;
+    delete[] activeWords;
+    delete[] wordInputBase;
+    delete[] inputDeadlines;
+    delete[] publishedWords;
+    delete[] publishedEncoders;
+    delete[] publishedAnalog;
+    delete[] publishedSwitches;
+    delete[] analogAxes;
+    delete[] ladders;
+    delete[] blobMatrixPins;
+    delete[] blobGpioPins;
+    delete[] blobFilterTables;
+    delete[] blobLevels;
+    delete[] profileFilters;
+    delete[] inputFilters;
+    delete[] inputDebounce;
+    delete[] bounceStats;
 }
 
 /*
@@ -88,18 +193,139 @@ SimRacingController::~SimRacingController() {
 
 /**
  * Waits for I2C data with timeout
- * @param startTime Starting time for timeout calculation
+ * @param startMicros Starting time for timeout calculation (us)
  * @return true if data available, false if timeout
  */
-bool SimRacingController::waitForI2C(unsigned long startTime) const {
+bool SimRacingController::waitForI2C(unsigned long startMicros) const {
     while (Wire.available() == 0) {
-        if (millis() - startTime > I2C_TIMEOUT_MS) {
+        if (micros() - startMicros > I2C_TIMEOUT_US) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Starts the I2C bus with the configured clock and a bounded timeout
+ * The bus is started once and shared with the other instances.
+ */
+void SimRacingController::startI2C() {
+    if (i2cBusClock) return;    // Started by another instance
+
+    Wire.begin();
+    Wire.setClock(i2cClock);
+    i2cBusClock = i2cClock;
+#if defined(WIRE_HAS_TIMEOUT)
+    Wire.setWireTimeout(I2C_TIMEOUT_US, true);     // Reset TWI on timeout
+#elif defined(ARDUINO_ARCH_ESP32)
+    Wire.setTimeOut((I2C_TIMEOUT_US + 999) / 1000);
+#endif
+}
+
+/**
+ * Frees a bus held by a slave stuck in the middle of a byte (SDA low)
+ * Clocks SCL until SDA is released (at most 9 pulses), sends a STOP and
+ * restarts the I2C peripheral.
+ */
+void SimRacingController::recoverI2CBus() {
+#if defined(PIN_WIRE_SDA) || defined(ARDUINO_ARCH_ESP32)
+    Wire.end();
+    pinMode(SDA, INPUT_PULLUP);
+    pinMode(SCL, INPUT_PULLUP);
+
+    for (uint8_t i = 0; i < 9 && isSdaLow(); i++) {
+        digitalWrite(SCL, LOW);
+        pinMode(SCL, OUTPUT);
+        delayMicroseconds(5);
+        pinMode(SCL, INPUT_PULLUP);
+        delayMicroseconds(5);
+    }
+
+    // STOP: SDA rises while SCL is high
+    digitalWrite(SDA, LOW);
+    pinMode(SDA, OUTPUT);
+    delayMicroseconds(5);
+    pinMode(SDA, INPUT_PULLUP);
+    delayMicroseconds(5);
+#endif
+    i2cBusClock = 0;
+    startI2C();
+}
+
+/**
+ * @return true if a slave holds SDA low (or the fault hook says so)
+ */
+bool SimRacingController::isSdaLow() {
+    if (i2cFaultHook && i2cFaultHook(I2C_FAULT_BUS) == I2C_FAULT_SDA_LOW) {
+        return true;
+    }
+#if defined(PIN_WIRE_SDA) || defined(ARDUINO_ARCH_ESP32)
+    return digitalRead(SDA) == LOW;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Takes the I2C bus for one transaction
+ * A transaction of another instance (other core or task) is waited for
+ * at most I2C_TIMEOUT_US. The clock of this instance is set if another
+ * instance changed it.
+ * @return false if the bus stayed busy
+ */
+bool SimRacingController::lockI2C() {
+    unsigned long startMicros = micros();
+    while (!i2cBus.tryLock()) {
+        if (micros() - startMicros > I2C_TIMEOUT_US) {
+            lastError = ControllerError(ControllerError::TIMEOUT_ERROR, "I2C bus busy");
             return false;
         }
     }
+    if (i2cBusClock != i2cClock) {
+        Wire.setClock(i2cClock);
+        i2cBusClock = i2cClock;
+    }
+    return true;
+}
+
+/**
+ * Releases the I2C bus taken by lockI2C()
+ */
+void SimRacingController::unlockI2C() {
+    i2cBus.unlock();
+}
+
+/**
+ * Claims the MCP23017 addresses of this instance on the shared bus
+ * @return false if another instance already uses one of them
+ */
+bool SimRacingController::claimMcpAddresses() {
+    releaseMcpAddresses();
+
+    uint8_t wanted = 0;
+    for (uint8_t i = 0; i < numMcpDevices; i++) {
+        uint8_t address = mcpConfigs[i].address;
+        if (address < 0x20 || address > 0x27) continue;
+        wanted |= 1 << (address - 0x20);
+    }
+    if (claimedMcpAddresses & wanted) {
+        lastError = ControllerError(ControllerError::PIN_CONFLICT, "MCP address used by another controller");
+        return false;
+    }
+
+    claimedMcpAddresses |= wanted;
+    ownMcpAddresses = wanted;
     return true;
 }
 
+/**
+ * Releases the MCP23017 addresses claimed by this instance
+ */
+void SimRacingController::releaseMcpAddresses() {
+    claimedMcpAddresses &= ~ownMcpAddresses;
+    ownMcpAddresses = 0;
+}
+
 /**
  * Checks I2C error codes and updates error state
  * @param error I2C error code
@@ -129,6 +355,27 @@ bool SimRacingController::checkI2CError(uint8_t error) {
     return false;
 }
 
+/**
+ * Applies the fault injected by the fault hook to a transaction
+ * @param address Device address
+ * @return true if no fault, false otherwise (error set as by the bus)
+ */
+bool SimRacingController::checkI2CFault(uint8_t address) {
+    if (!i2cFaultHook) return true;
+
+    switch (i2cFaultHook(address)) {
+        case I2C_FAULT_NONE:
+            return true;
+        case I2C_FAULT_NACK:
+            return checkI2CError(2);
+        case I2C_FAULT_TIMEOUT:
+            lastError = ControllerError(ControllerError::TIMEOUT_ERROR, "I2C read timeout");
+            return false;
+        default:
+            return checkI2CError(4);
+    }
+}
+
 /*
    MCP23017 Methods
 */
@@ -141,15 +388,37 @@ bool SimRacingController::checkI2CError(uint8_t error) {
  * @return true if successful, false on error
  */
 bool SimRacingController::writeMcpRegister(uint8_t device, uint8_t reg, uint8_t value) {
+    return writeMcpRegisters(device, reg, &value, 1);
+}
+
+/**
+ * Writes consecutive MCP23017 registers in one transaction (sequential mode)
+ * @param device Device index
+ * @param reg First register address
+ * @param values Values to write
+ * @param count Number of registers
+ * @return true if successful, false on error
+ */
+bool SimRacingController::writeMcpRegisters(uint8_t device, uint8_t reg,
+                                            const uint8_t* values, uint8_t count) {
     if (device >= numMcpDevices) {
         lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid MCP device");
         return false;
     }
 
-    Wire.beginTransmission(mcpConfigs[device].address);
-    Wire.write(reg);
-    Wire.write(value);
-    return checkI2CError(Wire.endTransmission());
+    if (!lockI2C()) return false;
+
+    bool ok = checkI2CFault(mcpConfigs[device].address);
+    if (ok) {
+        Wire.beginTransmission(mcpConfigs[device].address);
+        Wire.write(reg);
+        for (uint8_t i = 0; i < count; i++) {
+            Wire.write(values[i]);
+        }
+        ok = checkI2CError(Wire.endTransmission());
+    }
+    unlockI2C();
+    return ok;
 }
 
 /**
@@ -160,55 +429,142 @@ bool SimRacingController::writeMcpRegister(uint8_t device, uint8_t reg, uint8_t
  * @return true if successful, false on error
  */
 bool SimRacingController::readMcpRegister(uint8_t device, uint8_t reg, uint8_t& value) {
+    return readMcpRegisters(device, reg, &value, 1);
+}
+
+/**
+ * Reads consecutive MCP23017 registers in one transaction (sequential mode)
+ * @param device Device index
+ * @param reg First register address
+ * @param values Buffer for count values
+ * @param count Number of registers
+ * @return true if successful, false on error
+ */
+bool SimRacingController::readMcpRegisters(uint8_t device, uint8_t reg,
+                                           uint8_t* values, uint8_t count) {
     if (device >= numMcpDevices) {
         lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid MCP device");
         return false;
     }
 
-    Wire.beginTransmission(mcpConfigs[device].address);
-    Wire.write(reg);
-    if (!checkI2CError(Wire.endTransmission())) return false;
+    if (!lockI2C()) return false;
 
-    unsigned long startTime = millis();
-    Wire.requestFrom(mcpConfigs[device].address, (uint8_t)1);
-    if (!waitForI2C(startTime)) {
-        lastError = ControllerError(ControllerError::TIMEOUT_ERROR, "I2C read timeout");
-        return false;
+    bool ok = checkI2CFault(mcpConfigs[device].address);
+    if (ok) {
+        Wire.beginTransmission(mcpConfigs[device].address);
+        Wire.write(reg);
+        ok = checkI2CError(Wire.endTransmission());
     }
 
-    value = Wire.read();
-    return true;
+    if (ok) {
+        unsigned long startMicros = micros();
+        Wire.requestFrom(mcpConfigs[device].address, count);
+        for (uint8_t i = 0; i < count; i++) {
+            if (!waitForI2C(startMicros)) {
+                lastError = ControllerError(ControllerError::TIMEOUT_ERROR, "I2C read timeout");
+                ok = false;
+                break;
+            }
+            values[i] = Wire.read();
+        }
+    }
+    unlockI2C();
+    return ok;
 }
 
 /**
  * Reads both ports (A and B) from an MCP23017
+ * With an interrupt line the flags and captures are read in the same
+ * transaction, which clears the interrupt.
  * @param device Device index
  * @param value Reference to store 16-bit port values
  * @return true if successful, false on error
  */
 bool SimRacingController::readMcpPorts(uint8_t device, uint16_t& value) {
-    if (device >= numMcpDevices) {
-        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid MCP device");
-        return false;
+    uint8_t regs[6];    // INTFA, INTFB, INTCAPA, INTCAPB, GPIOA, GPIOB
+
+    if (device < numMcpDevices && hasMcpInterrupt(device)) {
+        if (!readMcpRegisters(device, MCP23017_INTFA, regs, 6)) return false;
+    } else {
+        if (!readMcpRegisters(device, MCP23017_GPIOA, regs + 4, 2)) return false;
     }
 
-    Wire.beginTransmission(mcpConfigs[device].address);
-    Wire.write(MCP23017_GPIOA);
-    if (!checkI2CError(Wire.endTransmission())) return false;
+    value = regs[4] | (regs[5] << 8);
+    return true;
+}
 
-    unsigned long startTime = millis();
-    Wire.requestFrom(mcpConfigs[device].address, (uint8_t)2);
-    if (!waitForI2C(startTime)) {
-        lastError = ControllerError(ControllerError::TIMEOUT_ERROR, "I2C read timeout");
-        return false;
+/**
+ * @param device Device index
+ * @return true if the device signals changes on an interrupt pin
+ */
+bool SimRacingController::hasMcpInterrupt(uint8_t device) const {
+    return mcpConfigs[device].useInterrupts && mcpConfigs[device].intPin != 0xFF;
+}
+
+/**
+ * Handles a failed read of a device
+ * The previous sample is kept for MCP_FAIL_LIMIT failures, then the device
+ * goes offline: it is no longer read, its inputs read as released and a
+ * re-probe is scheduled.
+ * @param device Device index
+ */
+void SimRacingController::handleMcpFailure(uint8_t device) {
+    McpHealth& health = mcpHealth[device];
+    health.errors++;
+
+#if defined(PIN_WIRE_SDA) || defined(ARDUINO_ARCH_ESP32)
+    // A slave holding SDA low blocks every device on the bus
+    if (isSdaLow() && lockI2C()) {
+        recoverI2CBus();
+        unlockI2C();
+        health.busClears++;
     }
+#endif
 
-    value = Wire.read() | (Wire.read() << 8);
-    return true;
+    if (++health.failures < MCP_FAIL_LIMIT) return;
+
+    health.online = false;
+    health.retryMs = MCP_RETRY_MIN_MS;
+    frameWords[frameMcpBase + device] = 0;
+    timers.schedule(mcpTimerBase + device, millis() + health.retryMs);
+
+    lastError = ControllerError(ControllerError::MCP_ERROR, "MCP device offline");
+    if (errorCallback && !errorReported) {
+        errorCallback(lastError);
+        errorReported = true;
+    }
+}
+
+/**
+ * Re-probes an offline device (called by its timer)
+ * A device that answers is configured again and read from the next scan,
+ * otherwise the retry interval doubles up to MCP_RETRY_MAX_MS.
+ * @param device Device index
+ * @param now Current time (ms)
+ */
+void SimRacingController::probeMcp(uint8_t device, unsigned long now) {
+    McpHealth& health = mcpHealth[device];
+
+    if (initializeMcp(device)) {
+        health.online = true;
+        health.failures = 0;
+        health.reconnects++;
+
+        uint16_t reading;
+        if (hasMcpInterrupt(device) && readMcpPorts(device, reading)) {
+            frameWords[frameMcpBase + device] = (uint16_t)~reading;
+        }
+        return;
+    }
+
+    health.errors++;
+    health.retryMs = health.retryMs >= MCP_RETRY_MAX_MS / 2 ? MCP_RETRY_MAX_MS : health.retryMs * 2;
+    timers.schedule(mcpTimerBase + device, now + health.retryMs);
 }
 
 /**
  * Initializes an MCP23017 device
+ * Two transactions: IOCON, then all configuration registers in one burst.
  * @param device Device index
  * @return true if successful, false on error
  */
@@ -216,37 +572,31 @@ bool SimRacingController::initializeMcp(uint8_t device) {
     if (device >= numMcpDevices) return false;
 
     const McpConfig& config = mcpConfigs[device];
+    bool interrupts = hasMcpInterrupt(device);
+    uint8_t pullups = config.usePullups ? 0xFF : 0x00;
+    uint8_t changes = interrupts ? 0xFF : 0x00;
 
-    // Reset the MCP23017
-    if (!writeMcpRegister(device, MCP23017_IOCONA, 0x00) ||
-        !writeMcpRegister(device, MCP23017_IOCONB, 0x00))
+    // BANK = 0, sequential mode (register addresses below are valid from here)
+    if (!writeMcpRegister(device, MCP23017_IOCONA, 0x00))
         return false;
 
-    // Set all pins as inputs
-    if (!writeMcpRegister(device, MCP23017_IODIRA, 0xFF) ||
-        !writeMcpRegister(device, MCP23017_IODIRB, 0xFF))
+    // IODIRA .. GPPUB: all inputs, no inversion, interrupt on change if enabled
+    const uint8_t regs[MCP23017_GPPUB - MCP23017_IODIRA + 1] = {
+        0xFF, 0xFF,             // IODIR
+        0x00, 0x00,             // IPOL
+        changes, changes,       // GPINTEN
+        0x00, 0x00,             // DEFVAL
+        0x00, 0x00,             // INTCON (compare with previous value)
+        0x00, 0x00,             // IOCON
+        pullups, pullups        // GPPU
+    };
+    if (!writeMcpRegisters(device, MCP23017_IODIRA, regs, sizeof(regs)))
         return false;
 
-    // Enable pullups if configured
-    if (config.usePullups) {
-        if (!writeMcpRegister(device, MCP23017_GPPUA, 0xFF) ||
-            !writeMcpRegister(device, MCP23017_GPPUB, 0xFF))
-            return false;
-    }
-
-    // Configure interrupts if enabled
-    if (config.useInterrupts && config.intPin >= 0) {
+    if (interrupts) {
         pinMode(config.intPin, INPUT_PULLUP);
-        
-        if (!writeMcpRegister(device, MCP23017_GPINTENA, 0xFF) ||
-            !writeMcpRegister(device, MCP23017_GPINTENB, 0xFF) ||
-            !writeMcpRegister(device, MCP23017_INTCONA, 0x00) ||
-            !writeMcpRegister(device, MCP23017_INTCONB, 0x00))
-            return false;
     }
-
-    // Enable sequential mode and byte mode
-    return writeMcpRegister(device, MCP23017_IOCONA, 0x20);
+    return true;
 }
 
 /*
@@ -271,14 +621,12 @@ void SimRacingController::setMatrix(const int* rowPins, int numRows,
  * @param config Matrix configuration structure
  */
 void SimRacingController::configureMatrix(const MatrixConfig& config) {
-    cleanupArrays();
-
     const_cast<int&>(numRows) = config.numRows;
     const_cast<int&>(numCols) = config.numCols;
     const_cast<int*&>(rowPins) = const_cast<int*>(config.rowPins);
     const_cast<int*&>(colPins) = const_cast<int*>(config.colPins);
 
-    initializeArrays();
+    resetFilters();
 }
 
 /*
@@ -291,16 +639,10 @@ void SimRacingController::configureMatrix(const MatrixConfig& config) {
  * @param numPins Number of GPIO pins
  */
 void SimRacingController::setGpio(const int* pins, int numPins) {
-    delete[] lastGpioStates;
-    delete[] gpioStates;
-    delete[] gpioDebounceTime;
-
     const_cast<int*&>(gpioPins) = const_cast<int*>(pins);
     const_cast<int&>(numGpio) = numPins;
 
-    lastGpioStates = new bool[numPins]();
-    gpioStates = new bool[numPins]();
-    gpioDebounceTime = new unsigned long[numPins]();
+    resetFilters();
 }
 
 /*
@@ -320,628 +662,3131 @@ bool SimRacingController::setMcpDevices(const McpConfig* configs, uint8_t numDev
     }
 
     delete[] mcpConfigs;
-    delete[] lastMcpStates;
-    delete[] mcpStates;
-    delete[] mcpDebounceTime;
+
+    delete[] mcpHealth;
 
     numMcpDevices = numDevices;
     mcpConfigs = new McpConfig[numDevices];
-    lastMcpStates = new uint16_t[numDevices]();
-    mcpStates = new uint16_t[numDevices]();
-    mcpDebounceTime = new unsigned long[numDevices * 16]();
+    mcpHealth = new McpHealth[numDevices];
 
     for (uint8_t i = 0; i < numDevices; i++) {
         mcpConfigs[i] = configs[i];
     }
 
     mcpInitialized = false;
+    resetFilters();
     return true;
 }
 
-/*
-   Encoder Configuration
-*/
-
 /**
- * Configures encoders without buttons
- * @param encoderPinsA Array of first encoder pins
- * @param encoderPinsB Array of second encoder pins
- * @param numEncoders Number of encoders
+ * Sets the I2C bus clock used for the MCP23017s
+ * Takes effect from the next transaction; instances sharing the bus may
+ * use different clocks.
+ * @param clockHz Clock in Hz (MIN_I2C_CLOCK_HZ to MAX_I2C_CLOCK_HZ)
+ * @return true if valid clock, false otherwise
  */
-void SimRacingController::setEncoders(const int* encoderPinsA, const int* encoderPinsB,
-                                      int numEncoders) {
-    setEncoders(encoderPinsA, encoderPinsB, nullptr, numEncoders);
+bool SimRacingController::setI2cClock(uint32_t clockHz) {
+    if (clockHz < MIN_I2C_CLOCK_HZ || clockHz > MAX_I2C_CLOCK_HZ) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid I2C clock");
+        return false;
+    }
+    i2cClock = clockHz;
+    return true;
 }
 
 /**
- * Configures encoders with optional buttons
- * @param encoderPinsA Array of first encoder pins
- * @param encoderPinsB Array of second encoder pins
- * @param encoderBtnPins Array of button pins (optional)
- * @param numEncoders Number of encoders
+ * @return I2C bus clock (Hz)
  */
-void SimRacingController::setEncoders(const int* encoderPinsA, const int* encoderPinsB,
-                                      const int* encoderBtnPins, int numEncoders) {
-    EncoderInitConfig config(encoderPinsA, encoderPinsB, encoderBtnPins, numEncoders);
-    configureEncoders(config);
+uint32_t SimRacingController::getI2cClock() const {
+    return i2cClock;
 }
 
 /**
- * Internal encoder configuration
- * @param config Encoder configuration structure
+ * Sets a hook that injects I2C faults (fault injection for tests)
+ * Called with the device address before every MCP23017 transaction,
+ * and with I2C_FAULT_BUS whenever the SDA level is checked. A fault
+ * fails the transaction as the bus would; I2C_FAULT_SDA_LOW on a bus
+ * check reads as a slave holding SDA low. nullptr removes the hook.
+ * @param hook Hook function
  */
-void SimRacingController::configureEncoders(const EncoderInitConfig& config) {
-    delete[] encoders;
-
-    const_cast<int&>(numEncoders) = config.count;
+void SimRacingController::setI2cFaultHook(I2cFault (*hook)(uint8_t address)) {
+    i2cFaultHook.set(hook);
+}
 
-    encoders = new EncoderConfig[config.count];
-    for (int i = 0; i < config.count; i++) {
-        encoders[i].pinA = config.pinsA[i];
-        encoders[i].pinB = config.pinsB[i];
-        encoders[i].pinBtn = config.btnPins ? config.btnPins[i] : -1;
-        encoders[i].divisor = 4;
-        encoders[i].valid = true;
-        encoders[i].errorReported = false;
-    }
+/**
+ * Sets a fault hook with a context
+ * @param hook Hook function, called with context first
+ * @param context Sketch pointer passed to the hook
+ */
+void SimRacingController::setI2cFaultHook(I2cFault (*hook)(void* context, uint8_t address),
+                                          void* context) {
+    i2cFaultHook.set(hook, context);
 }
 
 /*
-   Array Management
+   Analog Axes
 */
 
 /**
- * Initializes matrix state arrays
+ * Configures analog axes
+ * @param configs Array of axis configurations
+ * @param numAxes Number of axes (0 to remove all)
+ * @return true if successful, false on error
  */
-void SimRacingController::initializeArrays() {
-    lastMatrixStates = new bool*[numRows];
-    matrixStates = new bool*[numRows];
-    lastMatrixDebounceTime = new unsigned long*[numRows];
-
-    for (int i = 0; i < numRows; i++) {
-        lastMatrixStates[i] = new bool[numCols]();
-        matrixStates[i] = new bool[numCols]();
-        lastMatrixDebounceTime[i] = new unsigned long[numCols]();
+bool SimRacingController::setAnalogAxes(const AnalogAxisConfig* configs, uint8_t numAxes) {
+    if (numAxes > MAX_ANALOG_AXES || (numAxes > 0 && !configs)) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid analog config");
+        return false;
     }
-}
 
-/**
- * Cleanup matrix state arrays
- */
-void SimRacingController::cleanupArrays() {
-    if (lastMatrixStates) {
-        for (int i = 0; i < numRows; i++) {
-            delete[] lastMatrixStates[i];
-            delete[] matrixStates[i];
-            delete[] lastMatrixDebounceTime[i];
+    AnalogAxis* axes = new AnalogAxis[numAxes];
+    for (uint8_t i = 0; i < numAxes; i++) {
+        if (!axes[i].configure(configs[i])) {
+            delete[] axes;
+            lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid analog axis config");
+            return false;
         }
-        delete[] lastMatrixStates;
-        delete[] matrixStates;
-        delete[] lastMatrixDebounceTime;
-
-        lastMatrixStates = nullptr;
-        matrixStates = nullptr;
-        lastMatrixDebounceTime = nullptr;
     }
-}
 
-/*
-   Configuration Validation
-*/
+    delete[] analogAxes;
+    analogAxes = axes;
+    numAnalogAxes = numAxes;
+    return true;
+}
 
 /**
- * Validates all pin assignments
- * @return true if valid, false otherwise
+ * Configures resistor ladder switches (one ADC pin per multi-position switch)
+ * @param configs Array of switch configurations
+ * @param numSwitches Number of switches (0 to remove all)
+ * @return true if successful, false on error
  */
-bool SimRacingController::validatePins() {
-    // Matrix pins validation
-    for (int i = 0; i < numRows; i++) {
-        if (rowPins[i] < 0 || rowPins[i] >= NUM_DIGITAL_PINS) {
-            lastError = ControllerError(ControllerError::INVALID_PIN, "Invalid matrix row pin");
-            return false;
-        }
-    }
-    
-    for (int i = 0; i < numCols; i++) {
-        if (colPins[i] < 0 || colPins[i] >= NUM_DIGITAL_PINS) {
-            lastError = ControllerError(ControllerError::INVALID_PIN, "Invalid matrix column pin");
-            return false;
-        }
+bool SimRacingController::setLadderSwitches(const LadderSwitchConfig* configs, uint8_t numSwitches) {
+    if (numSwitches > MAX_LADDER_SWITCHES || (numSwitches > 0 && !configs)) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid ladder switch config");
+        return false;
     }
 
-    // GPIO pins validation
-    for (int i = 0; i < numGpio; i++) {
-        if (gpioPins[i] < 0 || gpioPins[i] >= NUM_DIGITAL_PINS) {
-            lastError = ControllerError(ControllerError::INVALID_PIN, "Invalid GPIO pin");
+    LadderSwitch* switches = new LadderSwitch[numSwitches];
+    for (uint8_t i = 0; i < numSwitches; i++) {
+        if (!switches[i].configure(configs[i])) {
+            delete[] switches;
+            lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid ladder switch levels");
             return false;
         }
     }
 
-    // Encoder pins validation
-    for (int i = 0; i < numEncoders; i++) {
-        if (encoders[i].pinA < 0 || encoders[i].pinA >= NUM_DIGITAL_PINS ||
-            encoders[i].pinB < 0 || encoders[i].pinB >= NUM_DIGITAL_PINS) {
-            lastError = ControllerError(ControllerError::INVALID_PIN, "Invalid encoder pin");
-            return false;
-        }
-        
-        if (encoders[i].pinBtn >= 0 && encoders[i].pinBtn >= NUM_DIGITAL_PINS) {
-            lastError = ControllerError(ControllerError::INVALID_PIN, "Invalid encoder button pin");
-            return false;
-        }
-    }
+    delete[] ladders;
+    ladders = switches;
+    numLadders = numSwitches;
+    return true;
+}
 
+/**
+ * Sets the time between two readings of every axis and ladder switch
+ * Each reading costs one ADC conversion per axis or switch (about 110us on AVR).
+ * @param periodMs Period in milliseconds (at least 1)
+ * @return true if valid period, false otherwise
+ */
+bool SimRacingController::setAnalogRate(uint8_t periodMs) {
+    if (periodMs == 0) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid analog period");
+        return false;
+    }
+    analogPeriodMs = periodMs;
     return true;
 }
 
 /**
- * Validates complete configuration
+ * Changes the calibration of an analog axis (restarts its filter)
+ * @param axis Axis index
+ * @param rawMin Reading at rest (ADC units), above rawMax to invert
+ * @param rawMax Reading at full travel (ADC units)
  * @return true if valid, false otherwise
  */
-bool SimRacingController::validateConfiguration() {
-    if (numRows > 0 && numCols > 0) {
-        if (!rowPins || !colPins) {
-            lastError = ControllerError(ControllerError::INVALID_CONFIG, "Matrix pins not configured");
-            return false;
+bool SimRacingController::setAnalogCalibration(uint8_t axis, uint16_t rawMin, uint16_t rawMax) {
+    if (axis < numAnalogAxes) {
+        AnalogAxisConfig config = analogAxes[axis].getConfig();
+        config.rawMin = rawMin;
+        config.rawMax = rawMax;
+        if (analogAxes[axis].configure(config)) {
+            return true;
         }
     }
-    
-    if (numGpio > 0 && !gpioPins) {
-        lastError = ControllerError(ControllerError::INVALID_CONFIG, "GPIO pins not configured");
-        return false;
-    }
-    
-    if (numEncoders > 0 && !encoders) {
-        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Encoders not configured");
-        return false;
-    }
-    
-    if (numMcpDevices > 0 && !mcpConfigs) {
-        lastError = ControllerError(ControllerError::INVALID_CONFIG, "MCP devices not configured");
+    lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid analog calibration");
+    return false;
+}
+
+/**
+ * Sets the response curve of an analog axis
+ * @param axis Axis index
+ * @param points Output values at equally spaced travel (sketch owned, nullptr = linear)
+ * @param numPoints 2, 3, 5, 9 or 17 points
+ * @return true if valid, false otherwise
+ */
+bool SimRacingController::setAnalogCurve(uint8_t axis, const uint16_t* points, uint8_t numPoints) {
+    if (axis >= numAnalogAxes || !analogAxes[axis].setCurve(points, numPoints)) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid analog curve");
         return false;
     }
-    
-    return validatePins();
+    return true;
 }
 
 /*
-   Core Initialization
+   Configuration Blob
 */
 
 /**
- * Initializes all hardware components
- * @return true if successful, false on error
+ * Applies a configuration blob
+ * The CRC of the whole blob is checked first. Every section is then
+ * checked against its own size and the layout of the blob without
+ * changing anything; only a blob whose sections are all valid is applied.
+ * Pins and tables are kept in arrays owned by the controller.
+ * @param store Blob storage
+ * @return true if applied, false if missing, corrupt or invalid
  */
-bool SimRacingController::begin() {
-    clearError();
-    
-    if (!validateConfiguration()) {
+bool SimRacingController::loadConfig(ConfigStore& store) {
+    uint8_t header[CONFIG_HEADER_SIZE];
+    if (!store.read(0, header, CONFIG_HEADER_SIZE) || memcmp(header, "SRCF", 4) != 0 ||
+        header[4] != CONFIG_VERSION) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "No config blob");
         return false;
     }
 
-    // Initialize I2C if MCP devices are configured
-    if (numMcpDevices > 0) {
-        Wire.begin();
-        Wire.setClock(400000);  // Set I2C clock to 400kHz
+    size_t end = CONFIG_HEADER_SIZE + (header[6] | ((size_t)header[7] << 8));
+    uint16_t crc = header[8] | ((uint16_t)header[9] << 8);
+    if (end > store.size() || end > CONFIG_MAX_SIZE) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid config blob size");
+        return false;
+    }
 
-        // Initialize each MCP device
-        for (uint8_t i = 0; i < numMcpDevices; i++) {
-            if (!initializeMcp(i)) {
-                lastError = ControllerError(ControllerError::MCP_ERROR, "Failed to initialize MCP");
+    // CRC of the sections, read in chunks
+    uint16_t check = 0xFFFF;
+    uint8_t chunk[16];
+    for (size_t at = CONFIG_HEADER_SIZE; at < end; at += sizeof(chunk)) {
+        size_t length = end - at < sizeof(chunk) ? end - at : sizeof(chunk);
+        if (!store.read(at, chunk, length)) {
+            check = ~crc;
+            break;
+        }
+        for (size_t i = 0; i < length; i++) {
+            check = ConfigCursor::updateCrc(check, chunk[i]);
+        }
+    }
+    if (check != crc) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Config blob CRC mismatch");
+        return false;
+    }
+
+    // Check pass, then apply pass over the same sections
+    for (uint8_t pass = 0; pass < 2; pass++) {
+        bool apply = pass == 1;
+        BlobLayout layout;
+        layout.profiles = numProfiles;
+        layout.rows = numRows;
+        layout.cols = numCols;
+        layout.gpio = numGpio;
+        layout.mcp = numMcpDevices;
+        layout.encoders = numEncoders;
+
+        // Sections (unknown tags and trailing fields of newer versions are skipped)
+        ConfigCursor in(store, CONFIG_HEADER_SIZE, end);
+        while (in.ok && in.getPosition() < end) {
+            uint8_t tag = in.readU8();
+            uint16_t size = in.readU16();
+            size_t next = in.getPosition() + size;
+            if (!in.ok || next > end) break;
+
+            ConfigCursor section(store, in.getPosition(), next);
+            if (!loadSection(section, tag, layout, apply)) {
+                in.ok = false;
+                break;
+            }
+            in.seek(next);
+        }
+
+        if (!in.ok ||
+            frameWordCount(layout.rows, layout.gpio, layout.mcp, layout.encoders) > MAX_INPUT_FRAME_WORDS) {
+            lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid config blob section");
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Checks or applies one blob section
+ * A section is read in full and checked before anything is changed, so
+ * the check pass leaves the controller untouched.
+ * @param in Cursor limited to the section payload
+ * @param tag Section tag (CONFIG_...)
+ * @param layout Layout of the blob so far, updated by layout sections
+ * @param apply false to check only, true to apply
+ * @return false on invalid content
+ */
+bool SimRacingController::loadSection(ConfigCursor& in, uint8_t tag, BlobLayout& layout, bool apply) {
+    switch (tag) {
+        case CONFIG_PROFILES: {
+            uint8_t count = in.readU8();
+            if (!in.ok || count == 0) return false;
+            layout.profiles = count;
+            if (apply) {
+                setProfiles(count);
+            }
+            break;
+        }
+
+        case CONFIG_MATRIX: {
+            uint8_t rows = in.readU8();
+            uint8_t cols = in.readU8();
+            if (cols > MAX_MATRIX_COLS) return false;
+            int* pins = apply ? new int[rows + cols] : nullptr;
+            for (uint16_t i = 0; i < rows + cols; i++) {
+                uint8_t pin = in.readU8();
+                if (pins) pins[i] = pin;
+            }
+            if (!in.ok) {
+                delete[] pins;
                 return false;
             }
+            layout.rows = rows;
+            layout.cols = cols;
+            if (apply) {
+                delete[] blobMatrixPins;
+                blobMatrixPins = pins;
+                setMatrix(blobMatrixPins, rows, blobMatrixPins + rows, cols);
+            }
+            break;
+        }
+
+        case CONFIG_GPIO: {
+            uint8_t count = in.readU8();
+            int* pins = apply ? new int[count] : nullptr;
+            for (uint8_t i = 0; i < count; i++) {
+                uint8_t pin = in.readU8();
+                if (pins) pins[i] = pin;
+            }
+            if (!in.ok) {
+                delete[] pins;
+                return false;
+            }
+            layout.gpio = count;
+            if (apply) {
+                delete[] blobGpioPins;
+                blobGpioPins = pins;
+                setGpio(blobGpioPins, count);
+            }
+            break;
+        }
+
+        case CONFIG_MCP: {
+            uint8_t count = in.readU8();
+            if (count > MAX_MCP_DEVICES) return false;
+            McpConfig configs[MAX_MCP_DEVICES];
+            for (uint8_t i = 0; i < count; i++) {
+                McpConfig& config = configs[i];
+                config.address = in.readU8();
+                uint8_t flags = in.readU8();
+                config.usePullups = flags & 1;
+                config.useInterrupts = flags & 2;
+                config.intPin = in.readU8();
+            }
+            if (!in.ok) return false;
+            layout.mcp = count;
+            if (apply) {
+                setMcpDevices(configs, count);
+            }
+            break;
+        }
+
+        case CONFIG_ENCODERS: {
+            uint8_t count = in.readU8();
+            EncoderConfig* configs = apply ? new EncoderConfig[count] : nullptr;
+            bool valid = true;
+            for (uint8_t i = 0; i < count; i++) {
+                EncoderConfig enc;
+                enc.pinA = in.readU8();
+                enc.pinB = in.readU8();
+                uint8_t button = in.readU8();
+                enc.pinBtn = button == 0xFF ? -1 : button;
+                enc.divisor = in.readU8();
+                valid &= enc.divisor >= 1 && enc.divisor <= 4;
+                if (configs) configs[i] = enc;
+            }
+            if (!in.ok || !valid) {
+                delete[] configs;
+                return false;
+            }
+            layout.encoders = count;
+            if (apply) {
+                delete[] encoders;
+                const_cast<int&>(numEncoders) = count;
+                encoders = configs;
+                resetFilters();
+            }
+            break;
+        }
+
+        case CONFIG_FILTERS: {
+            uint8_t table = in.readU8();
+            if (table != 0xFF && table >= layout.profiles) return false;
+            FilterClass classes[MAX_FILTER_CLASSES];
+            for (uint8_t i = 0; i < MAX_FILTER_CLASSES; i++) {
+                classes[i].debounceMs = in.readU16();
+                uint8_t mode = in.readU8();
+                if (mode > DEBOUNCE_EAGER_PRESS) return false;
+                classes[i].mode = (DebounceMode)mode;
+            }
+            if (!in.ok) return false;
+            if (!apply) break;
+
+            if (table == 0xFF) {
+                memcpy(defaultFilters, classes, sizeof(classes));
+            } else {
+                if (!blobFilterTables) {
+                    blobFilterTables = new FilterClass[numProfiles * MAX_FILTER_CLASSES];
+                }
+                FilterClass* profileTable = blobFilterTables + table * MAX_FILTER_CLASSES;
+                memcpy(profileTable, classes, sizeof(classes));
+                setFilterTable(table, profileTable);
+            }
+            break;
+        }
+
+        case CONFIG_INPUT_FILTERS: {
+            uint16_t count = layout.buttons() + layout.encoders;
+            if (in.readU16() != count) return false;
+            if (apply) {
+                initializeFilters();
+            }
+            for (uint16_t i = 0; i < count; i++) {
+                uint8_t filterClass = in.readU8();
+                if (!in.ok || filterClass >= MAX_FILTER_CLASSES) return false;
+                if (apply) inputFilters[i] = filterClass;
+            }
+            break;
+        }
+
+        case CONFIG_SYSTEM: {
+            uint32_t clock = in.readU32();
+            uint32_t powerSaveMs = in.readU32();
+            uint8_t analogPeriod = in.readU8();
+            if (!in.ok || clock < MIN_I2C_CLOCK_HZ || clock > MAX_I2C_CLOCK_HZ || analogPeriod == 0 ||
+                (powerSaveMs != 0 && (powerSaveMs < MIN_POWER_SAVE_MS || powerSaveMs > MAX_POWER_SAVE_MS))) {
+                return false;
+            }
+            if (!apply) break;
+
+            setI2cClock(clock);
+            setAnalogRate(analogPeriod);
+            if (powerSaveMs == 0) {
+                disablePowerSave();
+            } else {
+                setPowerSaveTimeout(powerSaveMs);
+            }
+            break;
+        }
+
+        case CONFIG_ANALOG: {
+            uint8_t count = in.readU8();
+            if (count > MAX_ANALOG_AXES) return false;
+            AnalogAxis* axes = new AnalogAxis[count];
+            bool valid = true;
+            for (uint8_t i = 0; i < count && valid; i++) {
+                AnalogAxisConfig config(in.readU8());
+                config.rawMin = in.readU16();
+                config.rawMax = in.readU16();
+                config.oversample = in.readU8();
+                config.filter = (AnalogFilter)in.readU8();
+                config.smoothing = in.readU8();
+                config.threshold = in.readU16();
+                config.deadzoneLow = in.readU16();
+                config.deadzoneHigh = in.readU16();
+                valid = in.ok && config.filter <= ANALOG_FILTER_ADAPTIVE && axes[i].configure(config);
+            }
+            if (!valid || !apply) {
+                delete[] axes;
+                return valid;
+            }
+            delete[] analogAxes;
+            analogAxes = axes;
+            numAnalogAxes = count;
+            break;
+        }
+
+        case CONFIG_LADDERS: {
+            uint8_t count = in.readU8();
+            if (count > MAX_LADDER_SWITCHES) return false;
+            LadderSwitch* switches = new LadderSwitch[count];
+            uint16_t* levels = new uint16_t[count * MAX_LADDER_POSITIONS];
+            bool valid = true;
+            for (uint8_t i = 0; i < count && valid; i++) {
+                LadderSwitchConfig config(in.readU8());
+                config.positions = in.readU8();
+                config.hysteresis = in.readU16();
+                config.settleMs = in.readU8();
+                if (in.readU8()) {
+                    if (config.positions > MAX_LADDER_POSITIONS) {
+                        valid = false;
+                        break;
+                    }
+                    config.levels = levels + i * MAX_LADDER_POSITIONS;
+                    for (uint8_t p = 0; p < config.positions; p++) {
+                        levels[i * MAX_LADDER_POSITIONS + p] = in.readU16();
+                    }
+                }
+                valid = in.ok && switches[i].configure(config);
+            }
+            if (!valid || !apply) {
+                delete[] switches;
+                delete[] levels;
+                return valid;
+            }
+            delete[] ladders;
+            delete[] blobLevels;
+            ladders = switches;
+            blobLevels = levels;
+            numLadders = count;
+            break;
+        }
+
+        case CONFIG_INPUT_DEBOUNCE: {
+            uint16_t count = layout.buttons();
+            if (in.readU16() != count) return false;
+            if (apply) {
+                initializeFilters();
+                if (!inputDebounce) {
+                    inputDebounce = new uint8_t[count]();
+                }
+            }
+            for (uint16_t i = 0; i < count; i++) {
+                uint8_t ms = in.readU8();
+                if (!in.ok) return false;
+                if (apply) inputDebounce[i] = ms;
+            }
+            break;
+        }
+    }
+    return in.ok;
+}
+
+/**
+ * Writes the current configuration as a blob
+ * Pins, MCP devices, encoders, profiles, filter tables and classes, I2C
+ * clock, power save, analog axes and ladder switches (not curves).
+ * @param store Blob storage
+ * @return true if written and committed
+ */
+bool SimRacingController::saveConfig(ConfigStore& store) {
+    size_t limit = store.size() < CONFIG_MAX_SIZE ? store.size() : CONFIG_MAX_SIZE;
+    ConfigCursor out(store, CONFIG_HEADER_SIZE, limit);
+
+    out.writeU8(CONFIG_PROFILES);
+    out.writeU16(1);
+    out.writeU8(numProfiles);
+
+    if (numRows > 0) {
+        out.writeU8(CONFIG_MATRIX);
+        out.writeU16(2 + numRows + numCols);
+        out.writeU8(numRows);
+        out.writeU8(numCols);
+        for (int i = 0; i < numRows; i++) out.writeU8(rowPins[i]);
+        for (int i = 0; i < numCols; i++) out.writeU8(colPins[i]);
+    }
+
+    if (numGpio > 0) {
+        out.writeU8(CONFIG_GPIO);
+        out.writeU16(1 + numGpio);
+        out.writeU8(numGpio);
+        for (int i = 0; i < numGpio; i++) out.writeU8(gpioPins[i]);
+    }
+
+    if (numMcpDevices > 0) {
+        out.writeU8(CONFIG_MCP);
+        out.writeU16(1 + numMcpDevices * 3);
+        out.writeU8(numMcpDevices);
+        for (uint8_t i = 0; i < numMcpDevices; i++) {
+            out.writeU8(mcpConfigs[i].address);
+            out.writeU8((mcpConfigs[i].usePullups ? 1 : 0) | (mcpConfigs[i].useInterrupts ? 2 : 0));
+            out.writeU8(mcpConfigs[i].intPin);
+        }
+    }
+
+    if (numEncoders > 0) {
+        out.writeU8(CONFIG_ENCODERS);
+        out.writeU16(1 + numEncoders * 4);
+        out.writeU8(numEncoders);
+        for (int i = 0; i < numEncoders; i++) {
+            out.writeU8(encoders[i].pinA);
+            out.writeU8(encoders[i].pinB);
+            out.writeU8(encoders[i].pinBtn < 0 ? 0xFF : encoders[i].pinBtn);
+            out.writeU8(encoders[i].divisor);
+        }
+    }
+
+    // Default table, then the profile tables
+    for (int table = -1; table < numProfiles; table++) {
+        const FilterClass* classes = defaultFilters;
+        if (table >= 0) {
+            if (!profileFilters || !profileFilters[table]) continue;
+            classes = profileFilters[table];
+        }
+        out.writeU8(CONFIG_FILTERS);
+        out.writeU16(1 + MAX_FILTER_CLASSES * 3);
+        out.writeU8(table < 0 ? 0xFF : table);
+        for (uint8_t i = 0; i < MAX_FILTER_CLASSES; i++) {
+            out.writeU16(classes[i].debounceMs);
+            out.writeU8(classes[i].mode);
+        }
+    }
+
+    out.writeU8(CONFIG_SYSTEM);
+    out.writeU16(9);
+    out.writeU32(i2cClock);
+    out.writeU32(powerSaveEnabled ? powerSaveTimeout : 0);
+    out.writeU8(analogPeriodMs);
+
+    if (numAnalogAxes > 0) {
+        out.writeU8(CONFIG_ANALOG);
+        out.writeU16(1 + numAnalogAxes * 14);
+        out.writeU8(numAnalogAxes);
+        for (uint8_t i = 0; i < numAnalogAxes; i++) {
+            const AnalogAxisConfig& config = analogAxes[i].getConfig();
+            out.writeU8(config.pin);
+            out.writeU16(config.rawMin);
+            out.writeU16(config.rawMax);
+            out.writeU8(config.oversample);
+            out.writeU8(config.filter);
+            out.writeU8(config.smoothing);
+            out.writeU16(config.threshold);
+            out.writeU16(config.deadzoneLow);
+            out.writeU16(config.deadzoneHigh);
+        }
+    }
+
+    if (numLadders > 0) {
+        uint16_t size = 1;
+        for (uint8_t i = 0; i < numLadders; i++) {
+            const LadderSwitchConfig& config = ladders[i].getConfig();
+            size += 6 + (config.levels ? config.positions * 2 : 0);
+        }
+        out.writeU8(CONFIG_LADDERS);
+        out.writeU16(size);
+        out.writeU8(numLadders);
+        for (uint8_t i = 0; i < numLadders; i++) {
+            const LadderSwitchConfig& config = ladders[i].getConfig();
+            out.writeU8(config.pin);
+            out.writeU8(config.positions);
+            out.writeU16(config.hysteresis);
+            out.writeU8(config.settleMs);
+            out.writeU8(config.levels ? 1 : 0);
+            for (uint8_t p = 0; config.levels && p < config.positions; p++) {
+                out.writeU16(config.levels[p]);
+            }
+        }
+    }
+
+    // Filter classes last: the input configuration above resets them
+    if (inputFilters) {
+        out.writeU8(CONFIG_INPUT_FILTERS);
+        out.writeU16(2 + numFilterInputs);
+        out.writeU16(numFilterInputs);
+        for (uint16_t i = 0; i < numFilterInputs; i++) out.writeU8(inputFilters[i]);
+    }
+    if (inputDebounce) {
+        uint16_t count = filterIndex(SOURCE_ENCODER);
+        out.writeU8(CONFIG_INPUT_DEBOUNCE);
+        out.writeU16(2 + count);
+        out.writeU16(count);
+        for (uint16_t i = 0; i < count; i++) out.writeU8(inputDebounce[i]);
+    }
+
+    size_t length = out.getPosition() - CONFIG_HEADER_SIZE;
+    uint8_t header[CONFIG_HEADER_SIZE] = {
+        'S', 'R', 'C', 'F', CONFIG_VERSION, 0,
+        (uint8_t)length, (uint8_t)(length >> 8), (uint8_t)out.crc, (uint8_t)(out.crc >> 8)
+    };
+    if (!out.ok || !store.write(0, header, CONFIG_HEADER_SIZE) || !store.commit()) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Config blob not written");
+        return false;
+    }
+    return true;
+}
+
+/*
+   Encoder Configuration
+*/
+
+/**
+ * Configures encoders without buttons
+ * @param encoderPinsA Array of first encoder pins
+ * @param encoderPinsB Array of second encoder pins
+ * @param numEncoders Number of encoders
+ */
+void SimRacingController::setEncoders(const int* encoderPinsA, const int* encoderPinsB,
+                                      int numEncoders) {
+    setEncoders(encoderPinsA, encoderPinsB, nullptr, numEncoders);
+}
+
+/**
+ * Configures encoders with optional buttons
+ * @param encoderPinsA Array of first encoder pins
+ * @param encoderPinsB Array of second encoder pins
+ * @param encoderBtnPins Array of button pins (optional)
+ * @param numEncoders Number of encoders
+ */
+void SimRacingController::setEncoders(const int* encoderPinsA, const int* encoderPinsB,
+                                      const int* encoderBtnPins, int numEncoders) {
+    EncoderInitConfig config(encoderPinsA, encoderPinsB, encoderBtnPins, numEncoders);
+    configureEncoders(config);
+}
+
+/**
+ * Internal encoder configuration
+ * @param config Encoder configuration structure
+ */
+void SimRacingController::configureEncoders(const EncoderInitConfig& config) {
+    delete[] encoders;
+
+    const_cast<int&>(numEncoders) = config.count;
+
+    encoders = new EncoderConfig[config.count];
+    for (int i = 0; i < config.count; i++) {
+        encoders[i].pinA = config.pinsA[i];
+        encoders[i].pinB = config.pinsB[i];
+        encoders[i].pinBtn = config.btnPins ? config.btnPins[i] : -1;
+        encoders[i].divisor = 4;
+        encoders[i].valid = true;
+        encoders[i].errorReported = false;
+    }
+
+    resetFilters();
+}
+
+/*
+   Array Management
+*/
+
+/**
+ * Allocates the input frame and debounce state for the current configuration
+ * Layout: matrix rows, GPIO words, MCP ports, encoder A/B words, encoder button words
+ */
+void SimRacingController::initializeFrame() {
+    uint8_t encoderWords = (numEncoders * 2 + 31) / 32;
+    uint8_t buttonWords = (numEncoders + 31) / 32;
+
+    frameGpioBase = numRows;
+    frameMcpBase = frameGpioBase + (numGpio + 31) / 32;
+    frameEncoderBase = frameMcpBase + numMcpDevices;
+    frameButtonBase = frameEncoderBase + encoderWords;
+    frameSize = frameButtonBase + buttonWords;
+    nextScanWord = 0;
+
+    delete[] frameWords;
+    delete[] lastRawWords;
+    delete[] stableWords;
+    delete[] validMasks;
+    delete[] waitingWords;
+    delete[] activeWords;
+    delete[] wordInputBase;
+    delete[] inputDeadlines;
+    delete[] publishedWords;
+    delete[] publishedEncoders;
+    delete[] publishedAnalog;
+    delete[] publishedSwitches;
+    frameWords = new uint32_t[frameSize]();
+    lastRawWords = new uint32_t[frameSize]();
+    stableWords = new uint32_t[frameSize]();
+    validMasks = new uint32_t[frameSize]();
+    waitingWords = new uint32_t[frameSize]();
+    activeWords = new uint32_t[(frameSize + 31) / 32]();
+    wordInputBase = new uint16_t[frameSize]();
+    inputDeadlines = new unsigned long[filterIndex(SOURCE_ENCODER)]();
+    publishedWords = new uint32_t[frameSize]();
+    publishedEncoders = new EncoderSnapshot[numEncoders];
+    publishedAnalog = new uint16_t[numAnalogAxes]();
+    publishedSwitches = new uint8_t[numLadders];
+
+    // Timer ids: one per frame word, one per encoder, power save, gestures,
+    // analog readings, one per MCP device
+    powerSaveTimer = frameSize + numEncoders;
+    gestureTimer = powerSaveTimer + 1;
+    analogTimer = gestureTimer + 1;
+    mcpTimerBase = analogTimer + 1;
+    timers.begin(mcpTimerBase + numMcpDevices);
+    gestureSync = false;
+    analogDue = false;
+
+    // Map each debounced bit to its input index
+    for (int row = 0; row < numRows; row++) {
+        validMasks[row] = numCols >= 32 ? 0xFFFFFFFFUL : (1UL << numCols) - 1;
+        wordInputBase[row] = row * numCols;
+    }
+    for (int i = 0; i < numGpio; i++) {
+        validMasks[frameGpioBase + i / 32] |= 1UL << (i % 32);
+    }
+    for (uint8_t w = frameGpioBase; w < frameMcpBase; w++) {
+        wordInputBase[w] = filterIndex(SOURCE_GPIO) + (w - frameGpioBase) * 32;
+    }
+    for (uint8_t i = 0; i < numMcpDevices; i++) {
+        validMasks[frameMcpBase + i] = 0xFFFF;
+        wordInputBase[frameMcpBase + i] = filterIndex(SOURCE_MCP) + i * 16;
+    }
+    for (int i = 0; i < numEncoders; i++) {
+        validMasks[frameEncoderBase + i / 16] |= 3UL << ((i % 16) * 2);
+        if (encoders[i].pinBtn >= 0) {
+            validMasks[frameButtonBase + i / 32] |= 1UL << (i % 32);
+        }
+    }
+    for (uint8_t w = frameButtonBase; w < frameSize; w++) {
+        wordInputBase[w] = filterIndex(SOURCE_ENCODER_BUTTON) + (w - frameButtonBase) * 32;
+    }
+
+    initializeFilters();
+    prepareLearning();
+    resetDeadlines(0);
+#if defined(ENCODER_PORT_READS)
+    prepareEncoderPorts();
+#endif
+}
+
+/**
+ * Starts every debounced input inside its lockout window
+ * @param time Time of the last (assumed) change (ms)
+ */
+void SimRacingController::resetDeadlines(unsigned long time) {
+    for (uint16_t i = 0; i < filterIndex(SOURCE_ENCODER); i++) {
+        unsigned long ms = inputDebounce && inputDebounce[i] ? inputDebounce[i]
+                                                             : activeFilters[inputFilters[i]].debounceMs;
+        inputDeadlines[i] = time + ms + 1;
+    }
+}
+
+/*
+   Configuration Validation
+*/
+
+/**
+ * Validates all pin assignments
+ * @return true if valid, false otherwise
+ */
+bool SimRacingController::validatePins() {
+    // Matrix pins validation
+    for (int i = 0; i < numRows; i++) {
+        if (rowPins[i] < 0 || rowPins[i] >= NUM_DIGITAL_PINS) {
+            lastError = ControllerError(ControllerError::INVALID_PIN, "Invalid matrix row pin");
+            return false;
+        }
+    }
+    
+    for (int i = 0; i < numCols; i++) {
+        if (colPins[i] < 0 || colPins[i] >= NUM_DIGITAL_PINS) {
+            lastError = ControllerError(ControllerError::INVALID_PIN, "Invalid matrix column pin");
+            return false;
+        }
+    }
+
+    // GPIO pins validation
+    for (int i = 0; i < numGpio; i++) {
+        if (gpioPins[i] < 0 || gpioPins[i] >= NUM_DIGITAL_PINS) {
+            lastError = ControllerError(ControllerError::INVALID_PIN, "Invalid GPIO pin");
+            return false;
+        }
+    }
+
+    // Encoder pins validation
+    for (int i = 0; i < numEncoders; i++) {
+        if (encoders[i].pinA < 0 || encoders[i].pinA >= NUM_DIGITAL_PINS ||
+            encoders[i].pinB < 0 || encoders[i].pinB >= NUM_DIGITAL_PINS) {
+            lastError = ControllerError(ControllerError::INVALID_PIN, "Invalid encoder pin");
+            return false;
+        }
+        
+        if (encoders[i].pinBtn >= 0 && encoders[i].pinBtn >= NUM_DIGITAL_PINS) {
+            lastError = ControllerError(ControllerError::INVALID_PIN, "Invalid encoder button pin");
+            return false;
+        }
+    }
+
+    // Analog pins validation
+    for (uint8_t i = 0; i < numAnalogAxes; i++) {
+        int pin = analogAxes[i].getConfig().pin;
+        if (pin < 0 || pin >= NUM_DIGITAL_PINS) {
+            lastError = ControllerError(ControllerError::INVALID_PIN, "Invalid analog pin");
+            return false;
+        }
+    }
+    for (uint8_t i = 0; i < numLadders; i++) {
+        int pin = ladders[i].getConfig().pin;
+        if (pin < 0 || pin >= NUM_DIGITAL_PINS) {
+            lastError = ControllerError(ControllerError::INVALID_PIN, "Invalid ladder switch pin");
+            return false;
         }
-        mcpInitialized = true;
     }
 
-    // Configure matrix pins
-    for (int i = 0; i < numRows; i++) {
-        pinMode(rowPins[i], OUTPUT);
-        digitalWrite(rowPins[i], HIGH);
+    return true;
+}
+
+/**
+ * Validates complete configuration
+ * @return true if valid, false otherwise
+ */
+bool SimRacingController::validateConfiguration() {
+    if (numRows > 0 && numCols > 0) {
+        if (!rowPins || !colPins) {
+            lastError = ControllerError(ControllerError::INVALID_CONFIG, "Matrix pins not configured");
+            return false;
+        }
+        if (numCols > MAX_MATRIX_COLS) {
+            lastError = ControllerError(ControllerError::INVALID_CONFIG, "Too many matrix columns");
+            return false;
+        }
+    }
+    
+    if (numGpio > 0 && !gpioPins) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "GPIO pins not configured");
+        return false;
+    }
+    
+    if (numEncoders > 0 && !encoders) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Encoders not configured");
+        return false;
+    }
+    
+    if (numMcpDevices > 0 && !mcpConfigs) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "MCP devices not configured");
+        return false;
+    }
+
+    if (frameWordCount(numRows, numGpio, numMcpDevices, numEncoders) > MAX_INPUT_FRAME_WORDS) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Too many inputs");
+        return false;
+    }
+    
+    return validatePins();
+}
+
+/**
+ * Counts the words of an input frame (see initializeFrame)
+ * @return Matrix rows, GPIO words, MCP ports, encoder A/B and button words
+ */
+uint16_t SimRacingController::frameWordCount(int rows, int gpio, int mcp, int encoders) {
+    return rows + (gpio + 31) / 32 + mcp + (encoders * 2 + 31) / 32 + (encoders + 31) / 32;
+}
+
+/*
+   Core Initialization
+*/
+
+/**
+ * Initializes all hardware components
+ * @return true if successful, false on error
+ */
+bool SimRacingController::begin() {
+    clearError();
+    
+    if (!validateConfiguration()) {
+        return false;
+    }
+
+    // Initialize I2C if MCP devices are configured
+    if (numMcpDevices > 0) {
+        if (!claimMcpAddresses()) {
+            return false;
+        }
+        startI2C();
+
+        // Initialize each MCP device
+        for (uint8_t i = 0; i < numMcpDevices; i++) {
+            mcpHealth[i] = McpHealth();
+            if (!initializeMcp(i)) {
+                lastError = ControllerError(ControllerError::MCP_ERROR, "Failed to initialize MCP");
+                return false;
+            }
+        }
+        mcpInitialized = true;
+    }
+
+    // Configure matrix pins
+    for (int i = 0; i < numRows; i++) {
+        pinMode(rowPins[i], OUTPUT);
+        digitalWrite(rowPins[i], HIGH);
+    }
+    for (int i = 0; i < numCols; i++) {
+        pinMode(colPins[i], INPUT_PULLUP);
+    }
+
+    // Configure GPIO pins
+    for (int i = 0; i < numGpio; i++) {
+        pinMode(gpioPins[i], INPUT_PULLUP);
+    }
+
+    // Configure encoder pins
+    for (int i = 0; i < numEncoders; i++) {
+        pinMode(encoders[i].pinA, INPUT_PULLUP);
+        pinMode(encoders[i].pinB, INPUT_PULLUP);
+        if (encoders[i].pinBtn >= 0) {
+            pinMode(encoders[i].pinBtn, INPUT_PULLUP);
+        }
+        encoders[i].lastState = (digitalRead(encoders[i].pinA) << 1) | digitalRead(encoders[i].pinB);
+        encoders[i].steps = 0;
+        encoders[i].stepReported = false;
+        encoders[i].pending = false;
+        encoders[i].errorRate = 0;
+        encoders[i].valid = true;
+        encoders[i].errorReported = false;
+    }
+
+    // Configure analog pins
+    for (uint8_t i = 0; i < numAnalogAxes; i++) {
+        pinMode(analogAxes[i].getConfig().pin, INPUT);
+        analogAxes[i].reset();
+    }
+    for (uint8_t i = 0; i < numLadders; i++) {
+        pinMode(ladders[i].getConfig().pin, INPUT);
+        ladders[i].reset();
+    }
+
+    initializeFrame();
+    if (recorder) {
+        recorder->begin(frameSize);
+    }
+    if (gestures) {
+        gestures->reset();
+    }
+    resetScanStats();
+
+    // First sample of interrupt driven MCPs (later reads wait for a change)
+    for (uint8_t i = 0; i < numMcpDevices; i++) {
+        uint16_t reading;
+        if (hasMcpInterrupt(i) && readMcpPorts(i, reading)) {
+            frameWords[frameMcpBase + i] = (uint16_t)~reading;
+        }
+    }
+
+    publishState();
+    lastActivityTime = millis();
+    lastEdgeTime = lastActivityTime;
+    tierTime = lastActivityTime;
+    rateTier = 0;
+    armPowerSave();
+    if (numAnalogAxes > 0 || numLadders > 0) {
+        timers.schedule(analogTimer, lastActivityTime);
+    }
+    return true;
+}
+
+/**
+ * Loads a configuration blob and initializes the hardware
+ * @param store Blob storage
+ * @return true if successful, false on error (see getLastError())
+ */
+bool SimRacingController::begin(ConfigStore& store) {
+    return loadConfig(store) && begin();
+}
+
+/*
+   Update Methods
+*/
+
+/**
+ * Standard update method (blocking)
+ */
+void SimRacingController::update() {
+    if (!tryUpdate()) {
+        waitForUpdate();
+    }
+}
+
+/**
+ * Non-blocking update attempt
+ * @return true if update successful, false if busy
+ */
+bool SimRacingController::tryUpdate() {
+    if (!scanLock.tryLock()) {
+        return false;
+    }
+    
+    unsigned long startMicros = micros();
+    unsigned long now = millis();
+    
+    // Expired timers (power save timeout included)
+    if (frameWords) {
+        expireTimers(now);
+    }
+    
+    if (!isPowerSaving && frameWords && governScanRate(now, startMicros)) {
+        scanInputs(now, startMicros);
+    }
+    
+    scanLock.unlock();
+
+    // With the scan task the stream is written by processEvents()
+    if (telemetry && !taskRunning) {
+        sendTelemetry(now);
+    }
+    return true;
+}
+
+/**
+ * Samples one matrix row
+ * @param row Row index
+ */
+void SimRacingController::readRow(int row) {
+    digitalWrite(rowPins[row], LOW);
+    delayMicroseconds(10);
+
+    uint32_t rowWord = 0;
+    for (int col = 0; col < numCols; col++) {
+        if (digitalRead(colPins[col]) == LOW) {
+            rowWord |= (1UL << col);
+        }
+    }
+    frameWords[row] = rowWord;
+
+    digitalWrite(rowPins[row], HIGH);
+}
+
+/**
+ * Samples the GPIO buttons of one frame word
+ * @param word Frame word (frameGpioBase to frameMcpBase - 1)
+ */
+void SimRacingController::readGpioWord(uint8_t word) {
+    int first = (word - frameGpioBase) * 32;
+    int end = first + 32 < numGpio ? first + 32 : numGpio;
+    uint32_t bits = 0;
+    for (int i = first; i < end; i++) {
+        if (digitalRead(gpioPins[i]) == LOW) {
+            bits |= 1UL << (i - first);
+        }
+    }
+    frameWords[word] = bits;
+}
+
+/**
+ * Samples one MCP23017 (a failed read keeps the previous sample)
+ * @param device Device index
+ */
+void SimRacingController::readMcp(uint8_t device) {
+    // No bus traffic for offline devices (re-probed by their timer)
+    // and while the interrupt line reports no change
+    if (!mcpInitialized || !mcpHealth[device].online ||
+        (hasMcpInterrupt(device) && digitalRead(mcpConfigs[device].intPin) == HIGH)) {
+        return;
+    }
+
+    uint16_t reading;
+    if (readMcpPorts(device, reading)) {
+        frameWords[frameMcpBase + device] = (uint16_t)~reading;
+        mcpHealth[device].failures = 0;
+    } else {
+        handleMcpFailure(device);
+    }
+}
+
+/**
+ * Samples encoder A/B levels and encoder buttons
+ */
+void SimRacingController::readEncoders() {
+#if defined(ENCODER_PORT_READS)
+    if (encoderPorts) {
+        readEncoderPorts();
+        return;
+    }
+#endif
+
+    // A/B as raw levels, button active low
+    for (int i = 0; i < numEncoders; i++) {
+        uint32_t& abWord = frameWords[frameEncoderBase + i / 16];
+        uint8_t shift = (i % 16) * 2;
+        uint32_t state = (digitalRead(encoders[i].pinA) << 1) | digitalRead(encoders[i].pinB);
+        abWord = (abWord & ~(3UL << shift)) | (state << shift);
+
+        if (encoders[i].pinBtn >= 0) {
+            uint32_t& btnWord = frameWords[frameButtonBase + i / 32];
+            uint32_t mask = 1UL << (i % 32);
+            if (digitalRead(encoders[i].pinBtn) == LOW) btnWord |= mask;
+            else btnWord &= ~mask;
+        }
+    }
+}
+
+#if defined(ENCODER_PORT_READS)
+/**
+ * Groups the encoder pins by input register
+ * Without a register for every pin the encoders are read with digitalRead().
+ */
+void SimRacingController::prepareEncoderPorts() {
+    delete[] encoderPorts;
+    encoderPorts = nullptr;
+    numEncoderPorts = 0;
+    encoderPortsRead = false;
+    if (numEncoders == 0) return;
+
+    EncoderPort* ports = new EncoderPort[numEncoders * 3];
+    uint8_t count = 0;
+    for (int i = 0; i < numEncoders; i++) {
+        EncoderConfig& enc = encoders[i];
+        if (!mapEncoderPin(ports, count, enc.pinA, enc.portA, enc.maskA) ||
+            !mapEncoderPin(ports, count, enc.pinB, enc.portB, enc.maskB) ||
+            (enc.pinBtn >= 0 && !mapEncoderPin(ports, count, enc.pinBtn, enc.portBtn, enc.maskBtn))) {
+            delete[] ports;
+            return;
+        }
+    }
+
+    encoderPorts = ports;
+    numEncoderPorts = count;
+}
+
+/**
+ * Finds or adds the input register of an encoder pin
+ * @param ports Registers found so far
+ * @param count Number of registers, incremented when one is added
+ * @param pin Arduino pin
+ * @param port Set to the register index
+ * @param mask Set to the pin bit in the register
+ * @return false if the pin has no input register
+ */
+bool SimRacingController::mapEncoderPin(EncoderPort* ports, uint8_t& count, int pin,
+                                        uint8_t& port, uint32_t& mask) {
+    PortRegister reg = portInputRegister(digitalPinToPort(pin));
+    mask = digitalPinToBitMask(pin);
+    if (!reg || mask == 0) return false;
+
+    for (port = 0; port < count && !(ports[port].reg == reg); port++) {}
+    if (port == count) {
+        ports[count].reg = reg;
+        ports[count].mask = 0;
+        ports[count].levels = 0;
+        count++;
+    }
+    ports[port].mask |= mask;
+    return true;
+}
+
+/**
+ * Samples encoder A/B levels and encoder buttons with one read per register
+ * The encoder words are only rebuilt when an encoder pin changed, so an idle
+ * sample costs the register reads whatever the number of encoders.
+ */
+void SimRacingController::readEncoderPorts() {
+    bool changed = !encoderPortsRead;
+    for (uint8_t p = 0; p < numEncoderPorts; p++) {
+        uint32_t levels = *encoderPorts[p].reg & encoderPorts[p].mask;
+        changed |= levels != encoderPorts[p].levels;
+        encoderPorts[p].levels = levels;
+    }
+    if (!changed) return;
+    encoderPortsRead = true;
+
+    // A/B as raw levels, button active low
+    for (uint8_t w = frameEncoderBase; w < frameSize; w++) {
+        frameWords[w] = 0;
+    }
+    for (int i = 0; i < numEncoders; i++) {
+        const EncoderConfig& enc = encoders[i];
+        uint32_t state = (encoderPorts[enc.portA].levels & enc.maskA ? 2 : 0) |
+                         (encoderPorts[enc.portB].levels & enc.maskB ? 1 : 0);
+        frameWords[frameEncoderBase + i / 16] |= state << ((i % 16) * 2);
+        if (enc.pinBtn >= 0 && !(encoderPorts[enc.portBtn].levels & enc.maskBtn)) {
+            frameWords[frameButtonBase + i / 32] |= 1UL << (i % 32);
+        }
+    }
+}
+#endif
+
+/**
+ * Samples and decodes the encoders and encoder buttons
+ * @param now Sample time (ms)
+ * @param activityDetected Set if an encoder button changed
+ * @return true if the sample has to be recorded (not quiet)
+ */
+bool SimRacingController::sampleEncoders(unsigned long now, bool& activityDetected) {
+    readEncoders();
+    bool quiet = encodersQuiet(frameWords);
+    activityDetected |= debounceWords(frameButtonBase, frameSize, now, frameWords);
+    processEncoders(now, frameWords);
+    return !quiet;
+}
+
+/**
+ * Checks whether decoding the encoder part of a frame would do nothing
+ * @param words Frame words
+ * @return true if the encoder A/B and button words match the last samples
+ *         and no encoder or encoder button waits for its deadline
+ */
+bool SimRacingController::encodersQuiet(const uint32_t* words) const {
+    for (uint8_t w = frameEncoderBase; w < frameSize; w++) {
+        if ((words[w] & validMasks[w]) != lastRawWords[w]) return false;
+        if (w < frameButtonBase ? waitingWords[w] != 0
+                                : (activeWords[w / 32] & (1UL << (w % 32))) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Checks and advances the sample deadline of a source
+ * A source more than one period late restarts from now instead of
+ * catching up with back-to-back samples.
+ * @param source Input source (SOURCE_MATRIX to SOURCE_ENCODER)
+ * @param nowMicros Current time (us)
+ * @return true if the source is due
+ */
+bool SimRacingController::takeSample(InputSource source, unsigned long nowMicros) {
+    uint32_t period = samplePeriodUs[source];
+    if (period == 0) return true;
+
+    unsigned long late = nowMicros - lastSampleMicros[source];
+    if (late < period) return false;
+    lastSampleMicros[source] = late < 2 * period ? lastSampleMicros[source] + period : nowMicros;
+    return true;
+}
+
+/**
+ * Runs one scan, or one slice of it with a scan budget
+ * Encoders come first: they are sampled at the start of the call and
+ * again between frame words whenever their period has passed, so slow
+ * I2C reads do not make them miss quadrature states. Matrix, GPIO and MCP
+ * words are read in order for the sources due at the start of the scan
+ * (see setSampleRate()); with a budget (see setScanBudget()) reading stops
+ * once it is spent, at least one word per call, and resumes on the next
+ * call. The button words are debounced once the last word was read.
+ * The recorder gets one frame per completed scan, carrying the last
+ * encoder sample of its call, and one per other encoder sample (see
+ * FrameKind), so a replay processes inputs in the same order. Quiet
+ * encoder samples are not recorded, replaying them would do nothing.
+ * @param now Current time (ms)
+ * @param startMicros micros() at the start of the call
+ */
+void SimRacingController::scanInputs(unsigned long now, unsigned long startMicros) {
+    bool activityDetected = false;
+    bool encodersSampled = false;       // Sample not recorded yet
+    if (takeSample(SOURCE_ENCODER, startMicros)) {
+        encodersSampled = sampleEncoders(now, activityDetected);
+    }
+
+    // Sources read by this scan
+    if (nextScanWord == 0) {
+        scanSources = 0;
+        for (uint8_t source = SOURCE_MATRIX; source <= SOURCE_MCP; source++) {
+            if (takeSample((InputSource)source, startMicros)) {
+                scanSources |= 1 << source;
+            }
+        }
+    }
+
+    // Frame words in order: matrix rows, GPIO, MCP devices
+    while (nextScanWord < frameEncoderBase) {
+        uint8_t w = nextScanWord++;
+        if (w < frameGpioBase) {
+            if (!(scanSources & (1 << SOURCE_MATRIX))) continue;
+            readRow(w);
+        } else if (w < frameMcpBase) {
+            if (!(scanSources & (1 << SOURCE_GPIO))) continue;
+            readGpioWord(w);
+        } else {
+            if (!(scanSources & (1 << SOURCE_MCP))) continue;
+            readMcp(w - frameMcpBase);
+        }
+
+        unsigned long nowMicros = micros();
+        if (samplePeriodUs[SOURCE_ENCODER] && takeSample(SOURCE_ENCODER, nowMicros)) {
+            // The previous sample is overwritten by this one
+            if (encodersSampled) {
+                recordFrame(now, FRAME_ENCODERS);
+            }
+            encodersSampled = sampleEncoders(now, activityDetected);
+        }
+        if (scanBudgetUs && nowMicros - startMicros >= scanBudgetUs) break;
+    }
+
+    bool completed = nextScanWord >= frameEncoderBase;
+    if (completed) {
+        nextScanWord = 0;
+        bool encodersDue = encodersSampled || encodersQuiet(frameWords);
+        recordFrame(now, encodersDue ? FRAME_SCAN : FRAME_BUTTONS);
+        encodersSampled = false;
+        activityDetected |= debounceWords(0, frameEncoderBase, now, frameWords);
+
+        // A held input keeps the full scan rate (its release is an edge too)
+        if (numRateTiers && isInputHeld()) {
+            lastEdgeTime = now;
+        }
+    }
+
+    // Scan slice ended before the last word
+    if (encodersSampled) {
+        recordFrame(now, FRAME_ENCODERS);
+    }
+
+    if (analogDue) {
+        analogDue = false;
+        sampleAnalog(now);
+    }
+
+    finishInputs(now, activityDetected);
+    recordScanTime(startMicros, completed);
+}
+
+/**
+ * Passes the current frame to the recorder
+ * @param now Sample time (ms)
+ * @param kind Parts of the frame sampled by the scan
+ */
+void SimRacingController::recordFrame(unsigned long now, FrameKind kind) {
+    if (recorder) {
+        recorder->record(now, frameWords, kind);
+    }
+}
+
+/**
+ * Debounces and decodes one frame of samples
+ * Same order as scanInputs(): encoder buttons and encoders first, then
+ * the matrix, GPIO and MCP words.
+ * @param now Sample time (ms)
+ * @param words Frame words (see initializeFrame)
+ * @param kind Parts of the frame to process
+ */
+void SimRacingController::processInputs(unsigned long now, const uint32_t* words, FrameKind kind) {
+    bool activityDetected = false;
+
+    if (kind != FRAME_BUTTONS) {
+        activityDetected |= debounceWords(frameButtonBase, frameSize, now, words);
+        processEncoders(now, words);
+    }
+    if (kind != FRAME_ENCODERS) {
+        activityDetected |= debounceWords(0, frameEncoderBase, now, words);
+    }
+
+    finishInputs(now, activityDetected);
+}
+
+/**
+ * Decodes the encoder A/B words
+ * Only encoders whose levels differ from the decoded state or that hold a
+ * jump or a first quarter step in the glitch filter are updated.
+ * @param now Sample time (ms)
+ * @param words Frame words
+ */
+void SimRacingController::processEncoders(unsigned long now, const uint32_t* words) {
+    const uint8_t* encoderFilters = inputFilters + filterIndex(SOURCE_ENCODER);
+    for (uint8_t w = frameEncoderBase; w < frameButtonBase; w++) {
+        uint32_t moved = ((words[w] & validMasks[w]) ^ lastRawWords[w]) | waitingWords[w];
+        if (moved) {
+            lastEdgeTime = now;
+        }
+        for (uint8_t slot = 0; moved; slot++, moved >>= 2) {
+            if (!(moved & 3)) continue;
+
+            int i = (w - frameEncoderBase) * 16 + slot;
+            uint8_t shift = slot * 2;
+            updateEncoder(i, now, (words[w] >> shift) & 3, activeFilters[encoderFilters[i]].debounceMs);
+            lastRawWords[w] = (lastRawWords[w] & ~(3UL << shift)) |
+                              ((uint32_t)encoders[i].lastState << shift);
+            waitingWords[w] = (waitingWords[w] & ~(3UL << shift)) |
+                              (encoders[i].pending || encoders[i].holdsStep() ? 3UL << shift : 0);
+        }
+    }
+}
+
+/**
+ * Ends the processing of a scan
+ * @param now Sample time (ms)
+ * @param activityDetected true if a debounced state changed
+ */
+void SimRacingController::finishInputs(unsigned long now, bool activityDetected) {
+    // Follow the next gesture deadline after edges or expiries
+    if (gestureSync) {
+        unsigned long deadline;
+        if (gestures && gestures->getNextDeadline(deadline)) {
+            timers.schedule(gestureTimer, deadline);
+        } else {
+            timers.cancel(gestureTimer);
+        }
+        gestureSync = false;
+    }
+
+    if (activityDetected) {
+        lastActivityTime = now;
+        armPowerSave();
+    }
+
+    if (stateDirty) {
+        publishState();
+    }
+}
+
+/**
+ * Handles all timers due at the given time
+ * Word timers release their waiting bits to the next debounce pass
+ * @param now Current time (ms)
+ */
+void SimRacingController::expireTimers(unsigned long now) {
+    uint16_t id;
+    while (timers.pop(now, id)) {
+        if (id < frameSize) {
+            waitingWords[id] = 0;
+            activeWords[id / 32] |= 1UL << (id % 32);
+        } else if (id < powerSaveTimer) {
+            EncoderConfig& enc = encoders[id - frameSize];
+            enc.speed = 0;                          // No change for a second
+            decayEncoderErrors(enc, now);
+            if (enc.errorRate) {
+                timers.schedule(id, now + ENCODER_ERROR_WINDOW_MS);
+            }
+            stateDirty = true;
+        } else if (id == powerSaveTimer) {
+            sleep();
+        } else if (id == gestureTimer) {
+            if (gestures) {
+                gestures->update(now, currentProfile);
+                gestureSync = true;
+            }
+        } else if (id == analogTimer) {
+            analogDue = true;       // Read by the hardware scan, not by replays
+            timers.schedule(analogTimer, now + analogPeriodMs);
+        } else {
+            probeMcp(id - mcpTimerBase, now);
+        }
+    }
+
+    if (stateDirty) {
+        publishState();
+    }
+}
+
+/**
+ * Publishes debounced states and encoder state for the getters
+ * Called by the scan (single writer) before each callback and at the end
+ * of a scan that changed something, so getters are current inside
+ * callbacks and consistent from other cores.
+ */
+void SimRacingController::publishState() {
+    stateSeq.beginWrite();
+    for (uint8_t w = 0; w < frameSize; w++) {
+        publishedWords[w] = stableWords[w];
+    }
+    for (int i = 0; i < numEncoders; i++) {
+        const EncoderConfig& enc = encoders[i];
+        EncoderSnapshot& snapshot = publishedEncoders[i];
+        snapshot.position = enc.position;
+        snapshot.speed = enc.speed;
+        snapshot.direction = enc.lastDirection;
+        snapshot.valid = enc.valid;
+        snapshot.errorRate = enc.errorRate;
+    }
+    for (uint8_t i = 0; i < numAnalogAxes; i++) {
+        publishedAnalog[i] = analogAxes[i].getValue();
+    }
+    for (uint8_t i = 0; i < numLadders; i++) {
+        publishedSwitches[i] = ladders[i].getPosition();
+    }
+    stateSeq.endWrite();
+    stateDirty = false;
+}
+
+/**
+ * Reads one published frame word
+ * @param word Frame word index
+ * @return Debounced states (bit set = active)
+ */
+uint32_t SimRacingController::readPublishedWord(uint8_t word) const {
+    uint32_t seq;
+    uint32_t value;
+    do {
+        seq = stateSeq.beginRead();
+        value = publishedWords[word];
+    } while (stateSeq.retry(seq));
+    return value;
+}
+
+/**
+ * Reads the published state of one encoder
+ * @param index Encoder index
+ * @return Position, speed, direction and validity of the same scan
+ */
+SimRacingController::EncoderSnapshot SimRacingController::readPublishedEncoder(int index) const {
+    uint32_t seq;
+    EncoderSnapshot snapshot;
+    do {
+        seq = stateSeq.beginRead();
+        snapshot = publishedEncoders[index];
+    } while (stateSeq.retry(seq));
+    return snapshot;
+}
+
+/**
+ * Schedules the power save timeout from the last activity
+ * The timer only runs while power save is enabled and awake.
+ */
+void SimRacingController::armPowerSave() {
+    if (powerSaveEnabled && !isPowerSaving && frameWords) {
+        timers.schedule(powerSaveTimer, lastActivityTime + powerSaveTimeout + 1);
+    } else {
+        timers.cancel(powerSaveTimer);
+    }
+}
+
+/**
+ * Debounces a range of frame words
+ * A pending bit that is not due yet waits for its word timer, so after a
+ * pass every pending bit is waiting. A word is therefore only examined when
+ * its samples changed or its timer expired (active set), a quiet word costs
+ * one compare. Only the bits that moved are filtered one by one.
+ * @param first First word
+ * @param end Word after the last
+ * @param now Sample time (ms)
+ * @param words Frame words
+ * @return true if a debounced state changed
+ */
+bool SimRacingController::debounceWords(uint8_t first, uint8_t end, unsigned long now,
+                                        const uint32_t* words) {
+    bool changed = false;
+
+    for (uint8_t w = first; w < end; w++) {
+        uint32_t raw = words[w] & validMasks[w];
+        uint32_t wordBit = 1UL << (w % 32);
+        if (raw == lastRawWords[w] && !(activeWords[w / 32] & wordBit)) {
+            continue;       // Quiet word
+        }
+        activeWords[w / 32] &= ~wordBit;
+
+        uint32_t toggled = raw ^ lastRawWords[w];
+        uint32_t pending = raw ^ stableWords[w];
+        lastRawWords[w] = raw;
+        if (toggled) {
+            lastEdgeTime = now;
+        }
+
+        uint32_t active = toggled | (pending & ~waitingWords[w]);
+        if (!active) continue;
+
+        unsigned long* deadlines = inputDeadlines + wordInputBase[w];
+        const uint8_t* classes = inputFilters + wordInputBase[w];
+        const uint8_t* times = inputDebounce ? inputDebounce + wordInputBase[w] : nullptr;
+        bool armed = timers.isScheduled(w);
+        unsigned long wake = timers.getDeadline(w);
+        bool rearm = false;
+
+        for (uint8_t bit = 0; active; bit++, active >>= 1) {
+            if (!(active & 1)) continue;
+
+            uint32_t mask = 1UL << bit;
+            bool reading = (raw & mask) != 0;
+            waitingWords[w] &= ~mask;
+
+            // A learned time replaces the class time, the class mode applies
+            FilterClass filter = activeFilters[classes[bit]];
+            if (times && times[bit]) {
+                filter.debounceMs = times[bit];
+            }
+            if (bounceStats && (toggled & mask)) {
+                learnBounce(wordInputBase[w] + bit, reading, filter.debounceMs, now);
+            }
+            if (debounce(reading, toggled & mask, pending & mask, deadlines[bit], filter, now)) {
+                stableWords[w] ^= mask;
+                reportChange(w, bit, reading, now);
+                changed = true;
+            } else if (pending & mask) {
+                // Not due yet: wake the word at the earliest bit deadline
+                waitingWords[w] |= mask;
+                if (!armed || (long)(deadlines[bit] - wake) < 0) {
+                    wake = deadlines[bit];
+                    armed = rearm = true;
+                }
+            }
+        }
+        if (rearm) {
+            timers.schedule(w, wake);
+        }
+    }
+    return changed;
+}
+
+/**
+ * Blocking wait for update completion
+ */
+void SimRacingController::waitForUpdate() {
+    while (!tryUpdate()) {
+        delay(1);
+    }
+}
+
+/*
+   Raw Input Frames
+*/
+
+/**
+ * @return Number of 32-bit words in a frame (0 before begin())
+ */
+uint8_t SimRacingController::getFrameSize() const {
+    return frameSize;
+}
+
+/**
+ * @return Raw samples of the last scan
+ */
+const uint32_t* SimRacingController::getFrame() const {
+    return frameWords;
+}
+
+/**
+ * Attaches a recorder that logs every scanned frame
+ * @param rec Recorder instance (nullptr to detach)
+ */
+void SimRacingController::setRecorder(InputRecorder* rec) {
+    recorder = rec;
+    if (recorder && frameWords) {
+        recorder->begin(frameSize);
+    }
+}
+
+/**
+ * Attaches a gesture engine fed with every debounced edge
+ * @param engine Gesture engine (nullptr to detach)
+ */
+void SimRacingController::setGestureEngine(GestureEngine* engine) {
+    gestures = engine;
+    if (gestures) {
+        gestures->reset();
+    }
+}
+
+/**
+ * Attaches a telemetry stream fed with every event, state snapshots and
+ * scan statistics (written from update() or processEvents())
+ * @param writer Telemetry writer (nullptr to detach)
+ */
+void SimRacingController::setTelemetry(TelemetryWriter* writer) {
+    telemetry = writer;
+    if (telemetry) {
+        telemetry->begin(millis());
+    }
+}
+
+/**
+ * Writes the periodic telemetry frames that are due
+ * @param now Current time (ms)
+ */
+void SimRacingController::sendTelemetry(unsigned long now) {
+    if (telemetry->isStateDue(now)) {
+        int32_t positions[TELEMETRY_MAX_ENCODERS];
+        uint16_t values[MAX_ANALOG_AXES];
+        uint8_t switches[MAX_LADDER_SWITCHES];
+        uint8_t count = numEncoders < TELEMETRY_MAX_ENCODERS ? numEncoders : TELEMETRY_MAX_ENCODERS;
+        for (uint8_t i = 0; i < count; i++) {
+            positions[i] = getEncoderPosition(i);
+        }
+        for (uint8_t i = 0; i < numAnalogAxes; i++) {
+            values[i] = getAnalogValue(i);
+        }
+        for (uint8_t i = 0; i < numLadders; i++) {
+            switches[i] = getSwitchPosition(i);
+        }
+        telemetry->writeState(now, positions, count, values, numAnalogAxes, switches, numLadders);
+    }
+
+    if (telemetry->isStatsDue(now)) {
+        telemetry->writeStats(now, getScanStats(), getDroppedEvents());
+    }
+}
+
+/**
+ * Prepares the controller to process recorded frames instead of hardware
+ * Debounced states are taken from the first frame without callbacks
+ * @param time Time of the first frame (ms)
+ * @param words First frame
+ * @return true if successful, false on configuration error
+ */
+bool SimRacingController::beginReplay(unsigned long time, const uint32_t* words) {
+    clearError();
+
+    if (!validateConfiguration()) {
+        return false;
+    }
+
+    initializeFrame();
+    for (uint8_t i = 0; i < frameSize; i++) {
+        frameWords[i] = words[i];
+        stableWords[i] = lastRawWords[i] = words[i] & validMasks[i];
+    }
+    resetDeadlines(time);
+    for (int i = 0; i < numEncoders; i++) {
+        EncoderConfig& enc = encoders[i];
+        enc.lastState = (words[frameEncoderBase + i / 16] >> ((i % 16) * 2)) & 3;
+        enc.steps = 0;
+        enc.stepReported = false;
+        enc.pending = false;
+        enc.errorRate = 0;
+        enc.errorTime = time;
+        enc.valid = true;
+    }
+
+    if (gestures) {
+        gestures->reset();
+    }
+
+    isPowerSaving = false;
+    lastActivityTime = time;
+    resetScanStats();
+    publishState();
+    return true;
+}
+
+/**
+ * Processes an externally supplied frame (replay)
+ * @param time Frame time (ms)
+ * @param words Frame words (getFrameSize() entries)
+ * @param kind Frame kind (InputReplayer::getFrameKind() for recorded frames)
+ * @return true if processed, false if busy or not prepared
+ */
+bool SimRacingController::processFrame(unsigned long time, const uint32_t* words, FrameKind kind) {
+    if (!frameWords || !scanLock.tryLock()) {
+        return false;
+    }
+
+    unsigned long startMicros = micros();
+    expireTimers(time);
+    processInputs(time, words, kind);
+    recordScanTime(startMicros);
+    scanLock.unlock();
+    return true;
+}
+
+/*
+   Live Configuration
+*/
+
+/**
+ * Holds off the scan while settings change
+ * Without the scan task the application already runs between scans;
+ * with it, waits for the running scan to end. Calls nest: the setters
+ * below lock themselves and may run inside a change of the sketch.
+ * Calls from the scan task (gesture and error callbacks) already run
+ * inside its scan and leave the nesting of the application alone.
+ */
+void SimRacingController::beginChange() {
+    if (inScanTask() || changeDepth++ > 0) return;
+
+    changeLocked = taskRunning;
+    while (changeLocked && !scanLock.tryLock()) {
+        delay(0);
+    }
+}
+
+/**
+ * Lets the scan run again after the outermost beginChange()
+ */
+void SimRacingController::endChange() {
+    if (inScanTask() || changeDepth == 0 || --changeDepth > 0) return;
+
+    if (changeLocked) {
+        changeLocked = false;
+        scanLock.unlock();
+    }
+}
+
+/*
+   Background Scan Task
+*/
+
+/**
+ * Starts scanning in a task of its own at a fixed period
+ * Input callbacks are queued and run by processEvents(); gesture and error
+ * callbacks still run in the task. Call after begin().
+ * @param periodMs Scan period (ms, at least 1)
+ * @param priority Task priority (FreeRTOS)
+ * @param core Core to pin the task to (-1 = any, FreeRTOS)
+ * @param queueSize Events held until processEvents()
+ * @return true if started, false if unsupported or invalid
+ */
+bool SimRacingController::startScanTask(uint8_t periodMs, uint8_t priority, int8_t core,
+                                        uint16_t queueSize) {
+#if defined(SCAN_TASK_FREERTOS) || defined(SCAN_TASK_THREAD)
+    if (taskRunning) return true;
+
+    if (!frameWords || periodMs == 0) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid scan task setup");
+        return false;
+    }
+    if (!events) {
+        events = new EventQueue();
+    }
+    if (!events->begin(queueSize)) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid event queue size");
+        return false;
+    }
+
+    taskPeriodMs = periodMs;
+    taskPriority = priority;
+    taskRunning = true;
+
+#if defined(SCAN_TASK_FREERTOS)
+    TaskHandle_t handle = nullptr;
+    BaseType_t created = xTaskCreatePinnedToCore(scanTaskEntry, "SimRacingScan", 4096, this,
+                                                 priority, &handle,
+                                                 core < 0 ? tskNO_AFFINITY : core);
+    if (created != pdPASS) {
+        taskRunning = false;
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Scan task not created");
+        return false;
+    }
+    taskHandle = handle;
+#else
+    (void)core;
+    taskThread = new std::thread(scanTaskEntry, this);
+#endif
+    return true;
+#else
+    (void)periodMs; (void)priority; (void)core; (void)queueSize;
+    lastError = ControllerError(ControllerError::INVALID_CONFIG, "Scan task not supported");
+    return false;
+#endif
+}
+
+/**
+ * Stops the scan task and waits until it has ended
+ * Events still queued can be read afterwards.
+ */
+void SimRacingController::stopScanTask() {
+    if (!taskRunning) return;
+    taskRunning = false;
+
+#if defined(SCAN_TASK_FREERTOS)
+    while (taskHandle) {
+        delay(1);
+    }
+#elif defined(SCAN_TASK_THREAD)
+    taskThread->join();
+    delete taskThread;
+    taskThread = nullptr;
+    taskThreadId = std::thread::id();
+#endif
+}
+
+/**
+ * @return true while the scan task runs
+ */
+bool SimRacingController::isScanTaskRunning() const {
+    return taskRunning;
+}
+
+/**
+ * Changes the priority of the scan task
+ * @param priority Task priority (FreeRTOS)
+ * @return false if the task does not run
+ */
+bool SimRacingController::setScanTaskPriority(uint8_t priority) {
+    if (!taskRunning) return false;
+
+    taskPriority = priority;
+#if defined(SCAN_TASK_FREERTOS)
+    vTaskPrioritySet(taskHandle, priority);
+#endif
+    return true;
+}
+
+/**
+ * Runs the callbacks of queued events in the calling context
+ * Only the events queued before the call are processed.
+ * @return Number of events processed
+ */
+uint16_t SimRacingController::processEvents() {
+    if (!events) return 0;
+
+    uint16_t queued = events->size();
+    uint16_t count = 0;
+    ControllerEvent event;
+    while (count < queued && events->pop(event)) {
+        dispatchEvent(event);
+        count++;
+    }
+
+    if (telemetry) {
+        sendTelemetry(millis());
+    }
+    return count;
+}
+
+/**
+ * Takes the oldest queued event without running its callback
+ * @param event Receives the event
+ * @return false if no event is queued
+ */
+bool SimRacingController::readEvent(ControllerEvent& event) {
+    return events && events->pop(event);
+}
+
+/**
+ * @return Events lost because the queue was full
+ */
+uint32_t SimRacingController::getDroppedEvents() const {
+    return events ? events->getDropped() : 0;
+}
+
+/**
+ * Task entry point
+ * @param controller Controller to scan
+ */
+void SimRacingController::scanTaskEntry(void* controller) {
+    static_cast<SimRacingController*>(controller)->runScanTask();
+#if defined(SCAN_TASK_FREERTOS)
+    vTaskDelete(nullptr);
+#endif
+}
+
+/**
+ * Scan loop of the task, one scan per period until stopScanTask()
+ */
+void SimRacingController::runScanTask() {
+#if defined(SCAN_TASK_FREERTOS)
+    taskHandle = xTaskGetCurrentTaskHandle();   // Before the first callback
+    TickType_t period = pdMS_TO_TICKS(taskPeriodMs);
+    TickType_t wake = xTaskGetTickCount();
+    while (taskRunning) {
+        tryUpdate();
+        vTaskDelayUntil(&wake, period > 0 ? period : 1);
+    }
+    taskHandle = nullptr;
+#elif defined(SCAN_TASK_THREAD)
+    taskThreadId = std::this_thread::get_id();  // Before the first callback
+    std::chrono::steady_clock::time_point wake = std::chrono::steady_clock::now();
+    while (taskRunning) {
+        tryUpdate();
+        wake += std::chrono::milliseconds(taskPeriodMs);
+        std::this_thread::sleep_until(wake);
+    }
+#endif
+}
+
+/**
+ * @return true if called from the scan task
+ */
+bool SimRacingController::inScanTask() const {
+#if defined(SCAN_TASK_FREERTOS)
+    return xTaskGetCurrentTaskHandle() == taskHandle;
+#elif defined(SCAN_TASK_THREAD)
+    return std::this_thread::get_id() == taskThreadId;
+#else
+    return false;
+#endif
+}
+
+/*
+   Scan Statistics
+*/
+
+/**
+ * Accounts a scan or a slice of an incremental scan
+ * @param startMicros micros() at scan start
+ * @param completed false for a slice that did not finish a scan
+ */
+void SimRacingController::recordScanTime(unsigned long startMicros, bool completed) {
+    uint32_t elapsed = micros() - startMicros;
+    if (completed) {
+        scanStats.scans++;
+    }
+    if (scanBudgetUs) {
+        scanStats.slices++;
+    }
+    scanStats.totalMicros += elapsed;
+    if (elapsed > scanStats.maxMicros) {
+        scanStats.maxMicros = elapsed;
+    }
+}
+
+/**
+ * @return Statistics since begin() or the last reset
+ */
+ScanStats SimRacingController::getScanStats() const {
+    return scanStats;
+}
+
+/**
+ * Clears scan statistics
+ */
+void SimRacingController::resetScanStats() {
+    scanStats = ScanStats();
+}
+
+/*
+   Incremental Scan
+*/
+
+/**
+ * Spreads each scan over several update() calls
+ * Every call samples and decodes the encoders, then reads frame words
+ * (matrix rows, GPIO words, MCP devices) until budgetUs has passed, at
+ * least one per call. The next scan restarts from the first word.
+ * @param budgetUs Time per call (us), 0 = whole scan per call (default)
+ */
+void SimRacingController::setScanBudget(uint16_t budgetUs) {
+    beginChange();
+    scanBudgetUs = budgetUs;
+    nextScanWord = 0;
+    endChange();
+}
+
+/**
+ * @return Time per update() call (us), 0 = whole scans
+ */
+uint16_t SimRacingController::getScanBudget() const {
+    return scanBudgetUs;
+}
+
+/**
+ * Sets how often a source is sampled
+ * Encoders typically need several kHz not to miss quadrature states,
+ * matrix buttons are fine at 1 kHz and toggle switches on MCP23017s at
+ * 200 Hz, which also takes most of the traffic off the I2C bus. A source
+ * is read by the first update() after its period; call update() at least
+ * as often as the fastest rate.
+ * @param source SOURCE_MATRIX, SOURCE_GPIO, SOURCE_MCP or SOURCE_ENCODER
+ *        (encoder buttons are read with the encoders)
+ * @param hz Samples per second, 0 = every update() (default)
+ * @return true if valid source, false otherwise
+ */
+bool SimRacingController::setSampleRate(InputSource source, uint16_t hz) {
+    if (source != SOURCE_MATRIX && source != SOURCE_GPIO && source != SOURCE_MCP &&
+        source != SOURCE_ENCODER) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid sample rate source");
+        return false;
+    }
+    beginChange();
+    samplePeriodUs[source] = hz ? 1000000UL / hz : 0;
+    endChange();
+    return true;
+}
+
+/**
+ * @param source SOURCE_MATRIX, SOURCE_GPIO, SOURCE_MCP or SOURCE_ENCODER
+ * @return Samples per second, 0 = every update()
+ */
+uint16_t SimRacingController::getSampleRate(InputSource source) const {
+    if (source != SOURCE_MATRIX && source != SOURCE_GPIO && source != SOURCE_MCP &&
+        source != SOURCE_ENCODER) {
+        return 0;
+    }
+    uint32_t period = samplePeriodUs[source];
+    return period ? (1000000UL + period / 2) / period : 0;
+}
+
+/*
+   Adaptive Scan Rate
+*/
+
+/**
+ * Sets the idle scan rate tiers
+ * After tiers[i].idleMs without an input edge the inputs are scanned at
+ * tiers[i].hz. The first raw edge (button, encoder A/B) returns to full
+ * rate at once, and a held input keeps it, so latency while driving is
+ * unchanged; only the first edge after an idle period waits for the
+ * next slow scan. Timers, gestures and power save run at every update().
+ * @param tiers Tiers by increasing idleMs (copied)
+ * @param count Number of tiers (0 = always full rate, at most MAX_SCAN_RATE_TIERS)
+ * @return true if valid tiers, false otherwise
+ */
+bool SimRacingController::setScanRateTiers(const ScanRateTier* tiers, uint8_t count) {
+    if (count > MAX_SCAN_RATE_TIERS || (count > 0 && !tiers)) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid scan rate tiers");
+        return false;
     }
-    for (int i = 0; i < numCols; i++) {
-        pinMode(colPins[i], INPUT_PULLUP);
+    for (uint8_t i = 0; i < count; i++) {
+        if (tiers[i].hz == 0 || (i > 0 && tiers[i].idleMs <= tiers[i - 1].idleMs)) {
+            lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid scan rate tiers");
+            return false;
+        }
     }
 
-    // Configure GPIO pins
-    for (int i = 0; i < numGpio; i++) {
-        pinMode(gpioPins[i], INPUT_PULLUP);
+    beginChange();
+    for (uint8_t i = 0; i < count; i++) {
+        rateTiers[i] = tiers[i];
     }
+    numRateTiers = count;
+    rateTier = 0;
+    endChange();
+    return true;
+}
 
-    // Configure encoder pins
-    for (int i = 0; i < numEncoders; i++) {
-        pinMode(encoders[i].pinA, INPUT_PULLUP);
-        pinMode(encoders[i].pinB, INPUT_PULLUP);
-        if (encoders[i].pinBtn >= 0) {
-            pinMode(encoders[i].pinBtn, INPUT_PULLUP);
-        }
-        encoders[i].lastState = (digitalRead(encoders[i].pinA) << 1) | digitalRead(encoders[i].pinB);
-        encoders[i].errorReported = false;
+/**
+ * @return Current tier, 0 = full rate, n = tiers[n - 1] of setScanRateTiers()
+ */
+uint8_t SimRacingController::getScanRateTier() const {
+    return rateTier;
+}
+
+/**
+ * Selects the scan rate tier for the idle time and accounts tier time
+ * @param now Current time (ms)
+ * @param nowMicros Current time (us)
+ * @return true if the inputs are scanned by this call
+ */
+bool SimRacingController::governScanRate(unsigned long now, unsigned long nowMicros) {
+    scanStats.tierMillis[rateTier] += now - tierTime;
+    tierTime = now;
+
+    uint8_t tier = 0;
+    unsigned long idle = now - lastEdgeTime;
+    while (tier < numRateTiers && idle >= rateTiers[tier].idleMs) {
+        tier++;
     }
+    rateTier = tier;
 
-    lastActivityTime = millis();
+    if (tier > 0 && nowMicros - lastScanMicros < 1000000UL / rateTiers[tier - 1].hz) {
+        return false;
+    }
+    lastScanMicros = nowMicros;
     return true;
 }
 
+/**
+ * @return true if a matrix, GPIO, MCP or encoder button is pressed
+ */
+bool SimRacingController::isInputHeld() const {
+    for (uint8_t w = 0; w < frameEncoderBase; w++) {
+        if (stableWords[w]) return true;
+    }
+    for (uint8_t w = frameButtonBase; w < frameSize; w++) {
+        if (stableWords[w]) return true;
+    }
+    return false;
+}
+
 /*
-   Update Methods
+   Power Management
 */
 
 /**
- * Standard update method (blocking)
+ * Sets power save timeout
+ * @param timeoutMs Timeout in milliseconds
+ * @return true if valid timeout, false otherwise
  */
-void SimRacingController::update() {
-    if (!tryUpdate()) {
-        waitForUpdate();
+bool SimRacingController::setPowerSaveTimeout(unsigned long timeoutMs) {
+    if (timeoutMs < MIN_POWER_SAVE_MS || timeoutMs > MAX_POWER_SAVE_MS) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid power save timeout");
+        return false;
     }
+    const_cast<unsigned long&>(powerSaveTimeout) = timeoutMs;
+    powerSaveEnabled = true;  // Enable power save when timeout is set
+    armPowerSave();
+    return true;
 }
 
 /**
- * Non-blocking update attempt
- * @return true if update successful, false if busy
+ * Enables power save mode
  */
-bool SimRacingController::tryUpdate() {
-    if (isUpdating) {
-        return false;
+bool SimRacingController::enablePowerSave() {
+    powerSaveEnabled = true;
+    lastActivityTime = millis();
+    armPowerSave();
+    return true;
+}
+
+/**
+ * Disables power save mode
+ */
+bool SimRacingController::disablePowerSave() {
+    powerSaveEnabled = false;
+    if (isPowerSaving) {
+        wake();
     }
+    armPowerSave();
+    return true;
+}
+
+/**
+ * Enters power save mode
+ */
+void SimRacingController::sleep() {
+    if (!powerSaveEnabled) return;
     
-    isUpdating = true;
+    isPowerSaving = true;
+    armPowerSave();
     
-    // Check for power save mode
-    if (powerSaveEnabled && !isPowerSaving && 
-        millis() - lastActivityTime > powerSaveTimeout) {
-        sleep();
+    // Set all output pins to INPUT to save power
+    for (int i = 0; i < numRows; i++) {
+        pinMode(rowPins[i], INPUT);
     }
+}
+
+/**
+ * Exits power save mode
+ */
+void SimRacingController::wake() {
+    isPowerSaving = false;
+    lastActivityTime = millis();
+    lastEdgeTime = lastActivityTime;
+    tierTime = lastActivityTime;
+    armPowerSave();
     
-    if (!isPowerSaving) {
-        bool activityDetected = false;
+    // Restore pin modes
+    for (int i = 0; i < numRows; i++) {
+        pinMode(rowPins[i], OUTPUT);
+        digitalWrite(rowPins[i], HIGH);
+    }
+}
 
-        // Update MCP devices
-        if (mcpInitialized) {
-            for (uint8_t i = 0; i < numMcpDevices; i++) {
-                updateMcp(i);
-            }
-        }
+/**
+ * Checks if power save is enabled
+ * @return true if enabled, false otherwise
+ */
+bool SimRacingController::isPowerSaveEnabled() const {
+    return powerSaveEnabled;
+}
 
-        // Update matrix
-        for (int row = 0; row < numRows; row++) {
-            digitalWrite(rowPins[row], LOW);
-            delayMicroseconds(10);
+/**
+ * Clears current error state
+ */
+void SimRacingController::clearError() {
+    lastError = ControllerError();
+    errorReported = false;
+}
 
-            for (int col = 0; col < numCols; col++) {
-                bool currentReading = (digitalRead(colPins[col]) == LOW);
+/*
+   Input Updates
+*/
 
-                if (currentReading != lastMatrixStates[row][col]) {
-                    lastMatrixDebounceTime[row][col] = millis();
-                }
+/**
+ * Reports a debounced change to the callback of its source
+ * @param word Frame word
+ * @param bit Bit in the word
+ * @param state New state
+ * @param now Sample time (ms)
+ */
+void SimRacingController::reportChange(uint8_t word, uint8_t bit, bool state, unsigned long now) {
+    InputSource source;
+    uint16_t index;
+
+    if (word < frameGpioBase) {
+        source = SOURCE_MATRIX;
+        index = word * numCols + bit;
+    } else if (word < frameMcpBase) {
+        source = SOURCE_GPIO;
+        index = (word - frameGpioBase) * 32 + bit;
+    } else if (word < frameEncoderBase) {
+        source = SOURCE_MCP;
+        index = (word - frameMcpBase) * 16 + bit;
+    } else {
+        source = SOURCE_ENCODER_BUTTON;
+        index = (word - frameButtonBase) * 32 + bit;
+    }
 
-                if ((millis() - lastMatrixDebounceTime[row][col]) > matrixDebounceDelay) {
-                    if (currentReading != matrixStates[row][col]) {
-                        matrixStates[row][col] = currentReading;
-                        processMatrixPress(row, col, currentReading);
-                        activityDetected = true;
-                    }
-                }
+    reportEvent(source, index, state, now);
 
-                lastMatrixStates[row][col] = currentReading;
-            }
+    if (gestures) {
+        gestures->processEdge(source, index, state, now, currentProfile);
+        gestureSync = true;
+    }
+}
+
+/**
+ * Reports a change: queued while the scan task runs, otherwise its
+ * callback runs at once
+ * @param source Input source
+ * @param index Input index
+ * @param value New state or analog value
+ * @param now Sample time (ms)
+ */
+void SimRacingController::reportEvent(InputSource source, uint16_t index, int16_t value,
+                                      unsigned long now) {
+    scanStats.events++;
+    if (queueEvent(source, index, value, now)) {
+        stateDirty = true;  // Published at the end of the scan
+        return;
+    }
+
+    ControllerEvent event;
+    event.source = source;
+    event.profile = currentProfile;
+    event.index = index;
+    event.value = value;
+    event.time = now;
+    publishState();         // Getters see the change inside the callback
+    dispatchEvent(event);
+}
+
+/**
+ * Takes one reading of every analog axis and ladder switch
+ * @param now Sample time (ms)
+ */
+void SimRacingController::sampleAnalog(unsigned long now) {
+    bool activityDetected = false;
+
+    for (uint8_t i = 0; i < numAnalogAxes; i++) {
+        AnalogAxis& axis = analogAxes[i];
+        if (axis.addSample(analogRead(axis.getConfig().pin))) {
+            reportEvent(SOURCE_ANALOG, i, axis.getValue(), now);
+            activityDetected = true;
+        }
+    }
 
-            digitalWrite(rowPins[row], HIGH);
+    for (uint8_t i = 0; i < numLadders; i++) {
+        LadderSwitch& ladder = ladders[i];
+        if (ladder.addSample(analogRead(ladder.getConfig().pin), now)) {
+            reportEvent(SOURCE_SWITCH, i, ladder.getPosition(), now);
+            activityDetected = true;
         }
+    }
 
-        // Update GPIO
-        for (int i = 0; i < numGpio; i++) {
-            bool currentReading = (digitalRead(gpioPins[i]) == LOW);
+    if (activityDetected) {
+        lastActivityTime = now;
+        armPowerSave();
+    }
 
-            if (currentReading != lastGpioStates[i]) {
-                gpioDebounceTime[i] = millis();
-            }
+    if (stateDirty) {
+        publishState();
+    }
+}
 
-            if ((millis() - gpioDebounceTime[i]) > matrixDebounceDelay) {
-                if (currentReading != gpioStates[i]) {
-                    gpioStates[i] = currentReading;
-                    if (onGpioChange) {
-                        onGpioChange(currentProfile, i, currentReading);
-                    }
-                    activityDetected = true;
-                }
+/**
+ * Queues a change for processEvents() while the scan task runs
+ * @param source Input source (SOURCE_ENCODER = rotation)
+ * @param index Input index
+ * @param value New state, rotation direction or analog value
+ * @param time Scan time (ms)
+ * @return false if the callback has to run now
+ */
+bool SimRacingController::queueEvent(InputSource source, uint16_t index, int16_t value,
+                                     unsigned long time) {
+    if (!events || !taskRunning) return false;
+
+    ControllerEvent event;
+    event.source = source;
+    event.profile = currentProfile;
+    event.index = index;
+    event.value = value;
+    event.time = time;
+    events->push(event);    // Counted as dropped if full
+    return true;
+}
+
+/**
+ * Runs the callback of a change
+ * @param event Reported change
+ */
+void SimRacingController::dispatchEvent(const ControllerEvent& event) {
+    bool state = event.value > 0;
+
+    if (telemetry) {
+        telemetry->writeEvent(event);
+    }
+
+    switch (event.source) {
+        case SOURCE_MATRIX:
+            if (onMatrixChange) {
+                onMatrixChange(event.profile, event.index / numCols, event.index % numCols, state);
+            }
+            break;
+        case SOURCE_GPIO:
+            if (onGpioChange) {
+                onGpioChange(event.profile, event.index, state);
+            }
+            break;
+        case SOURCE_MCP:
+            if (onMcpChange) {
+                onMcpChange(event.profile, event.index / 16, event.index % 16, state);
+            }
+            break;
+        case SOURCE_ENCODER_BUTTON:
+            if (onEncoderButtonChange) {
+                onEncoderButtonChange(event.profile, event.index, state);
+            }
+            break;
+        case SOURCE_ENCODER:
+            if (onEncoderChange) {
+                onEncoderChange(event.profile, event.index, event.value);
+            }
+            break;
+        case SOURCE_ANALOG:
+            if (onAnalogChange) {
+                onAnalogChange(event.profile, event.index, event.value);
+            }
+            break;
+        case SOURCE_SWITCH:
+            if (onSwitchChange) {
+                onSwitchChange(event.profile, event.index, event.value);
             }
+            break;
+    }
+}
 
-            lastGpioStates[i] = currentReading;
+/**
+ * Quarter step per A/B transition ((previous << 2) | current), 1 = CW
+ * Single-pin transitions only; a bouncing pin steps back and forth.
+ */
+static const int8_t ENCODER_QUARTER_STEPS[16] = {
+     0,  1, -1,  0,
+    -1,  0,  0,  1,
+     1,  0,  0, -1,
+     0, -1,  1,  0
+};
+
+/**
+ * Updates encoder state
+ * Single-pin transitions are decoded at once. The first quarter step out
+ * of a detent is reported once it has held for the glitch time, or at once
+ * when the next quarter step follows; contact bounce and short pulses on
+ * one pin step back first and cancel it. A jump of both pins in one sample
+ * is an EMI pulse or a step missed at speed: it is followed once the
+ * encoder moves on from it, or once it has held for the glitch time, and
+ * counts as an error. A pulse that returns to the previous levels first is
+ * dropped.
+ * @param index Encoder index
+ * @param currentTime Sample time (ms)
+ * @param currentState Sampled A/B levels ((A << 1) | B)
+ * @param glitchTime Time a first quarter step or a jump of both pins must hold (ms)
+ */
+void SimRacingController::updateEncoder(int index, unsigned long currentTime,
+                                        uint8_t currentState, unsigned long glitchTime) {
+    if (index < 0 || index >= numEncoders) return;
+
+    EncoderConfig& enc = encoders[index];
+
+    // Moved on from a held jump: a missed step, in the direction of the next one
+    if (enc.pending && currentState != enc.pendingState && currentState != enc.lastState) {
+        int8_t next = ENCODER_QUARTER_STEPS[(enc.pendingState << 2) | currentState];
+        countEncoderError(enc, currentTime);
+        stepEncoder(index, 2 * next, enc.pendingState, enc.pendingTime);
+    }
+
+    uint8_t change = currentState ^ enc.lastState;
+    if (change == 0) {
+        enc.pending = false;    // Back to the previous levels: glitch dropped
+    } else if (change != 3) {
+        enc.pending = false;
+        stepEncoder(index, ENCODER_QUARTER_STEPS[(enc.lastState << 2) | currentState],
+                    currentState, currentTime);
+    } else {
+        if (!enc.pending) {
+            enc.pending = true;
+            enc.pendingState = currentState;
+            enc.pendingTime = currentTime;
+        }
+        if (currentTime - enc.pendingTime >= glitchTime) {
+            // Held: continue in the current direction, if any
+            int8_t direction = enc.steps ? (enc.steps > 0 ? 1 : -1) : enc.lastDirection;
+            countEncoderError(enc, currentTime);
+            stepEncoder(index, 2 * direction, currentState, currentTime);
         }
+    }
 
-        // Update encoders
-        for (int i = 0; i < numEncoders; i++) {
-            updateEncoder(i);
+    // First quarter step out of the detent held long enough: a real step
+    if (enc.holdsStep() && currentTime - enc.lastChangeTime >= glitchTime) {
+        reportStep(index, currentTime);
+    }
+}
+
+/**
+ * Applies decoded quarter steps
+ * One step is reported per detent: halfway to the next one at the latest,
+ * earlier once the first quarter step has held (see updateEncoder()).
+ * @param index Encoder index
+ * @param quarterSteps Quarter steps (CW positive)
+ * @param state New A/B levels
+ * @param now Transition time (ms)
+ */
+void SimRacingController::stepEncoder(int index, int8_t quarterSteps, uint8_t state,
+                                      unsigned long now) {
+    EncoderConfig& enc = encoders[index];
+    enc.pending = false;
+    stateDirty = true;
+
+    // Calculate rotation speed
+    if (enc.lastChangeTime > 0) {
+        unsigned long timeDiff = now - enc.lastChangeTime;
+        if (timeDiff > 0) {
+            enc.speed = 1000 / timeDiff;
+        }
+    }
+    enc.lastChangeTime = now;
+
+    enc.steps += quarterSteps;
+    if (!enc.stepReported && (enc.steps >= 2 || enc.steps <= -2)) {
+        reportStep(index, now);
+    }
+
+    enc.lastState = state;
+    if (state == 3) {
+        enc.steps = 0;          // Detent
+        enc.stepReported = false;
+    }
+
+    // Reset speed if no changes for a second
+    timers.schedule(frameSize + index, now + 1001);
+}
+
+/**
+ * Reports the step of the current detent in the direction of its quarter steps
+ * @param index Encoder index
+ * @param now Report time (ms)
+ */
+void SimRacingController::reportStep(int index, unsigned long now) {
+    EncoderConfig& enc = encoders[index];
+    int8_t direction = enc.steps > 0 ? 1 : -1;
+    enc.position += (direction * 4) / enc.divisor;
+    enc.lastDirection = direction;
+    enc.stepReported = true;
+    stateDirty = true;
+    reportEvent(SOURCE_ENCODER, index, direction, now);
+}
+
+/**
+ * Counts an invalid transition in the error rate
+ * An encoder whose error rate reaches ENCODER_ERROR_LIMIT is marked invalid
+ * until the rate has decayed to half of it.
+ * @param enc Encoder
+ * @param now Error time (ms)
+ */
+void SimRacingController::countEncoderError(EncoderConfig& enc, unsigned long now) {
+    decayEncoderErrors(enc, now);
+    enc.errorCount++;
+    if (enc.errorRate <= 0xFFFF - 16) {
+        enc.errorRate += 16;
+    }
+
+    if (enc.valid && enc.errorRate >= ENCODER_ERROR_LIMIT * 16) {
+        enc.valid = false;
+        lastError = ControllerError(ControllerError::ENCODER_MALFUNCTION,
+            "Excessive encoder errors detected");
+        if (errorCallback && !enc.errorReported) {
+            errorCallback(lastError);
+            enc.errorReported = true;
         }
+    }
+}
+
+/**
+ * Halves the error rate once per elapsed ENCODER_ERROR_WINDOW_MS
+ * @param enc Encoder
+ * @param now Current time (ms)
+ */
+void SimRacingController::decayEncoderErrors(EncoderConfig& enc, unsigned long now) {
+    unsigned long windows = (now - enc.errorTime) / ENCODER_ERROR_WINDOW_MS;
+    if (windows == 0) return;
+
+    enc.errorTime += windows * ENCODER_ERROR_WINDOW_MS;
+    enc.errorRate = windows < 16 ? enc.errorRate >> windows : 0;
 
-        if (activityDetected) {
-            lastActivityTime = millis();
+    if (!enc.valid && enc.errorRate < ENCODER_ERROR_LIMIT * 8) {
+        enc.valid = true;       // Recovered
+        enc.errorReported = false;
+        stateDirty = true;
+    }
+}
+
+/**
+ * Debounces one input
+ * Deferred: deadline is set by each raw change, the state follows the
+ * reading once it has been stable for the debounce time.
+ * Eager: deadline is set by each reported change, a new reading is
+ * reported at once unless it falls inside the lockout window.
+ * @param reading Current raw reading
+ * @param toggled Reading differs from the previous scan
+ * @param pending Reading differs from the debounced state
+ * @param deadline Time from which the input may change state
+ * @param filter Filter class of the input
+ * @param now Sample time (ms)
+ * @return true if the debounced state changes to reading
+ */
+bool SimRacingController::debounce(bool reading, bool toggled, bool pending,
+                                   unsigned long& deadline, const FilterClass& filter,
+                                   unsigned long now) const {
+    bool eager = (filter.mode == DEBOUNCE_EAGER) ||
+                 (filter.mode == DEBOUNCE_EAGER_PRESS && reading);
+
+    if (eager) {
+        if (!pending || (long)(now - deadline) < 0) {
+            return false;
         }
+        deadline = now + filter.debounceMs + 1;     // Lockout window
+        return true;
+    }
+
+    if (toggled) {
+        deadline = now + filter.debounceMs + 1;
+    }
+    return pending && (long)(now - deadline) >= 0;
+}
+
+/*
+   Configuration Methods
+*/
+
+/**
+ * Sets number of available profiles
+ * @param numProfiles Number of profiles
+ */
+void SimRacingController::setProfiles(int numProfiles) {
+    const_cast<int&>(this->numProfiles) = numProfiles;
+
+    // Per-profile filter tables must be set again
+    delete[] profileFilters;
+    profileFilters = nullptr;
+    delete[] blobFilterTables;
+    blobFilterTables = nullptr;
+    selectFilterTable();
+}
+
+/**
+ * Sets debounce times of the default filter classes
+ * @param matrixDebounce Debounce time for matrix/GPIO/MCP/encoder buttons (ms)
+ * @param encoderDebounce Debounce time for encoders (ms)
+ */
+void SimRacingController::setDebounceTime(unsigned long matrixDebounce,
+    unsigned long encoderDebounce) {
+    beginChange();
+    defaultFilters[SOURCE_MATRIX].debounceMs = matrixDebounce;
+    defaultFilters[SOURCE_GPIO].debounceMs = matrixDebounce;
+    defaultFilters[SOURCE_MCP].debounceMs = matrixDebounce;
+    defaultFilters[SOURCE_ENCODER_BUTTON].debounceMs = matrixDebounce;
+    defaultFilters[SOURCE_ENCODER].debounceMs = encoderDebounce;
+    endChange();
+}
+
+/**
+ * Sets the debounce mode of the default filter class of a source
+ * @param source Input source
+ * @param mode DEBOUNCE_DEFERRED, DEBOUNCE_EAGER or DEBOUNCE_EAGER_PRESS
+ */
+void SimRacingController::setDebounceMode(InputSource source, DebounceMode mode) {
+    if (source >= 0 && source < NUM_INPUT_SOURCES) {
+        beginChange();
+        defaultFilters[source].mode = mode;
+        endChange();
     }
-    
-    isUpdating = false;
-    return true;
 }
 
 /**
- * Blocking wait for update completion
+ * Gets the debounce mode of the default filter class of a source
+ * @param source Input source
+ * @return Debounce mode
  */
-void SimRacingController::waitForUpdate() {
-    while (!tryUpdate()) {
-        delay(1);
+DebounceMode SimRacingController::getDebounceMode(InputSource source) const {
+    if (source >= 0 && source < NUM_INPUT_SOURCES) {
+        return defaultFilters[source].mode;
     }
+    return DEBOUNCE_DEFERRED;
 }
 
 /*
-   Power Management
+   Debounce Filter Classes
 */
 
 /**
- * Sets power save timeout
- * @param timeoutMs Timeout in milliseconds
- * @return true if valid timeout, false otherwise
+ * Sets a class of the default filter table
+ * @param filterClass Class number (0 to MAX_FILTER_CLASSES-1)
+ * @param debounceMs Debounce time or eager lockout (ms), step interval for encoders
+ * @param mode Debounce mode
+ * @return true if successful, false on invalid class
  */
-bool SimRacingController::setPowerSaveTimeout(unsigned long timeoutMs) {
-    if (timeoutMs < MIN_POWER_SAVE_MS || timeoutMs > MAX_POWER_SAVE_MS) {
-        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid power save timeout");
+bool SimRacingController::setFilterClass(uint8_t filterClass, unsigned long debounceMs,
+                                         DebounceMode mode) {
+    if (filterClass >= MAX_FILTER_CLASSES) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid filter class");
         return false;
     }
-    const_cast<unsigned long&>(powerSaveTimeout) = timeoutMs;
-    powerSaveEnabled = true;  // Enable power save when timeout is set
+    beginChange();
+    defaultFilters[filterClass] = FilterClass(debounceMs, mode);
+    endChange();
     return true;
 }
 
 /**
- * Enables power save mode
+ * Gets a class of the table used by the current profile
+ * @param filterClass Class number
+ * @return Filter class (default class if invalid)
  */
-bool SimRacingController::enablePowerSave() {
-    powerSaveEnabled = true;
-    lastActivityTime = millis();
-    return true;
+FilterClass SimRacingController::getFilterClass(uint8_t filterClass) const {
+    if (filterClass >= MAX_FILTER_CLASSES) {
+        return FilterClass();
+    }
+    return activeFilters[filterClass];
 }
 
 /**
- * Disables power save mode
+ * Sets the filter table of a profile (call after setProfiles)
+ * @param profile Profile number
+ * @param table MAX_FILTER_CLASSES classes owned by the sketch (nullptr = default table)
+ * @return true if successful, false on invalid profile
  */
-bool SimRacingController::disablePowerSave() {
-    powerSaveEnabled = false;
-    if (isPowerSaving) {
-        wake();
+bool SimRacingController::setFilterTable(int profile, const FilterClass* table) {
+    if (profile < 0 || profile >= numProfiles) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid profile");
+        return false;
+    }
+    beginChange();
+    if (!profileFilters) {
+        profileFilters = new const FilterClass*[numProfiles]();
     }
+    profileFilters[profile] = table;
+    selectFilterTable();
+    endChange();
     return true;
 }
 
 /**
- * Enters power save mode
+ * Changes one class of a profile table
+ * The first change copies the table in use by the profile (sketch table
+ * or default table) into storage owned by the controller.
+ * @param profile Profile number (-1 = default table, see setFilterClass())
+ * @param filterClass Class number
+ * @param debounceMs Debounce time or eager lockout (ms), step interval for encoders
+ * @param mode Debounce mode
+ * @return true if successful, false on invalid profile or class
  */
-void SimRacingController::sleep() {
-    if (!powerSaveEnabled) return;
-    
-    isPowerSaving = true;
-    
-    // Set all output pins to INPUT to save power
-    for (int i = 0; i < numRows; i++) {
-        pinMode(rowPins[i], INPUT);
+bool SimRacingController::setProfileFilterClass(int profile, uint8_t filterClass,
+                                                unsigned long debounceMs, DebounceMode mode) {
+    if (profile == -1) {
+        return setFilterClass(filterClass, debounceMs, mode);
+    }
+    if (profile < 0 || profile >= numProfiles || filterClass >= MAX_FILTER_CLASSES) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid filter class");
+        return false;
+    }
+
+    beginChange();
+    if (!blobFilterTables) {
+        blobFilterTables = new FilterClass[numProfiles * MAX_FILTER_CLASSES];
+    }
+    FilterClass* table = blobFilterTables + profile * MAX_FILTER_CLASSES;
+    const FilterClass* current = profileFilters ? profileFilters[profile] : nullptr;
+    if (current != table) {
+        for (uint8_t i = 0; i < MAX_FILTER_CLASSES; i++) {
+            table[i] = current ? current[i] : defaultFilters[i];
+        }
+        setFilterTable(profile, table);
     }
+    table[filterClass] = FilterClass(debounceMs, mode);
+    endChange();
+    return true;
 }
 
 /**
- * Exits power save mode
+ * Gets a class of the table used by a profile
+ * @param profile Profile number (-1 = default table)
+ * @param filterClass Class number
+ * @return Filter class (default class if invalid)
  */
-void SimRacingController::wake() {
-    isPowerSaving = false;
-    lastActivityTime = millis();
-    
-    // Restore pin modes
-    for (int i = 0; i < numRows; i++) {
-        pinMode(rowPins[i], OUTPUT);
-        digitalWrite(rowPins[i], HIGH);
+FilterClass SimRacingController::getProfileFilterClass(int profile, uint8_t filterClass) const {
+    if (profile < -1 || profile >= numProfiles || filterClass >= MAX_FILTER_CLASSES) {
+        return FilterClass();
+    }
+    if (profile >= 0 && profileFilters && profileFilters[profile]) {
+        return profileFilters[profile][filterClass];
     }
+    return defaultFilters[filterClass];
 }
 
 /**
- * Checks if power save is enabled
- * @return true if enabled, false otherwise
+ * Assigns one input to a filter class (call after the input configuration)
+ * @param source Input source
+ * @param index Input index (matrix: row * numCols + col, MCP: device * 16 + pin)
+ * @param filterClass Class number
+ * @return true if successful, false on invalid input or class
  */
-bool SimRacingController::isPowerSaveEnabled() const {
-    return powerSaveEnabled;
+bool SimRacingController::setInputFilter(InputSource source, int index, uint8_t filterClass) {
+    if (source < 0 || source >= NUM_INPUT_SOURCES || index < 0 ||
+        index >= filterInputCount(source) || filterClass >= MAX_FILTER_CLASSES) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid input filter");
+        return false;
+    }
+    beginChange();
+    initializeFilters();
+    inputFilters[filterIndex(source) + index] = filterClass;
+    endChange();
+    return true;
 }
 
 /**
- * Clears current error state
+ * Assigns all inputs of a source to a filter class
+ * @param source Input source
+ * @param filterClass Class number
+ * @return true if successful, false on invalid source or class
  */
-void SimRacingController::clearError() {
-    lastError = ControllerError();
-    errorReported = false;
+bool SimRacingController::setSourceFilter(InputSource source, uint8_t filterClass) {
+    if (source < 0 || source >= NUM_INPUT_SOURCES || filterClass >= MAX_FILTER_CLASSES) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid input filter");
+        return false;
+    }
+    beginChange();
+    initializeFilters();
+    uint16_t first = filterIndex(source);
+    for (uint16_t i = 0; i < filterInputCount(source); i++) {
+        inputFilters[first + i] = filterClass;
+    }
+    endChange();
+    return true;
 }
 
-/*
-   Input Updates
-*/
-
 /**
- * Updates MCP23017 device state
- * @param device Device index
+ * Gets the filter class of an input
+ * @param source Input source
+ * @param index Input index
+ * @return Class number
  */
-void SimRacingController::updateMcp(uint8_t device) {
-    if (device >= numMcpDevices) return;
-
-    uint16_t currentReading;
-    if (!readMcpPorts(device, currentReading)) {
-        return;
+uint8_t SimRacingController::getInputFilter(InputSource source, int index) const {
+    if (source < 0 || source >= NUM_INPUT_SOURCES || index < 0 ||
+        index >= filterInputCount(source)) {
+        return 0;
     }
+    if (!inputFilters) {
+        return source;
+    }
+    return inputFilters[filterIndex(source) + index];
+}
 
-    for (int pin = 0; pin < 16; pin++) {
-        bool pinState = !(currentReading & (1 << pin));
-        bool lastState = ((lastMcpStates[device] >> pin) & 1);
-        
-        if (pinState != lastState) {
-            mcpDebounceTime[device * 16 + pin] = millis();
-            lastMcpStates[device] = (lastMcpStates[device] & ~(1 << pin)) | (pinState << pin);
-        }
+/**
+ * @return Number of inputs of a source
+ */
+uint16_t SimRacingController::filterInputCount(InputSource source) const {
+    switch (source) {
+        case SOURCE_MATRIX:         return numRows * numCols;
+        case SOURCE_GPIO:           return numGpio;
+        case SOURCE_MCP:            return numMcpDevices * 16;
+        case SOURCE_ENCODER_BUTTON: return numEncoders;
+        case SOURCE_ENCODER:        return numEncoders;
+        default:                    return 0;
+    }
+}
 
-        if ((millis() - mcpDebounceTime[device * 16 + pin]) > matrixDebounceDelay) {
-            if (pinState != ((mcpStates[device] >> pin) & 1)) {
-                mcpStates[device] = (mcpStates[device] & ~(1 << pin)) | (pinState << pin);
-                processMcpChange(device, pin, pinState);
-            }
-        }
+/**
+ * @return Index of the first input of a source (NUM_INPUT_SOURCES: input count)
+ */
+uint16_t SimRacingController::filterIndex(InputSource source) const {
+    uint16_t index = 0;
+    for (int s = SOURCE_MATRIX; s < source; s++) {
+        index += filterInputCount((InputSource)s);
     }
+    return index;
 }
 
 /**
- * Processes MCP input changes
- * @param device Device index
- * @param pin Pin number
- * @param state New state
+ * Allocates filter assignments, every input starts in the class of its source
  */
-void SimRacingController::processMcpChange(uint8_t device, int pin, bool state) {
-    if (onMcpChange) {
-        onMcpChange(currentProfile, device, pin, state);
+void SimRacingController::initializeFilters() {
+    uint16_t count = filterIndex(NUM_INPUT_SOURCES);
+    if (inputFilters && numFilterInputs == count) return;
+
+    delete[] inputFilters;
+    delete[] inputDebounce;
+    delete[] bounceStats;
+    inputDebounce = nullptr;
+    bounceStats = nullptr;
+    inputFilters = new uint8_t[count];
+    numFilterInputs = count;
+
+    for (int s = SOURCE_MATRIX; s < NUM_INPUT_SOURCES; s++) {
+        uint16_t first = filterIndex((InputSource)s);
+        for (uint16_t i = 0; i < filterInputCount((InputSource)s); i++) {
+            inputFilters[first + i] = s;
+        }
     }
 }
 
 /**
- * Updates encoder state
- * @param index Encoder index
+ * Discards filter assignments and debounce times after an input configuration change
  */
-void SimRacingController::updateEncoder(int index) {
-    if (index < 0 || index >= numEncoders) return;
+void SimRacingController::resetFilters() {
+    delete[] inputFilters;
+    delete[] inputDebounce;
+    delete[] bounceStats;
+    inputFilters = nullptr;
+    inputDebounce = nullptr;
+    bounceStats = nullptr;
+    numFilterInputs = 0;
+}
 
-    EncoderConfig& enc = encoders[index];
-    unsigned long currentTime = millis();
+/**
+ * Selects the filter table of the current profile
+ */
+void SimRacingController::selectFilterTable() {
+    activeFilters = defaultFilters;
+    if (profileFilters && currentProfile < numProfiles && profileFilters[currentProfile]) {
+        activeFilters = profileFilters[currentProfile];
+    }
+}
 
-    // Handle encoder button if configured
-    if (enc.pinBtn >= 0) {
-        bool currentBtnState = (digitalRead(enc.pinBtn) == LOW);
-        if (currentBtnState != enc.lastBtnState) {
-            enc.lastBtnTime = currentTime;
-        }
+/*
+   Debounce Learning
+*/
 
-        if ((currentTime - enc.lastBtnTime) > matrixDebounceDelay) {
-            if (currentBtnState != enc.btnState) {
-                enc.btnState = currentBtnState;
-                if (onEncoderButtonChange) {
-                    onEncoderButtonChange(currentProfile, index, currentBtnState);
-                }
-            }
-        }
-        enc.lastBtnState = currentBtnState;
+/**
+ * Starts measuring the bounce of every button
+ * A burst of edges (each within maxMs of the previous one) is one bounce
+ * sample, closed by the next edge after a quiet gap. A streaming estimate
+ * follows the given percentile of each button's samples; after
+ * DEBOUNCE_LEARN_SAMPLES samples the button's debounce time becomes that
+ * estimate plus marginMs, kept within minMs and maxMs, and keeps adapting.
+ * Learned times replace the filter class time (the class mode still
+ * applies), are kept by stopDebounceLearning() and saved by saveConfig().
+ * @param minMs Shortest debounce time (ms)
+ * @param maxMs Longest debounce time (ms)
+ * @param marginMs Added to the estimate (ms)
+ * @param percentile Bounce percentile covered (50-99)
+ * @return true if valid bounds, false otherwise
+ */
+bool SimRacingController::startDebounceLearning(uint8_t minMs, uint8_t maxMs, uint8_t marginMs,
+                                                uint8_t percentile) {
+    if (maxMs == 0 || minMs > maxMs || percentile < 50 || percentile > 99) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid debounce learning bounds");
+        return false;
     }
 
-    // Handle encoder rotation
-    if (currentTime - enc.lastTime >= encoderDebounceTime) {
-        uint8_t currentState = (digitalRead(enc.pinA) << 1) | digitalRead(enc.pinB);
-
-        if (currentState != enc.lastState) {
-            enc.lastTime = currentTime;
+    beginChange();
+    learnMinMs = minMs;
+    learnMaxMs = maxMs;
+    learnMarginMs = marginMs;
+    learnPercentile = percentile;
+    learning = true;
+    initializeFilters();
+    prepareLearning();
+    endChange();
+    return true;
+}
 
-            // Calculate rotation speed
-            if (enc.lastChangeTime > 0) {
-                unsigned long timeDiff = currentTime - enc.lastChangeTime;
-                if (timeDiff > 0) {
-                    enc.speed = 1000 / timeDiff;
-                }
-            }
-            enc.lastChangeTime = currentTime;
-
-            // Determine rotation direction using state transition
-            bool validTransition = true;
-            if (enc.lastState == 0) {
-                if (currentState == 1) enc.encDir = 1;
-                else if (currentState == 2) enc.encDir = -1;
-                else validTransition = false;
-            }
-            else if (enc.lastState == 1) {
-                if (currentState == 3) enc.encDir = 1;
-                else if (currentState == 0) enc.encDir = -1;
-                else validTransition = false;
-            }
-            else if (enc.lastState == 2) {
-                if (currentState == 0) enc.encDir = 1;
-                else if (currentState == 3) enc.encDir = -1;
-                else validTransition = false;
-            }
-            else if (enc.lastState == 3) {
-                if (currentState == 2) enc.encDir = 1;
-                else if (currentState == 1) enc.encDir = -1;
-                else validTransition = false;
-            }
+/**
+ * Stops measuring; learned debounce times stay in use
+ */
+void SimRacingController::stopDebounceLearning() {
+    beginChange();
+    learning = false;
+    delete[] bounceStats;
+    bounceStats = nullptr;
+    endChange();
+}
 
-            if (!validTransition) {
-                enc.errorCount++;
-            }
+/**
+ * @return true while bounce times are measured
+ */
+bool SimRacingController::isDebounceLearning() const {
+    return learning;
+}
 
-            // Process complete state transition
-            if (enc.encDir != 0) {
-                if ((enc.lastState == 3 && currentState == 2 && enc.encDir == 1) ||
-                    (enc.lastState == 3 && currentState == 1 && enc.encDir == -1)) {
-                    enc.position += ((enc.encDir * 4) / enc.divisor);
-                    enc.lastDirection = enc.encDir;
-                    enc.valid = (enc.errorCount < MAX_ERROR_COUNT);
+/**
+ * Allocates the learning state for the configured buttons
+ */
+void SimRacingController::prepareLearning() {
+    uint16_t count = filterIndex(SOURCE_ENCODER);
+    if (!learning || bounceStats || !inputFilters || count == 0) return;
 
-                    if (onEncoderChange) {
-                        onEncoderChange(currentProfile, index, enc.encDir);
-                    }
+    bounceStats = new BounceStats[count]();
+    if (!inputDebounce) {
+        inputDebounce = new uint8_t[count]();
+    }
+}
 
-                    enc.encDir = 0;
-                }
+/**
+ * Accounts one raw edge of a button
+ * A burst starts with the edge to a new level and ends when the input
+ * rests: after a gap longer than learnMaxMs, or with an edge away from
+ * the new level once that level was held for the debounce time (a quick
+ * release). Only edges back to the new level extend the bounce time, so
+ * the time a button is held is never part of a sample.
+ * @param input Button index (filter input index)
+ * @param reading Raw level after the edge
+ * @param settleMs Debounce time in use for the button (ms)
+ * @param now Edge time (ms)
+ */
+void SimRacingController::learnBounce(uint16_t input, bool reading, unsigned long settleMs,
+                                      unsigned long now) {
+    BounceStats& stats = bounceStats[input];
+    uint16_t time = (uint16_t)now;
+    uint16_t gap = time - stats.lastEdge;
+
+    if (stats.open) {
+        // An edge away from the new level ends a hold since the last edge
+        unsigned long holdMs = settleMs > learnMinMs ? settleMs : learnMinMs;
+        bool settled = reading != stats.level && gap >= holdMs;
+        if (gap <= learnMaxMs && !settled) {
+            if (reading == stats.level) {
+                uint16_t bounceMs = time - stats.burstStart;
+                stats.bounceMs = bounceMs > 255 ? 255 : bounceMs;
             }
-
-            enc.lastState = currentState;
+            stats.lastEdge = time;      // Still bouncing
+            return;
         }
 
-        // Reset speed if no changes
-        if (currentTime - enc.lastChangeTime > 1000) {
-            enc.speed = 0;
+        // Input rested: the open burst is one sample. The estimate moves up
+        // by p and down by 100 - p units, so it settles where p percent
+        // of the samples are below it.
+        uint16_t sample = (uint16_t)stats.bounceMs << 6;
+        uint16_t up = learnPercentile * 2;
+        uint16_t down = (100 - learnPercentile) * 2;
+        if (stats.samples == 0) {
+            stats.estimate = sample;
+        } else if (sample > stats.estimate) {
+            stats.estimate = sample - stats.estimate > up ? stats.estimate + up : sample;
+        } else {
+            stats.estimate = stats.estimate - sample > down ? stats.estimate - down : sample;
+        }
+        if (stats.samples < 255) {
+            stats.samples++;
         }
 
-        // Check for encoder malfunction
-        if (enc.errorCount >= MAX_ERROR_COUNT && !enc.errorReported) {
-            lastError = ControllerError(ControllerError::ENCODER_MALFUNCTION, 
-                "Excessive encoder errors detected");
-            if (errorCallback) {
-                errorCallback(lastError);
-                enc.errorReported = true;
-            }
+        if (stats.samples >= DEBOUNCE_LEARN_SAMPLES) {
+            uint16_t ms = ((stats.estimate + 63) >> 6) + learnMarginMs;
+            inputDebounce[input] = ms < learnMinMs ? learnMinMs : (ms > learnMaxMs ? learnMaxMs : ms);
         }
     }
+
+    stats.open = true;
+    stats.level = reading;
+    stats.bounceMs = 0;
+    stats.burstStart = time;
+    stats.lastEdge = time;
 }
 
 /**
- * Processes matrix button changes
- * @param row Row index
- * @param col Column index
- * @param state New state
+ * Gets the own debounce time of a button
+ * @param source SOURCE_MATRIX, SOURCE_GPIO, SOURCE_MCP or SOURCE_ENCODER_BUTTON
+ * @param index Input index
+ * @return Debounce time (ms), 0 = filter class time
  */
-void SimRacingController::processMatrixPress(int row, int col, bool state) {
-    if (onMatrixChange) {
-        onMatrixChange(currentProfile, row, col, state);
+uint8_t SimRacingController::getInputDebounce(InputSource source, int index) const {
+    if (source < 0 || source >= SOURCE_ENCODER || index < 0 ||
+        index >= filterInputCount(source) || !inputDebounce) {
+        return 0;
     }
+    return inputDebounce[filterIndex(source) + index];
 }
 
-/*
-   Configuration Methods
-*/
-
 /**
- * Sets number of available profiles
- * @param numProfiles Number of profiles
+ * Gives a button its own debounce time (e.g. a learned time saved earlier)
+ * @param source SOURCE_MATRIX, SOURCE_GPIO, SOURCE_MCP or SOURCE_ENCODER_BUTTON
+ * @param index Input index
+ * @param ms Debounce time (ms), 0 = filter class time
+ * @return true if successful, false on invalid input
  */
-void SimRacingController::setProfiles(int numProfiles) {
-    const_cast<int&>(this->numProfiles) = numProfiles;
+bool SimRacingController::setInputDebounce(InputSource source, int index, uint8_t ms) {
+    if (source < 0 || source >= SOURCE_ENCODER || index < 0 || index >= filterInputCount(source)) {
+        lastError = ControllerError(ControllerError::INVALID_CONFIG, "Invalid input debounce");
+        return false;
+    }
+
+    beginChange();
+    initializeFilters();
+    if (!inputDebounce) {
+        inputDebounce = new uint8_t[filterIndex(SOURCE_ENCODER)]();
+    }
+    inputDebounce[filterIndex(source) + index] = ms;
+    endChange();
+    return true;
 }
 
 /**
- * Sets debounce times
- * @param matrixDebounce Debounce time for matrix/GPIO/MCP (ms)
- * @param encoderDebounce Debounce time for encoders (ms)
+ * Returns every button to its filter class time
+ * Learning, if running, starts over.
  */
-void SimRacingController::setDebounceTime(unsigned long matrixDebounce,
-    unsigned long encoderDebounce) {
-    const_cast<unsigned long&>(matrixDebounceDelay) = matrixDebounce;
-    const_cast<unsigned long&>(encoderDebounceTime) = encoderDebounce;
+void SimRacingController::clearInputDebounce() {
+    beginChange();
+    delete[] inputDebounce;
+    delete[] bounceStats;
+    inputDebounce = nullptr;
+    bounceStats = nullptr;
+    prepareLearning();
+    endChange();
 }
 
 /**
@@ -951,7 +3796,9 @@ void SimRacingController::setDebounceTime(unsigned long matrixDebounce,
  */
 void SimRacingController::setEncoderDivisor(int encoderIndex, int32_t divisor) {
     if (encoderIndex >= 0 && encoderIndex < numEncoders && divisor > 0 && divisor <= 4) {
+        beginChange();
         encoders[encoderIndex].divisor = divisor;
+        endChange();
     }
 }
 
@@ -962,17 +3809,44 @@ void SimRacingController::setEncoderDivisor(int encoderIndex, int32_t divisor) {
  */
 void SimRacingController::setEncoderPosition(int encoderIndex, int32_t position) {
     if (encoderIndex >= 0 && encoderIndex < numEncoders) {
+        beginChange();
         encoders[encoderIndex].position = position;
+        if (publishedEncoders) {
+            publishState();
+        }
+        endChange();
     }
 }
 
+/**
+ * Gets encoder resolution divisor
+ * @param encoderIndex Index of encoder
+ * @return Divisor (0 if invalid index)
+ */
+int32_t SimRacingController::getEncoderDivisor(int encoderIndex) const {
+    if (encoderIndex >= 0 && encoderIndex < numEncoders) {
+        return encoders[encoderIndex].divisor;
+    }
+    return 0;
+}
+
+/**
+ * @return Number of configured encoders
+ */
+int SimRacingController::getNumEncoders() const {
+    return numEncoders;
+}
+
 /**
  * Sets active profile
  * @param profile Profile number
  */
 void SimRacingController::setProfile(int profile) {
     if (profile >= 0 && profile < numProfiles) {
+        beginChange();
         currentProfile = profile;
+        selectFilterTable();
+        endChange();
     }
 }
 
@@ -985,7 +3859,7 @@ void SimRacingController::setProfile(int profile) {
  * @param callback Callback function
  */
 void SimRacingController::setMatrixCallback(MatrixCallback callback) {
-    onMatrixChange = callback;
+    onMatrixChange.set(callback);
 }
 
 /**
@@ -993,7 +3867,7 @@ void SimRacingController::setMatrixCallback(MatrixCallback callback) {
  * @param callback Callback function
  */
 void SimRacingController::setGpioCallback(GpioCallback callback) {
-    onGpioChange = callback;
+    onGpioChange.set(callback);
 }
 
 /**
@@ -1001,7 +3875,7 @@ void SimRacingController::setGpioCallback(GpioCallback callback) {
  * @param callback Callback function
  */
 void SimRacingController::setEncoderCallback(EncoderCallback callback) {
-    onEncoderChange = callback;
+    onEncoderChange.set(callback);
 }
 
 /**
@@ -1009,7 +3883,7 @@ void SimRacingController::setEncoderCallback(EncoderCallback callback) {
  * @param callback Callback function
  */
 void SimRacingController::setEncoderButtonCallback(EncoderButtonCallback callback) {
-    onEncoderButtonChange = callback;
+    onEncoderButtonChange.set(callback);
 }
 
 /**
@@ -1017,7 +3891,23 @@ void SimRacingController::setEncoderButtonCallback(EncoderButtonCallback callbac
  * @param callback Callback function
  */
 void SimRacingController::setMcpCallback(McpCallback callback) {
-    onMcpChange = callback;
+    onMcpChange.set(callback);
+}
+
+/**
+ * Sets analog axis change callback
+ * @param callback Callback function
+ */
+void SimRacingController::setAnalogCallback(AnalogCallback callback) {
+    onAnalogChange.set(callback);
+}
+
+/**
+ * Sets ladder switch position callback
+ * @param callback Callback function
+ */
+void SimRacingController::setSwitchCallback(SwitchCallback callback) {
+    onSwitchChange.set(callback);
 }
 
 /**
@@ -1025,7 +3915,80 @@ void SimRacingController::setMcpCallback(McpCallback callback) {
  * @param callback Callback function
  */
 void SimRacingController::setErrorCallback(bool (*callback)(const ControllerError&)) {
-    errorCallback = callback;
+    errorCallback.set(callback);
+}
+
+/**
+ * Sets matrix change callback with a context
+ * @param callback Callback function, called with context first
+ * @param context Passed to the callback (sketch owned)
+ */
+void SimRacingController::setMatrixCallback(MatrixContextCallback callback, void* context) {
+    onMatrixChange.set(callback, context);
+}
+
+/**
+ * Sets GPIO change callback with a context
+ * @param callback Callback function, called with context first
+ * @param context Passed to the callback (sketch owned)
+ */
+void SimRacingController::setGpioCallback(GpioContextCallback callback, void* context) {
+    onGpioChange.set(callback, context);
+}
+
+/**
+ * Sets encoder change callback with a context
+ * @param callback Callback function, called with context first
+ * @param context Passed to the callback (sketch owned)
+ */
+void SimRacingController::setEncoderCallback(EncoderContextCallback callback, void* context) {
+    onEncoderChange.set(callback, context);
+}
+
+/**
+ * Sets encoder button callback with a context
+ * @param callback Callback function, called with context first
+ * @param context Passed to the callback (sketch owned)
+ */
+void SimRacingController::setEncoderButtonCallback(EncoderButtonContextCallback callback, void* context) {
+    onEncoderButtonChange.set(callback, context);
+}
+
+/**
+ * Sets MCP change callback with a context
+ * @param callback Callback function, called with context first
+ * @param context Passed to the callback (sketch owned)
+ */
+void SimRacingController::setMcpCallback(McpContextCallback callback, void* context) {
+    onMcpChange.set(callback, context);
+}
+
+/**
+ * Sets analog axis change callback with a context
+ * @param callback Callback function, called with context first
+ * @param context Passed to the callback (sketch owned)
+ */
+void SimRacingController::setAnalogCallback(AnalogContextCallback callback, void* context) {
+    onAnalogChange.set(callback, context);
+}
+
+/**
+ * Sets ladder switch position callback with a context
+ * @param callback Callback function, called with context first
+ * @param context Passed to the callback (sketch owned)
+ */
+void SimRacingController::setSwitchCallback(SwitchContextCallback callback, void* context) {
+    onSwitchChange.set(callback, context);
+}
+
+/**
+ * Sets error callback with a context
+ * @param callback Callback function, called with context first
+ * @param context Passed to the callback (sketch owned)
+ */
+void SimRacingController::setErrorCallback(bool (*callback)(void* context, const ControllerError&),
+                                           void* context) {
+    errorCallback.set(callback, context);
 }
 
 /*
@@ -1043,7 +4006,7 @@ bool SimRacingController::isInPowerSave() const {
  * @return true if update in progress
  */
 bool SimRacingController::isUpdateInProgress() const {
-    return isUpdating;
+    return scanLock.isLocked();
 }
 
 /**
@@ -1053,6 +4016,13 @@ int SimRacingController::getProfile() const {
     return currentProfile;
 }
 
+/**
+ * @return Number of available profiles
+ */
+int SimRacingController::getNumProfiles() const {
+    return numProfiles;
+}
+
 /**
  * Gets matrix button state
  * @param row Row index
@@ -1060,8 +4030,8 @@ int SimRacingController::getProfile() const {
  * @return true if button pressed
  */
 bool SimRacingController::getMatrixState(int row, int col) const {
-    if (row >= 0 && row < numRows && col >= 0 && col < numCols) {
-        return matrixStates[row][col];
+    if (publishedWords && row >= 0 && row < numRows && col >= 0 && col < numCols) {
+        return (readPublishedWord(row) >> col) & 1;
     }
     return false;
 }
@@ -1072,8 +4042,8 @@ bool SimRacingController::getMatrixState(int row, int col) const {
  * @return true if button pressed
  */
 bool SimRacingController::getGpioState(int gpio) const {
-    if (gpio >= 0 && gpio < numGpio) {
-        return gpioStates[gpio];
+    if (publishedWords && gpio >= 0 && gpio < numGpio) {
+        return (readPublishedWord(frameGpioBase + gpio / 32) >> (gpio % 32)) & 1;
     }
     return false;
 }
@@ -1085,8 +4055,50 @@ bool SimRacingController::getGpioState(int gpio) const {
  * @return true if pin active
  */
 bool SimRacingController::getMcpState(uint8_t device, uint8_t pin) const {
-    if (device >= numMcpDevices || pin >= 16) return false;
-    return (mcpStates[device] & (1 << pin)) != 0;
+    if (!publishedWords || device >= numMcpDevices || pin >= 16) return false;
+    return (readPublishedWord(frameMcpBase + device) >> pin) & 1;
+}
+
+/**
+ * Copies a consistent view of all debounced states and encoder positions
+ * Safe from another core or task while the scan runs, never blocks it.
+ * @param words Buffer for getFrameSize() words (bit set = active)
+ * @param positions Buffer for one position per encoder (nullptr to skip)
+ * @return false before begin()
+ */
+bool SimRacingController::readState(uint32_t* words, int32_t* positions) const {
+    if (!publishedWords) return false;
+
+    uint32_t seq;
+    do {
+        seq = stateSeq.beginRead();
+        for (uint8_t w = 0; w < frameSize; w++) {
+            words[w] = publishedWords[w];
+        }
+        for (int i = 0; positions && i < numEncoders; i++) {
+            positions[i] = publishedEncoders[i].position;
+        }
+    } while (stateSeq.retry(seq));
+    return true;
+}
+
+/**
+ * Checks if an MCP device answers on the bus
+ * @param device MCP device index
+ * @return true if online
+ */
+bool SimRacingController::isMcpOnline(uint8_t device) const {
+    return device < numMcpDevices && mcpInitialized && mcpHealth[device].online;
+}
+
+/**
+ * Gets the link state of an MCP device
+ * @param device MCP device index
+ * @return Link state (default values for an invalid device)
+ */
+McpHealth SimRacingController::getMcpHealth(uint8_t device) const {
+    if (device >= numMcpDevices) return McpHealth();
+    return mcpHealth[device];
 }
 
 /**
@@ -1095,8 +4107,8 @@ bool SimRacingController::getMcpState(uint8_t device, uint8_t pin) const {
  * @return Current position value
  */
 int32_t SimRacingController::getEncoderPosition(int index) const {
-    if (index >= 0 && index < numEncoders) {
-        return encoders[index].position;
+    if (publishedEncoders && index >= 0 && index < numEncoders) {
+        return readPublishedEncoder(index).position;
     }
     return 0;
 }
@@ -1107,8 +4119,8 @@ int32_t SimRacingController::getEncoderPosition(int index) const {
  * @return Last direction (-1: CCW, 0: none, 1: CW)
  */
 int8_t SimRacingController::getEncoderDirection(int index) const {
-    if (index >= 0 && index < numEncoders) {
-        return encoders[index].lastDirection;
+    if (publishedEncoders && index >= 0 && index < numEncoders) {
+        return readPublishedEncoder(index).direction;
     }
     return 0;
 }
@@ -1119,8 +4131,8 @@ int8_t SimRacingController::getEncoderDirection(int index) const {
  * @return Current speed in steps per second
  */
 uint16_t SimRacingController::getEncoderSpeed(int index) const {
-    if (index >= 0 && index < numEncoders) {
-        return encoders[index].speed;
+    if (publishedEncoders && index >= 0 && index < numEncoders) {
+        return readPublishedEncoder(index).speed;
     }
     return 0;
 }
@@ -1132,23 +4144,84 @@ uint16_t SimRacingController::getEncoderSpeed(int index) const {
  */
 bool SimRacingController::isEncoderValid(int index) const {
     if (index >= 0 && index < numEncoders) {
-        return encoders[index].valid;
+        return publishedEncoders ? readPublishedEncoder(index).valid : encoders[index].valid;
     }
     return false;
 }
 
+/**
+ * Gets the encoder error rate
+ * Invalid transitions (both pins changed at once) per ENCODER_ERROR_WINDOW_MS,
+ * halved each window without new errors.
+ * @param index Encoder index
+ * @return Error rate (0 if invalid index)
+ */
+uint16_t SimRacingController::getEncoderErrorRate(int index) const {
+    if (index >= 0 && index < numEncoders) {
+        uint16_t rate = publishedEncoders ? readPublishedEncoder(index).errorRate
+                                          : encoders[index].errorRate;
+        return (rate + 8) >> 4;
+    }
+    return 0;
+}
+
 /**
  * Gets encoder button state
  * @param index Encoder index
  * @return true if button pressed, false if not or not configured
  */
 bool SimRacingController::getEncoderButtonState(int index) const {
-    if (index >= 0 && index < numEncoders && encoders[index].pinBtn >= 0) {
-        return encoders[index].btnState;
+    if (publishedWords && index >= 0 && index < numEncoders && encoders[index].pinBtn >= 0) {
+        return (readPublishedWord(frameButtonBase + index / 32) >> (index % 32)) & 1;
     }
     return false;
 }
 
+/**
+ * Gets the reported value of an analog axis
+ * @param axis Axis index
+ * @return Value 0..ANALOG_MAX (0 before the first reading)
+ */
+uint16_t SimRacingController::getAnalogValue(uint8_t axis) const {
+    if (!publishedAnalog || axis >= numAnalogAxes) return 0;
+
+    uint32_t seq;
+    uint16_t value;
+    do {
+        seq = stateSeq.beginRead();
+        value = publishedAnalog[axis];
+    } while (stateSeq.retry(seq));
+    return value;
+}
+
+/**
+ * Gets the last decimated reading of an analog axis, before filtering and
+ * calibration (read from the context that runs the scan)
+ * @param axis Axis index
+ * @return Reading in ADC units
+ */
+uint16_t SimRacingController::getAnalogReading(uint8_t axis) const {
+    if (axis >= numAnalogAxes) return 0;
+    return analogAxes[axis].getReading();
+}
+
+/**
+ * Gets the position of a ladder switch
+ * @param sw Switch index
+ * @return Position (0 = first configured level), LADDER_NONE if unknown
+ */
+uint8_t SimRacingController::getSwitchPosition(uint8_t sw) const {
+    if (!publishedSwitches || sw >= numLadders) return LADDER_NONE;
+
+    uint32_t seq;
+    uint8_t position;
+    do {
+        seq = stateSeq.beginRead();
+        position = publishedSwitches[sw];
+    } while (stateSeq.retry(seq));
+    return position;
+}
+
 /**
  * Gets last error
  * @return Last error structure
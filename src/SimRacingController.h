@@ -10,8 +10,29 @@
 
 #include <Arduino.h>
 #include <Wire.h>
+#include "DeadlineQueue.h"
+#include "ScanSync.h"
+#include "EventQueue.h"
+#include "AnalogAxis.h"
+#include "LadderSwitch.h"
+#include "ConfigStore.h"
+#include "Callback.h"
+
+// Background scan task: FreeRTOS task on ESP32, std::thread on host builds
+#if defined(ARDUINO_ARCH_ESP32)
+#define SCAN_TASK_FREERTOS
+#elif !defined(ARDUINO)
+#define SCAN_TASK_THREAD
+#include <thread>
+#endif
+
+// Encoder pins read through their port input registers where the core maps pins to ports
+#if defined(portInputRegister) && defined(digitalPinToPort) && defined(digitalPinToBitMask)
+#define ENCODER_PORT_READS
+typedef decltype(portInputRegister(digitalPinToPort(0))) PortRegister;
+#endif
 
-// MCP23017 registers (using sequential mode)
+// MCP23017 registers (IOCON.BANK = 0, sequential mode)
 #define MCP23017_IODIRA     0x00   // IO direction A
 #define MCP23017_IODIRB     0x01   // IO direction B
 #define MCP23017_IPOLA      0x02   // Input polarity A
@@ -34,10 +55,30 @@
 #define MCP23017_GPIOB      0x13   // Port B
 
 // System constants and limits
-#define I2C_TIMEOUT_MS      100    // I2C operation timeout
+#define I2C_TIMEOUT_US      2000   // I2C operation timeout (us)
+#define MIN_I2C_CLOCK_HZ    100000 // Standard mode
+#if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_RP2040) || defined(ARDUINO_ARCH_SAMD)
+#define MAX_I2C_CLOCK_HZ    1000000 // Fast-mode Plus
+#else
+#define MAX_I2C_CLOCK_HZ    400000 // Fast mode
+#endif
 #define MIN_POWER_SAVE_MS   5000   // Minimum power save timeout
 #define MAX_POWER_SAVE_MS   3600000 // Maximum power save timeout (1 hour)
-#define MAX_ERROR_COUNT     100    // Maximum encoder error count before error
+#define ENCODER_ERROR_WINDOW_MS 1000 // Half-life of the encoder error rate
+#define ENCODER_ERROR_LIMIT 20     // Error rate (errors per window) marking an encoder invalid
+#define MAX_MATRIX_COLS     32     // Matrix columns per row (one frame word)
+#define MAX_INPUT_FRAME_WORDS 255  // Words per input frame (rows, GPIO, MCP and encoder words)
+#define MAX_FILTER_CLASSES  8      // Debounce filter classes per table
+#define MCP_FAIL_LIMIT      3      // Consecutive failed reads before a device goes offline
+#define MCP_RETRY_MIN_MS    20     // First re-probe of an offline device
+#define MCP_RETRY_MAX_MS    5000   // Longest re-probe interval
+#define I2C_FAULT_BUS       0x00   // Fault hook address of a bus check (SDA level)
+#define MAX_SCAN_RATE_TIERS 4      // Idle scan rate tiers below full rate
+#define DEBOUNCE_LEARN_SAMPLES 8   // Bounces measured before a learned debounce time applies
+
+class InputRecorder;
+class GestureEngine;
+class TelemetryWriter;
 
 /**
  * Error reporting structure
@@ -62,6 +103,112 @@ struct ControllerError {
         code(c), message(msg) {}
 };
 
+/**
+ * Debounce modes
+ * Deferred reports a change once the input has been stable for the
+ * debounce time. Eager reports the first edge at once and then ignores
+ * the input for the debounce time (lockout).
+ */
+enum DebounceMode {
+    DEBOUNCE_DEFERRED = 0,      // Report after stable period (default)
+    DEBOUNCE_EAGER = 1,         // Report first edge, then lock out
+    DEBOUNCE_EAGER_PRESS = 2    // Eager press, deferred release
+};
+
+/**
+ * Input sources
+ * Each source starts in the filter class with the same number
+ */
+enum InputSource {
+    SOURCE_MATRIX = 0,
+    SOURCE_GPIO = 1,
+    SOURCE_MCP = 2,
+    SOURCE_ENCODER_BUTTON = 3,
+    SOURCE_ENCODER = 4,         // Encoder rotation (debounceMs = glitch filter)
+    NUM_INPUT_SOURCES = 5,      // Sources with debounce filter classes
+    SOURCE_ANALOG = 5,          // Analog axes (filtered by their AnalogAxisConfig)
+    SOURCE_SWITCH = 6           // Resistor ladder switches (value = position)
+};
+
+/**
+ * Frame kinds (see processFrame() and InputRecorder.h)
+ * A scan samples the encoders first and debounces the button words once
+ * its last word was read. With a scan budget or an encoder sample rate the
+ * encoders are also sampled between words, each sample is its own frame.
+ */
+enum FrameKind {
+    FRAME_SCAN = 0,             // Encoder sample, then the button words
+    FRAME_ENCODERS = 1,         // Encoder sample only
+    FRAME_BUTTONS = 2           // Button words only (encoders not sampled)
+};
+
+/**
+ * Debounce filter class
+ * Every input is assigned to one of MAX_FILTER_CLASSES classes. The
+ * classes form a table, each profile can use its own table.
+ */
+struct FilterClass {
+    unsigned long debounceMs;   // Stable time (deferred) or lockout (eager), glitch filter for encoders
+    DebounceMode mode;          // Debounce mode (not used by encoders)
+
+    FilterClass(unsigned long ms = 50, DebounceMode m = DEBOUNCE_DEFERRED) :
+        debounceMs(ms), mode(m) {}
+};
+
+/**
+ * Scan statistics
+ * Collected by tryUpdate() and processFrame()
+ */
+struct ScanStats {
+    uint32_t scans;          // Completed scans
+    uint32_t events;         // Reported input events (callbacks)
+    uint32_t totalMicros;    // Time spent scanning (us)
+    uint32_t maxMicros;      // Longest scan, or longest slice with a scan budget (us)
+    uint32_t slices;         // Scan slices (update() calls) with a scan budget
+    uint32_t tierMillis[MAX_SCAN_RATE_TIERS + 1];  // Time at full rate, then in each idle tier (ms)
+
+    ScanStats() : scans(0), events(0), totalMicros(0), maxMicros(0), slices(0), tierMillis() {}
+};
+
+/**
+ * Idle scan rate tier (see SimRacingController::setScanRateTiers())
+ */
+struct ScanRateTier {
+    unsigned long idleMs;   // Time without input edges before this tier
+    uint16_t hz;            // Scans per second in this tier
+
+    ScanRateTier(unsigned long idle = 0, uint16_t rate = 0) : idleMs(idle), hz(rate) {}
+};
+
+/**
+ * MCP23017 link state
+ * An offline device is not read, its inputs are released and it is
+ * re-probed with exponential backoff.
+ */
+struct McpHealth {
+    bool online;             // Answering on the bus
+    uint8_t failures;        // Consecutive failed reads
+    uint16_t retryMs;        // Current re-probe interval (ms)
+    uint32_t errors;         // Failed transactions since begin()
+    uint16_t reconnects;     // Successful re-probes since begin()
+    uint16_t busClears;      // Bus clears after a failed read of this device
+
+    McpHealth() : online(true), failures(0), retryMs(MCP_RETRY_MIN_MS), errors(0), reconnects(0),
+                  busClears(0) {}
+};
+
+/**
+ * I2C fault returned by a fault hook (see setI2cFaultHook())
+ * Lets a test sketch drive the MCP23017 link recovery without touching
+ * the wiring.
+ */
+enum I2cFault {
+    I2C_FAULT_NONE = 0,      // Transaction runs on the bus
+    I2C_FAULT_NACK,          // Address not acknowledged
+    I2C_FAULT_TIMEOUT,       // Read data never arrives
+    I2C_FAULT_SDA_LOW        // A slave holds SDA low (bus error, bus clear)
+};
+
 /**
  * Matrix configuration structure
  * Contains pin assignments for button matrix
@@ -93,7 +240,22 @@ struct McpConfig {
 class SimRacingController {
     private:
         // Thread safety
-        volatile bool isUpdating;
+        ScanLock scanLock;          // Held by tryUpdate() and processFrame()
+
+        // Background scan task
+        EventQueue* events;         // Reported changes while the task runs
+        uint8_t taskPeriodMs;       // Scan period of the task
+        uint8_t taskPriority;
+#if defined(SCAN_TASK_FREERTOS)
+        std::atomic<bool> taskRunning;
+        TaskHandle_t volatile taskHandle;   // Cleared by the task when it ends
+#elif defined(SCAN_TASK_THREAD)
+        std::atomic<bool> taskRunning;
+        std::thread* taskThread;
+        std::thread::id taskThreadId;       // Set by the task before its first scan
+#else
+        bool taskRunning;
+#endif
         
         // Power management
         bool isPowerSaving;
@@ -103,7 +265,7 @@ class SimRacingController {
         
         // Error handling
         ControllerError lastError;
-        bool (*errorCallback)(const ControllerError&);
+        Callback<bool, const ControllerError&> errorCallback;
         bool errorReported;         // Flag for preventing duplicate error reports
 
         // Button Matrix
@@ -111,26 +273,119 @@ class SimRacingController {
         const int numCols;
         const int* rowPins;
         const int* colPins;
-        bool** lastMatrixStates;
-        bool** matrixStates;
-        unsigned long** lastMatrixDebounceTime;
-        const unsigned long matrixDebounceDelay;
 
         // Direct GPIO Buttons
         const int* gpioPins;
-        bool* lastGpioStates;
-        bool* gpioStates;
-        unsigned long* gpioDebounceTime;
         const int numGpio;
 
         // MCP23017 support
         static const uint8_t MAX_MCP_DEVICES = 8;  // Maximum number of MCP23017s
         McpConfig* mcpConfigs;      // Array of MCP configurations
         uint8_t numMcpDevices;      // Number of configured MCPs
-        uint16_t* lastMcpStates;    // Last state of MCP inputs
-        uint16_t* mcpStates;        // Current state of MCP inputs
-        unsigned long* mcpDebounceTime; // Debounce timers for MCP inputs
         bool mcpInitialized;        // MCP initialization flag
+        uint32_t i2cClock;          // Bus clock set by begin() (Hz)
+        McpHealth* mcpHealth;       // Link state per device
+        Callback<I2cFault, uint8_t> i2cFaultHook; // Injected faults (tests)
+        uint16_t mcpTimerBase;      // Timer id of the first device re-probe
+        uint8_t ownMcpAddresses;    // Bit per address (0x20-0x27) claimed by begin()
+
+        // I2C bus shared by every instance
+        static ScanLock i2cBus;             // Held for each transaction
+        static uint32_t i2cBusClock;        // Clock set on the bus (0 = not started)
+        static uint8_t claimedMcpAddresses; // Bit per address claimed by any instance
+
+        // Analog axes and resistor ladder switches
+        AnalogAxis* analogAxes;
+        uint8_t numAnalogAxes;
+        LadderSwitch* ladders;
+        uint8_t numLadders;
+        uint8_t analogPeriodMs;     // Time between two readings of every axis and switch
+        uint16_t analogTimer;       // Timer id of the next reading
+        bool analogDue;             // Reading requested by the timer
+
+        // Arrays owned by a loaded configuration blob (see loadConfig()) or live changes
+        int* blobMatrixPins;        // Row pins, then column pins
+        int* blobGpioPins;
+        FilterClass* blobFilterTables; // MAX_FILTER_CLASSES per profile
+        bool changeLocked;          // Scan lock held by beginChange()
+        uint8_t changeDepth;        // Nested beginChange() calls of the application
+        uint16_t* blobLevels;       // MAX_LADDER_POSITIONS per ladder switch
+
+        // Input frame (raw samples of one scan, active = bit set)
+        uint32_t* frameWords;       // Matrix rows, GPIO, MCP ports, encoder A/B, encoder buttons
+        uint8_t frameSize;          // Number of words in a frame
+        uint8_t frameGpioBase;      // Index of first GPIO word
+        uint8_t frameMcpBase;       // Index of first MCP word
+        uint8_t frameEncoderBase;   // Index of first encoder A/B word (2 bits per encoder)
+        uint8_t frameButtonBase;    // Index of first encoder button word
+        InputRecorder* recorder;    // Optional raw input recorder
+        GestureEngine* gestures;    // Optional gesture engine
+        TelemetryWriter* telemetry; // Optional binary telemetry stream
+
+        // Debounce state (one entry per frame word, bit set = active)
+        uint32_t* lastRawWords;     // Samples of the previous scan (encoder words: decoded A/B state)
+        uint32_t* stableWords;      // Debounced states
+        uint32_t* validMasks;       // Bits holding an input
+        uint32_t* waitingWords;     // Pending bits left to the word timer (encoder words: held A/B jumps)
+        uint32_t* activeWords;      // Words released by their timer (bit per frame word)
+        uint16_t* wordInputBase;    // Input index of bit 0 (deadlines and filter classes)
+        unsigned long* inputDeadlines; // Time from which each input may change state
+
+        // Timers: frame words, encoder speed decay, power save, gestures
+        DeadlineQueue timers;
+        uint16_t powerSaveTimer;    // Timer id of the power save timeout
+        uint16_t gestureTimer;      // Timer id of the next gesture deadline
+        bool gestureSync;           // Gesture deadline may have moved
+
+        // Debounce filters
+        FilterClass defaultFilters[MAX_FILTER_CLASSES]; // Table used without a profile table
+        const FilterClass** profileFilters; // Per-profile tables (nullptr = default table)
+        const FilterClass* activeFilters;   // Table of the current profile
+        uint8_t* inputFilters;      // Filter class per input: matrix, GPIO, MCP, encoder buttons, encoders
+        uint16_t numFilterInputs;   // Entries in inputFilters
+
+        // Debounce learning (see startDebounceLearning())
+        struct BounceStats {
+            uint16_t burstStart;    // First edge of the open burst (ms, low 16 bits)
+            uint16_t lastEdge;      // Last edge of the open burst (ms, low 16 bits)
+            uint16_t estimate;      // Bounce time percentile estimate (1/64 ms)
+            uint8_t samples;        // Measured bursts (saturating)
+            uint8_t bounceMs;       // Last return to the new level (ms after burstStart)
+            bool level;             // New level of the open burst
+            bool open;              // Burst in progress
+        };
+        uint8_t* inputDebounce;     // Debounce time per button (ms, 0 = filter class), nullptr = none
+        BounceStats* bounceStats;   // Per button while learning
+        bool learning;
+        uint8_t learnMinMs;
+        uint8_t learnMaxMs;         // Also the longest gap between edges of one burst
+        uint8_t learnMarginMs;
+        uint8_t learnPercentile;
+        void prepareLearning();
+        void learnBounce(uint16_t input, bool reading, unsigned long settleMs, unsigned long now);
+
+        // Statistics
+        ScanStats scanStats;
+        void recordScanTime(unsigned long startMicros, bool completed = true);
+
+        // Incremental scan (see setScanBudget())
+        uint16_t scanBudgetUs;      // Time per update() call, 0 = whole scans
+        uint8_t nextScanWord;       // Next frame word read by a slice
+
+        // Sample rates (see setSampleRate()), matrix to encoders
+        uint32_t samplePeriodUs[NUM_INPUT_SOURCES];     // 0 = every update()
+        unsigned long lastSampleMicros[NUM_INPUT_SOURCES];
+        uint8_t scanSources;        // Bit per source read by the current scan
+
+        // Scan rate governor (see setScanRateTiers())
+        ScanRateTier rateTiers[MAX_SCAN_RATE_TIERS];
+        uint8_t numRateTiers;       // 0 = always full rate
+        uint8_t rateTier;           // 0 = full rate, n = rateTiers[n - 1]
+        unsigned long lastEdgeTime; // Last raw input edge, or scan with an input held (ms)
+        unsigned long lastScanMicros;   // Start of the last scan
+        unsigned long tierTime;     // Tier time accounted up to here (ms)
+        bool governScanRate(unsigned long now, unsigned long nowMicros);
+        bool isInputHeld() const;
 
         /**
          * Encoder Configuration Structure
@@ -140,29 +395,43 @@ class SimRacingController {
             int pinA;                  // First encoder pin
             int pinB;                  // Second encoder pin
             int pinBtn;                // Encoder button pin (-1 if not used)
-            uint8_t lastState;         // Previous encoder state
-            int8_t encDir;            // Current rotation direction
+            uint8_t lastState;         // Previous encoder state (filtered A/B levels)
+            int8_t steps;              // Quarter steps since the last detent
+            bool stepReported;         // Step of the current detent reported
+            bool pending;              // A/B jump (both pins changed) held by the glitch filter
+            uint8_t pendingState;      // A/B levels of the held jump
+            unsigned long pendingTime; // First sample of the held jump
             int32_t position;          // Current position
-            unsigned long lastTime;    // Last update time
-            unsigned long lastBtnTime; // Last button state change time
-            bool lastBtnState;         // Previous button state
-            bool btnState;             // Current button state
             int32_t divisor;          // Position increment divisor (1-4)
             int8_t lastDirection;      // Last recorded direction
-            uint32_t errorCount;       // Error counter for validity check
+            uint32_t errorCount;       // Invalid transitions since begin()
+            uint16_t errorRate;        // Decaying errors per window (x16)
+            unsigned long errorTime;   // Last decay of errorRate
             bool valid;                // Encoder validity flag
             uint16_t speed;           // Rotation speed
             unsigned long lastChangeTime; // Last position change time
             bool errorReported;        // Error reporting flag
+            uint8_t portA;             // Port of pinA, pinB and pinBtn (port reads)
+            uint8_t portB;
+            uint8_t portBtn;
+            uint32_t maskA;            // Bit of pinA, pinB and pinBtn in their port
+            uint32_t maskB;
+            uint32_t maskBtn;
 
             EncoderConfig() :
                 pinA(0), pinB(0), pinBtn(-1),
-                lastState(0), encDir(0),
-                position(0), lastTime(0), lastBtnTime(0),
-                lastBtnState(false), btnState(false),
+                lastState(0), steps(0), stepReported(false),
+                pending(false), pendingState(0), pendingTime(0),
+                position(0),
                 divisor(4), lastDirection(0), errorCount(0),
+                errorRate(0), errorTime(0),
                 valid(true), speed(0), lastChangeTime(0),
-                errorReported(false) {}
+                errorReported(false),
+                portA(0), portB(0), portBtn(0),
+                maskA(0), maskB(0), maskBtn(0) {}
+
+            // First quarter step out of the detent, not reported yet
+            bool holdsStep() const { return !stepReported && (steps == 1 || steps == -1); }
         };
 
         /**
@@ -182,31 +451,131 @@ class SimRacingController {
         // Encoder members
         const int numEncoders;
         EncoderConfig* encoders;
-        const unsigned long encoderDebounceTime;
+
+#if defined(ENCODER_PORT_READS)
+        // Input registers holding encoder pins, each read once per sample
+        struct EncoderPort {
+            PortRegister reg;          // Input register
+            uint32_t mask;             // Encoder pins in the register
+            uint32_t levels;           // Masked levels of the last read
+        };
+        EncoderPort* encoderPorts;     // nullptr = digitalRead() per pin
+        uint8_t numEncoderPorts;
+        bool encoderPortsRead;         // frameWords hold the levels of encoderPorts
+#endif
+
+        /**
+         * Published encoder state (see publishState())
+         */
+        struct EncoderSnapshot {
+            int32_t position;
+            uint16_t speed;
+            int8_t direction;
+            bool valid;
+            uint16_t errorRate;
+
+            EncoderSnapshot() : position(0), speed(0), direction(0), valid(true), errorRate(0) {}
+        };
+
+        // Published state: written by the scan, read by the getters (seqlock)
+        SeqCounter stateSeq;
+        uint32_t* publishedWords;   // Debounced states (one per frame word)
+        EncoderSnapshot* publishedEncoders;
+        uint16_t* publishedAnalog;  // Reported value per analog axis
+        uint8_t* publishedSwitches; // Reported position per ladder switch
+        bool stateDirty;            // Scan changed state since the last publication
 
         // Profiles
         int currentProfile;
         const int numProfiles;
 
         // Private methods
-        void initializeArrays();
-        void cleanupArrays();
-        void updateEncoder(int index);
-        void processMatrixPress(int row, int col, bool state);
+        void initializeFrame();
+        void expireTimers(unsigned long now);
+        void publishState();
+        uint32_t readPublishedWord(uint8_t word) const;
+        EncoderSnapshot readPublishedEncoder(int index) const;
+        void resetDeadlines(unsigned long time);
+        void armPowerSave();
+        void readRow(int row);
+        void readGpioWord(uint8_t word);
+        void readMcp(uint8_t device);
+        void readEncoders();
+#if defined(ENCODER_PORT_READS)
+        void prepareEncoderPorts();
+        bool mapEncoderPin(EncoderPort* ports, uint8_t& count, int pin, uint8_t& port, uint32_t& mask);
+        void readEncoderPorts();
+#endif
+        bool sampleEncoders(unsigned long now, bool& activityDetected);
+        bool encodersQuiet(const uint32_t* words) const;
+        bool takeSample(InputSource source, unsigned long nowMicros);
+        void scanInputs(unsigned long now, unsigned long startMicros);
+        void recordFrame(unsigned long now, FrameKind kind);
+        void processInputs(unsigned long now, const uint32_t* words, FrameKind kind);
+        void processEncoders(unsigned long now, const uint32_t* words);
+        void finishInputs(unsigned long now, bool activityDetected);
+        bool debounceWords(uint8_t first, uint8_t end, unsigned long now, const uint32_t* words);
+        bool debounce(bool reading, bool toggled, bool pending, unsigned long& deadline,
+                      const FilterClass& filter, unsigned long now) const;
+        void reportChange(uint8_t word, uint8_t bit, bool state, unsigned long now);
+        void reportEvent(InputSource source, uint16_t index, int16_t value, unsigned long now);
+        void sampleAnalog(unsigned long now);
+        void updateEncoder(int index, unsigned long currentTime, uint8_t currentState,
+                           unsigned long glitchTime);
+        void stepEncoder(int index, int8_t quarterSteps, uint8_t state, unsigned long now);
+        void reportStep(int index, unsigned long now);
+        void countEncoderError(EncoderConfig& enc, unsigned long now);
+        void decayEncoderErrors(EncoderConfig& enc, unsigned long now);
+        bool queueEvent(InputSource source, uint16_t index, int16_t value, unsigned long time);
+        void dispatchEvent(const ControllerEvent& event);
+        void sendTelemetry(unsigned long now);
+        static void scanTaskEntry(void* controller);
+        void runScanTask();
+        bool inScanTask() const;
+        uint16_t filterIndex(InputSource source) const;
+        uint16_t filterInputCount(InputSource source) const;
+        void initializeFilters();
+        void resetFilters();
+        void selectFilterTable();
         void configureMatrix(const MatrixConfig& config);
         void configureEncoders(const EncoderInitConfig& config);
+        static uint16_t frameWordCount(int rows, int gpio, int mcp, int encoders);
+
+        // Layout of a configuration blob while its sections are checked
+        struct BlobLayout {
+            int profiles;
+            int rows;
+            int cols;
+            int gpio;
+            int mcp;
+            int encoders;
+
+            uint16_t buttons() const { return rows * cols + gpio + mcp * 16 + encoders; }
+        };
+        bool loadSection(ConfigCursor& in, uint8_t tag, BlobLayout& layout, bool apply);
         
         // MCP private methods
         bool initializeMcp(uint8_t device);
-        void updateMcp(uint8_t device);
-        void processMcpChange(uint8_t device, int pin, bool state);
         bool writeMcpRegister(uint8_t device, uint8_t reg, uint8_t value);
+        bool writeMcpRegisters(uint8_t device, uint8_t reg, const uint8_t* values, uint8_t count);
         bool readMcpRegister(uint8_t device, uint8_t reg, uint8_t& value);
+        bool readMcpRegisters(uint8_t device, uint8_t reg, uint8_t* values, uint8_t count);
         bool readMcpPorts(uint8_t device, uint16_t& value);
+        bool hasMcpInterrupt(uint8_t device) const;
+        void handleMcpFailure(uint8_t device);
+        void probeMcp(uint8_t device, unsigned long now);
 
         // I2C helper methods
-        bool waitForI2C(unsigned long startTime) const;
+        bool waitForI2C(unsigned long startMicros) const;
         bool checkI2CError(uint8_t error);
+        bool checkI2CFault(uint8_t address);
+        bool isSdaLow();
+        void startI2C();
+        void recoverI2CBus();
+        bool lockI2C();
+        void unlockI2C();
+        bool claimMcpAddresses();
+        void releaseMcpAddresses();
 
     public:
         /**
@@ -226,16 +595,70 @@ class SimRacingController {
         void setEncoders(const int* encoderPinsA, const int* encoderPinsB,
                         const int* encoderBtnPins, int numEncoders);
         bool setMcpDevices(const McpConfig* configs, uint8_t numDevices);
+        bool setI2cClock(uint32_t clockHz);     // Up to MAX_I2C_CLOCK_HZ
+        uint32_t getI2cClock() const;
+        void setI2cFaultHook(I2cFault (*hook)(uint8_t address));  // Tests only
+        void setI2cFaultHook(I2cFault (*hook)(void* context, uint8_t address), void* context);
         void setProfiles(int numProfiles);
         void setDebounceTime(unsigned long matrixDebounce, unsigned long encoderDebounce);
+        void setDebounceMode(InputSource source, DebounceMode mode);
+        DebounceMode getDebounceMode(InputSource source) const;
+
+        /**
+         * Analog Axes (see AnalogAxis.h)
+         * Every axis is read once per period, calibration and curves can
+         * also be changed after begin()
+         */
+        bool setAnalogAxes(const AnalogAxisConfig* configs, uint8_t numAxes);
+        bool setAnalogRate(uint8_t periodMs);
+        bool setAnalogCalibration(uint8_t axis, uint16_t rawMin, uint16_t rawMax);
+        bool setAnalogCurve(uint8_t axis, const uint16_t* points, uint8_t numPoints);
+        bool setLadderSwitches(const LadderSwitchConfig* configs, uint8_t numSwitches);
+
+        /**
+         * Configuration Blob (see ConfigStore.h)
+         * Replaces the configuration calls above
+         */
+        bool loadConfig(ConfigStore& store);
+        bool saveConfig(ConfigStore& store);
+
+        /**
+         * Debounce Filter Classes
+         * Input index: matrix row * numCols + col, MCP device * 16 + pin,
+         * otherwise the GPIO, encoder or encoder button index
+         */
+        bool setFilterClass(uint8_t filterClass, unsigned long debounceMs,
+                            DebounceMode mode = DEBOUNCE_DEFERRED);
+        bool setFilterTable(int profile, const FilterClass* table);
+        bool setInputFilter(InputSource source, int index, uint8_t filterClass);
+        bool setSourceFilter(InputSource source, uint8_t filterClass);
+        uint8_t getInputFilter(InputSource source, int index) const;
+        FilterClass getFilterClass(uint8_t filterClass) const;
+
+        /**
+         * Debounce Learning
+         * Measures the bounce time of every button and gives each its own
+         * debounce time (a percentile plus a margin, within bounds) in
+         * place of its filter class time. Buttons: matrix, GPIO, MCP and
+         * encoder buttons.
+         */
+        bool startDebounceLearning(uint8_t minMs = 1, uint8_t maxMs = 50, uint8_t marginMs = 2,
+                                   uint8_t percentile = 95);
+        void stopDebounceLearning();    // Keeps the learned times
+        bool isDebounceLearning() const;
+        uint8_t getInputDebounce(InputSource source, int index) const;   // 0 = filter class time
+        bool setInputDebounce(InputSource source, int index, uint8_t ms); // Restores a saved time
+        void clearInputDebounce();      // Back to the filter class times
 
         /**
          * Enhanced Configuration Methods
          */
         bool begin();                 // Initialize hardware
+        bool begin(ConfigStore& store); // Load a configuration blob, then initialize
         bool validateConfiguration(); // Validate current configuration
         bool validatePins();         // Validate pin assignments
         void setErrorCallback(bool (*callback)(const ControllerError&));
+        void setErrorCallback(bool (*callback)(void* context, const ControllerError&), void* context);
         ControllerError getLastError() const;
         void clearError();
 
@@ -246,6 +669,73 @@ class SimRacingController {
         bool tryUpdate();        // Non-blocking update
         void waitForUpdate();    // Blocking update
 
+        /**
+         * Raw Input Frames
+         * A frame holds the raw samples of one scan (see InputRecorder.h)
+         */
+        uint8_t getFrameSize() const;
+        const uint32_t* getFrame() const;
+        void setRecorder(InputRecorder* recorder);
+        bool beginReplay(unsigned long time, const uint32_t* words);
+        bool processFrame(unsigned long time, const uint32_t* words, FrameKind kind = FRAME_SCAN);
+
+        /**
+         * Gestures (see GestureEngine.h)
+         */
+        void setGestureEngine(GestureEngine* engine);
+
+        /**
+         * Binary telemetry (see Telemetry.h)
+         */
+        void setTelemetry(TelemetryWriter* writer);
+
+        /**
+         * Background Scan Task (ESP32: FreeRTOS task, host builds: std::thread)
+         * While the task runs, input callbacks are queued and run by
+         * processEvents() in the calling context
+         */
+        bool startScanTask(uint8_t periodMs = 1, uint8_t priority = 2, int8_t core = -1,
+                           uint16_t queueSize = 64);
+        void stopScanTask();
+        bool isScanTaskRunning() const;
+        bool setScanTaskPriority(uint8_t priority);
+        uint16_t processEvents();   // Runs queued callbacks, returns their number
+        bool readEvent(ControllerEvent& event);
+        uint32_t getDroppedEvents() const;
+
+        /**
+         * Scan Statistics
+         */
+        ScanStats getScanStats() const;
+        void resetScanStats();
+
+        /**
+         * Incremental Scan
+         * With a budget each update() reads and decodes the encoders, then
+         * reads matrix rows, GPIO words and MCP devices one at a time until
+         * the budget is spent. Buttons are debounced once all were read.
+         */
+        void setScanBudget(uint16_t budgetUs);  // 0 = whole scan per update() (default)
+        uint16_t getScanBudget() const;
+
+        /**
+         * Sample Rates
+         * Matrix, GPIO, MCP and encoders (with their buttons) are sampled
+         * at their own rate; a source is skipped by update() calls before
+         * its next sample is due. Encoders are served first.
+         */
+        bool setSampleRate(InputSource source, uint16_t hz);   // 0 = every update() (default)
+        uint16_t getSampleRate(InputSource source) const;
+
+        /**
+         * Adaptive Scan Rate
+         * Drops to a lower scan rate after a time without input edges and
+         * returns to full rate on the first edge. Timers keep running at
+         * every update(). Time per tier is in ScanStats::tierMillis.
+         */
+        bool setScanRateTiers(const ScanRateTier* tiers, uint8_t count);   // count 0 = off
+        uint8_t getScanRateTier() const;    // 0 = full rate, n = tiers[n - 1]
+
         /**
          * Power Management Methods
          */
@@ -262,13 +752,27 @@ class SimRacingController {
          * Encoder Configuration
          */
         void setEncoderDivisor(int encoderIndex, int32_t divisor);
+        int32_t getEncoderDivisor(int encoderIndex) const;
         void setEncoderPosition(int encoderIndex, int32_t position);
+        int getNumEncoders() const;
 
         /**
          * Profile Management
          */
         void setProfile(int profile);
         int getProfile() const;
+        int getNumProfiles() const;
+
+        /**
+         * Live Configuration (see ConfigServer.h)
+         * Settings changed between beginChange() and endChange() apply
+         * between two scans, also while the background scan task runs
+         */
+        void beginChange();
+        void endChange();
+        bool setProfileFilterClass(int profile, uint8_t filterClass, unsigned long debounceMs,
+                                   DebounceMode mode = DEBOUNCE_DEFERRED);
+        FilterClass getProfileFilterClass(int profile, uint8_t filterClass) const;
 
         /**
          * State Getters
@@ -279,8 +783,15 @@ class SimRacingController {
         bool getMatrixState(int row, int col) const;
         bool getGpioState(int gpio) const;
         bool getMcpState(uint8_t device, uint8_t pin) const;
+        bool readState(uint32_t* words, int32_t* positions = nullptr) const;
+        bool isMcpOnline(uint8_t device) const;
+        McpHealth getMcpHealth(uint8_t device) const;
         bool isEncoderValid(int index) const;
+        uint16_t getEncoderErrorRate(int index) const;  // Errors per ENCODER_ERROR_WINDOW_MS
         bool getEncoderButtonState(int index) const;
+        uint16_t getAnalogValue(uint8_t axis) const;
+        uint16_t getAnalogReading(uint8_t axis) const;  // Unfiltered, for calibration
+        uint8_t getSwitchPosition(uint8_t sw) const;    // LADDER_NONE before the first reading
 
         /**
          * Callback Types
@@ -290,6 +801,17 @@ class SimRacingController {
         typedef void (*EncoderCallback)(int profile, int encoder, int direction);
         typedef void (*EncoderButtonCallback)(int profile, int encoder, bool pressed);
         typedef void (*McpCallback)(int profile, int device, int pin, bool state);
+        typedef void (*AnalogCallback)(int profile, int axis, uint16_t value);
+        typedef void (*SwitchCallback)(int profile, int sw, uint8_t position);
+
+        // Same callbacks with a context pointer first (see Callback.h)
+        typedef void (*MatrixContextCallback)(void* context, int profile, int row, int col, bool state);
+        typedef void (*GpioContextCallback)(void* context, int profile, int gpio, bool state);
+        typedef void (*EncoderContextCallback)(void* context, int profile, int encoder, int direction);
+        typedef void (*EncoderButtonContextCallback)(void* context, int profile, int encoder, bool pressed);
+        typedef void (*McpContextCallback)(void* context, int profile, int device, int pin, bool state);
+        typedef void (*AnalogContextCallback)(void* context, int profile, int axis, uint16_t value);
+        typedef void (*SwitchContextCallback)(void* context, int profile, int sw, uint8_t position);
 
         /**
          * Callback Setters
@@ -299,14 +821,25 @@ class SimRacingController {
         void setEncoderCallback(EncoderCallback callback);
         void setEncoderButtonCallback(EncoderButtonCallback callback);
         void setMcpCallback(McpCallback callback);
+        void setAnalogCallback(AnalogCallback callback);
+        void setSwitchCallback(SwitchCallback callback);
+        void setMatrixCallback(MatrixContextCallback callback, void* context);
+        void setGpioCallback(GpioContextCallback callback, void* context);
+        void setEncoderCallback(EncoderContextCallback callback, void* context);
+        void setEncoderButtonCallback(EncoderButtonContextCallback callback, void* context);
+        void setMcpCallback(McpContextCallback callback, void* context);
+        void setAnalogCallback(AnalogContextCallback callback, void* context);
+        void setSwitchCallback(SwitchContextCallback callback, void* context);
 
     private:
         // Callback members
-        MatrixCallback onMatrixChange;
-        GpioCallback onGpioChange;
-        EncoderCallback onEncoderChange;
-        EncoderButtonCallback onEncoderButtonChange;
-        McpCallback onMcpChange;
+        Callback<void, int, int, int, bool> onMatrixChange;
+        Callback<void, int, int, bool> onGpioChange;
+        Callback<void, int, int, int> onEncoderChange;
+        Callback<void, int, int, bool> onEncoderButtonChange;
+        Callback<void, int, int, int, bool> onMcpChange;
+        Callback<void, int, int, uint16_t> onAnalogChange;
+        Callback<void, int, int, uint8_t> onSwitchChange;
 };
 
 #endif
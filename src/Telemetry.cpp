@@ -0,0 +1,204 @@
+/**************************
+   Telemetry.cpp
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#include "Telemetry.h"
+#include "SimRacingController.h"
+
+TelemetryWriter::TelemetryWriter(Print& out, bool dropWhenFull) :
+    out(out),
+    dropWhenFull(dropWhenFull),
+    length(0),
+    sequence(0),
+    eventMask(0xFFFF),
+    stateIntervalMs(100),
+    statsIntervalMs(1000),
+    lastState(0),
+    lastStats(0),
+    sentFrames(0),
+    droppedFrames(0) {}
+
+/**
+ * Restarts the periodic frames and announces the stream
+ * @param now Current time (ms)
+ */
+void TelemetryWriter::begin(unsigned long now) {
+    lastState = now;
+    lastStats = now;
+
+    start(TELEMETRY_HELLO);
+    put8(TELEMETRY_VERSION);
+    put32(now);
+    send();
+}
+
+/**
+ * Selects the streamed event sources
+ * @param mask Bit (1 << source) per InputSource, 0 = no EVENT frames
+ */
+void TelemetryWriter::setEventMask(uint16_t mask) {
+    eventMask = mask;
+}
+
+/**
+ * @param ms Time between STATE frames (0 = off, default 100)
+ */
+void TelemetryWriter::setStateInterval(uint16_t ms) {
+    stateIntervalMs = ms;
+}
+
+/**
+ * @param ms Time between STATS frames (0 = off, default 1000)
+ */
+void TelemetryWriter::setStatsInterval(uint16_t ms) {
+    statsIntervalMs = ms;
+}
+
+/*
+   Frame building
+*/
+
+void TelemetryWriter::start(uint8_t type) {
+    length = 0;
+    put8(type);
+    put8(sequence++);
+}
+
+void TelemetryWriter::put8(uint8_t value) {
+    if (length < TELEMETRY_MAX_PAYLOAD) {
+        frame[1 + length++] = value;
+    }
+}
+
+void TelemetryWriter::put16(uint16_t value) {
+    put8(value);
+    put8(value >> 8);
+}
+
+void TelemetryWriter::put32(uint32_t value) {
+    put16(value);
+    put16(value >> 16);
+}
+
+/**
+ * Encodes the frame in place and writes it
+ * @return false if the frame was dropped
+ */
+bool TelemetryWriter::send() {
+    uint8_t size = encodeFrame(frame, length);
+    if (dropWhenFull && out.availableForWrite() < (int)size) {
+        droppedFrames++;
+        return false;
+    }
+    out.write(frame, size);
+    sentFrames++;
+    return true;
+}
+
+/*
+   Frames
+*/
+
+/**
+ * Streams one input event (sources outside the event mask are skipped)
+ * @param event Reported change
+ * @return false if skipped or dropped
+ */
+bool TelemetryWriter::writeEvent(const ControllerEvent& event) {
+    if (!(eventMask & (1U << event.source))) return false;
+
+    start(TELEMETRY_EVENT);
+    put8(event.source);
+    put8(event.profile);
+    put16(event.index);
+    put16(event.value);
+    put32(event.time);
+    return send();
+}
+
+/**
+ * Streams a snapshot of encoder positions, analog values and switch positions
+ * @param time Snapshot time (ms)
+ * @param positions Encoder positions (at most TELEMETRY_MAX_ENCODERS)
+ * @param numEncoders Number of encoders
+ * @param values Analog values (at most MAX_ANALOG_AXES)
+ * @param numAxes Number of analog axes
+ * @param switches Ladder switch positions (at most MAX_LADDER_SWITCHES)
+ * @param numSwitches Number of ladder switches
+ * @return false if dropped
+ */
+bool TelemetryWriter::writeState(unsigned long time, const int32_t* positions, uint8_t numEncoders,
+                                 const uint16_t* values, uint8_t numAxes,
+                                 const uint8_t* switches, uint8_t numSwitches) {
+    lastState = time;
+
+    start(TELEMETRY_STATE);
+    put32(time);
+    put8(numEncoders);
+    for (uint8_t i = 0; i < numEncoders; i++) {
+        put32(positions[i]);
+    }
+    put8(numAxes);
+    for (uint8_t i = 0; i < numAxes; i++) {
+        put16(values[i]);
+    }
+    put8(numSwitches);
+    for (uint8_t i = 0; i < numSwitches; i++) {
+        put8(switches[i]);
+    }
+    return send();
+}
+
+/**
+ * Streams the scan statistics
+ * @param time Current time (ms)
+ * @param stats Scan statistics
+ * @param droppedEvents Events lost by the scan task queue
+ * @return false if dropped
+ */
+bool TelemetryWriter::writeStats(unsigned long time, const ScanStats& stats, uint32_t droppedEvents) {
+    lastStats = time;
+
+    start(TELEMETRY_STATS);
+    put32(time);
+    put32(stats.scans);
+    put32(stats.events);
+    put32(stats.totalMicros);
+    put32(stats.maxMicros);
+    put32(droppedEvents);
+    put32(droppedFrames);
+    return send();
+}
+
+/**
+ * @param now Current time (ms)
+ * @return true if a STATE frame is due
+ */
+bool TelemetryWriter::isStateDue(unsigned long now) const {
+    return stateIntervalMs && now - lastState >= stateIntervalMs;
+}
+
+/**
+ * @param now Current time (ms)
+ * @return true if a STATS frame is due
+ */
+bool TelemetryWriter::isStatsDue(unsigned long now) const {
+    return statsIntervalMs && now - lastStats >= statsIntervalMs;
+}
+
+/**
+ * @return Frames written since construction
+ */
+uint32_t TelemetryWriter::getSentFrames() const {
+    return sentFrames;
+}
+
+/**
+ * @return Frames dropped on a full output buffer
+ */
+uint32_t TelemetryWriter::getDroppedFrames() const {
+    return droppedFrames;
+}
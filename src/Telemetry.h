@@ -0,0 +1,97 @@
+/**************************
+   Telemetry.h
+   v 2.1.0
+   by roncoa@gmail.com
+   29/01/2025
+ **************************/
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <Arduino.h>
+#include "EventQueue.h"
+#include "FrameCodec.h"
+
+struct ScanStats;
+
+/*
+   Binary telemetry
+
+   A TelemetryWriter attached to SimRacingController streams input events,
+   encoder positions, analog values and scan statistics as small binary
+   frames instead of text, so diagnostics can stay on without slowing the
+   scan. extras/telemetry_decode.py prints or records the stream on the host.
+
+   Frame (see FrameCodec.h): type (u8), sequence (u8), body, CRC-16,
+   COBS encoded and terminated by 0x00
+   The sequence counts every frame, dropped ones included, so the decoder
+   sees gaps. Bodies (little endian):
+     HELLO   version, time (u32)
+     EVENT   source, profile, index (u16), value (i16), time (u32)
+     STATE   time (u32), encoders, positions (i32 each), axes, values (u16 each),
+             switches, positions (u8 each)
+     STATS   time (u32), scans, events, scan us, max scan us, dropped events,
+             dropped frames (u32 each)
+*/
+
+#define TELEMETRY_VERSION       1
+#define TELEMETRY_MAX_ENCODERS  16     // Encoders carried by a STATE frame
+#define TELEMETRY_MAX_PAYLOAD   128    // Frame bytes before the CRC and encoding
+
+// Frame types
+#define TELEMETRY_HELLO   0
+#define TELEMETRY_EVENT   1
+#define TELEMETRY_STATE   2
+#define TELEMETRY_STATS   3
+
+class TelemetryWriter {
+    private:
+        Print& out;
+        bool dropWhenFull;          // Drop frames that do not fit in the output buffer
+        uint8_t frame[TELEMETRY_MAX_PAYLOAD + FRAME_OVERHEAD];
+        uint8_t length;             // Payload bytes
+        uint8_t sequence;
+
+        uint16_t eventMask;         // Bit per InputSource
+        uint16_t stateIntervalMs;   // 0 = no STATE frames
+        uint16_t statsIntervalMs;   // 0 = no STATS frames
+        unsigned long lastState;
+        unsigned long lastStats;
+
+        uint32_t sentFrames;
+        uint32_t droppedFrames;
+
+        void start(uint8_t type);
+        void put8(uint8_t value);
+        void put16(uint16_t value);
+        void put32(uint32_t value);
+        bool send();
+
+    public:
+        /**
+         * Constructor
+         * @param out Output (Serial, a file on host builds...)
+         * @param dropWhenFull true to drop frames instead of waiting for
+         *        the output buffer (needs availableForWrite())
+         */
+        TelemetryWriter(Print& out, bool dropWhenFull = true);
+
+        void begin(unsigned long now);      // Called by the controller, sends HELLO
+        void setEventMask(uint16_t mask);   // Bit (1 << source) per streamed source
+        void setStateInterval(uint16_t ms); // Encoder/analog/switch snapshot period (0 = off)
+        void setStatsInterval(uint16_t ms); // Scan statistics period (0 = off)
+
+        bool writeEvent(const ControllerEvent& event);
+        bool writeState(unsigned long time, const int32_t* positions, uint8_t numEncoders,
+                        const uint16_t* values, uint8_t numAxes,
+                        const uint8_t* switches, uint8_t numSwitches);
+        bool writeStats(unsigned long time, const ScanStats& stats, uint32_t droppedEvents);
+
+        bool isStateDue(unsigned long now) const;
+        bool isStatsDue(unsigned long now) const;
+
+        uint32_t getSentFrames() const;
+        uint32_t getDroppedFrames() const;
+};
+
+#endif